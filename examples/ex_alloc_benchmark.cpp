@@ -0,0 +1,104 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// count every heap allocation made by the process so the update path can be checked for them
+static std::atomic<size_t> g_allocations(0);
+
+// every replaced form goes through the same pair, so whichever delete frees a block matches its new
+static void* counted_alloc(std::size_t size) {
+    g_allocations++;
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+static void counted_free(void* ptr) noexcept { std::free(ptr); }
+
+void* operator new(std::size_t size) { return counted_alloc(size); }
+
+void* operator new[](std::size_t size) { return counted_alloc(size); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+
+int main() {
+    const int ticks = 10000;
+
+    // fast enough that all four frames fit in the byte budget of a 40 Hz period (at the default 9600
+    // baud only 24 bytes, or 2 frames, fit)
+    auto transport = std::make_shared<NullTransport>(115200);
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+    Channel forearm("Forearm", CH_3, AN_CA_3, 100, 250);
+    channels.push_back(forearm);
+    Channel wrist("Wrist", CH_4, AN_CA_4, 100, 250);
+    channels.push_back(wrist);
+
+    std::vector<std::shared_ptr<Transport>> transports = {transport};
+    Stimulator stim("Alloc Benchmark", channels, transports, true);
+    stim.create_scheduler(0xAA, 40);
+    stim.add_events(channels);
+    stim.begin();
+
+    // fixed-size frames: every channel changes every tick and the budget fits them all, so every tick writes 4 frames
+    size_t frame_allocations = g_allocations;
+    size_t frame_bytes       = transport->get_bytes_written();
+    Clock  frame_clock;
+    for (int i = 0; i < ticks; i++) {
+        for (size_t c = 0; c < channels.size(); c++) {
+            stim.write_pw(channels[c], 10 + (i + c) % 20);
+        }
+        stim.update();
+    }
+    Time frame_time   = frame_clock.get_elapsed_time();
+    frame_allocations = g_allocations - frame_allocations;
+    frame_bytes       = transport->get_bytes_written() - frame_bytes;
+
+    // the old std::vector-based messages, built the way each event update used to be
+    size_t vector_allocations = g_allocations;
+    Clock  vector_clock;
+    for (int i = 0; i < ticks; i++) {
+        for (size_t c = 0; c < channels.size(); c++) {
+            std::vector<unsigned char> edit_event = {DEST_ADR,                               // Destination
+                                                     SRC_ADR,                                // Source
+                                                     CHANGE_EVENT_PARAMS_MSG,                // Msg type
+                                                     CHANGE_EVENT_PARAMS_LEN,                // Msg len
+                                                     (unsigned char)(c + 1),                 // Event ID
+                                                     (unsigned char)(10 + (i + c) % 20),     // Pulsewidth
+                                                     (unsigned char)100,                     // Amplitude
+                                                     0x00,                                   // Placeholder
+                                                     0x00};                                  // Checksum placeholder
+            WriteMessage edit_event_message(edit_event);
+            edit_event_message.write(transport.get(), "NONE");
+        }
+    }
+    Time vector_time   = vector_clock.get_elapsed_time();
+    vector_allocations = g_allocations - vector_allocations;
+
+    print_var((double)frame_allocations / ticks);
+    print_var(frame_time.as_seconds() * 1e6 / ticks);
+    print_var((double)vector_allocations / ticks);
+    print_var(vector_time.as_seconds() * 1e6 / ticks);
+    print_var(transport->get_bytes_written());
+    bool passed = frame_allocations == 0 && frame_bytes == (size_t)ticks * 4 * ChangeEventParamsFrame::SIZE;
+    print_var(passed);
+
+    stim.disable();
+
+    return passed ? 0 : 1;
+}
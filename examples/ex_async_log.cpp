@@ -0,0 +1,86 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdio>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// counts the records in a frame dump, checking that each is whole
+size_t count_dumped_frames(const char* filename, bool& whole) {
+    std::FILE* file  = std::fopen(filename, "rb");
+    size_t     count = 0;
+    whole            = file != nullptr;
+    while (file) {
+        int64_t       time_ns;
+        unsigned char size;
+        unsigned char bytes[256];
+        if (std::fread(&time_ns, sizeof(time_ns), 1, file) != 1) break;
+        // label, then frame
+        whole = whole && std::fread(&size, 1, 1, file) == 1 && std::fread(bytes, 1, size, file) == size;
+        whole = whole && std::fread(&size, 1, 1, file) == 1 && std::fread(bytes, 1, size, file) == size;
+        if (!whole) break;
+        count++;
+    }
+    if (file) std::fclose(file);
+    return count;
+}
+
+int main() {
+    AsyncLog& log = AsyncLog::get();
+
+    // a controller saturating one channel every tick: the clamp warning goes out once a second at
+    // most, and the commanding thread never formats or writes it
+    NullTransport transport;
+    Scheduler     scheduler;
+    scheduler.create_scheduler(&transport, 0xAA, 25, Time::Zero);
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    scheduler.add_event(bicep, Time::Zero, true);
+
+    const int ticks = 1000000;
+    Clock     clamp_clock;
+    for (int i = 0; i < ticks; i++) {
+        scheduler.set_amp(bicep, 150);
+    }
+    double clamp_ns = clamp_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+    log.flush();
+    LOG(Info) << "Saturated set_amp: " << clamp_ns << " ns per call, including the rate-limited warning";
+
+    // four threads dumping frames at once: every frame must come out whole in the dump, or be counted
+    // as dropped when the log could not keep up
+    const char* dump      = "async_log_frames.bin";
+    const int   producers = 4;
+    const int   frames    = 20000;
+    bool        passed    = log.set_frame_dump(dump);
+    size_t      dropped   = log.get_dropped_count();
+    Clock       frame_clock;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; t++) {
+        threads.push_back(std::thread([&log, t]() {
+            unsigned char frame[] = {0x04, 0x80, CHANGE_EVENT_PARAMS_MSG, CHANGE_EVENT_PARAMS_LEN, (unsigned char)t, 0, 0, 0, 0};
+            for (int i = 0; i < frames; i++) {
+                frame[5] = (unsigned char)i;
+                log.post_frame(Debug, "Update", frame, sizeof(frame));
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    double frame_ns = frame_clock.get_elapsed_time().as_seconds() * 1e9 / (producers * frames);
+    log.flush();
+    log.set_frame_dump("");
+    dropped = log.get_dropped_count() - dropped;
+
+    bool   whole  = false;
+    size_t dumped = count_dumped_frames(dump, whole);
+    passed        = passed && whole && dumped + dropped == (size_t)(producers * frames);
+    LOG(Info) << "Posted " << producers * frames << " frames from " << producers << " threads at " << frame_ns
+              << " ns each: " << dumped << " dumped, " << dropped << " dropped";
+
+    // without a dump open, a frame is logged as hex, formatted on the log's thread
+    unsigned char reply[] = {0x02, 0x34, 0xAA, 0x05, 0x80, 0x04, CREATE_EVENT_REPLY_MSG, 0x01, 0x01};
+    log.post_frame(Info, "Message", reply, sizeof(reply));
+    log.flush();
+
+    print_var(passed);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    // one emulated board per comport, so both boards are set up exactly as they would be on hardware
+    Emulator board_1;
+    Emulator board_2;
+    if (!board_1.open() || !board_2.open()) return 1;
+    board_1.start();
+    board_2.start();
+
+    std::vector<Channel> channels;
+    channels.push_back(Channel("Bicep", CH_1, AN_CA_1, 100, 250));
+    channels.push_back(Channel("Tricep", CH_2, AN_CA_2, 100, 250));
+    channels.push_back(Channel("Forearm", CH_3, AN_CA_3, 100, 250));
+    channels.push_back(Channel("Wrist", CH_4, AN_CA_4, 100, 250));
+    channels.push_back(Channel("Quad", CH_5, AN_CA_1, 100, 250));
+    channels.push_back(Channel("Hamstring", CH_6, AN_CA_2, 100, 250));
+    channels.push_back(Channel("Calf", CH_7, AN_CA_3, 100, 250));
+    channels.push_back(Channel("Shin", CH_8, AN_CA_4, 100, 250));
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(board_1.get_port_name()),
+                                                          std::make_shared<SerialTransport>(board_2.get_port_name())};
+
+    // the constructor sets up the channels on both boards at once
+    Stimulator stim("Bring-up", channels, transports, false);
+
+    Clock schedule_clock;
+    bool  success = stim.create_scheduler(0xAA, 40);
+    Time  schedule_time = schedule_clock.get_elapsed_time();
+
+    // events wait on the create event reply rather than a fixed sleep
+    Clock events_clock;
+    success = success && stim.add_events(channels);
+    Time events_time = events_clock.get_elapsed_time();
+
+    success = success && stim.begin();
+
+    print_var(success);
+    print_var(schedule_time);
+    print_var(events_time);
+    print_var(stim.get_bring_up_time());
+    print_var(stim.get_sync_skew());
+
+    stim.disable();
+    board_1.stop();
+    board_2.stop();
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdint>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// the lookup every accessor used to do: scan the events for the channel number
+const Event* find_linear(const std::vector<Event>& events, unsigned char channel_num) {
+    for (auto event = events.begin(); event != events.end(); event++) {
+        if (event->get_channel_num() == channel_num) return &(*event);
+    }
+    return nullptr;
+}
+
+void run(size_t num_channels, int ticks) {
+    NullTransport transport;
+    Scheduler     scheduler;
+    scheduler.create_scheduler(&transport, 0xAA, 25, Time::Zero);
+    scheduler.set_byte_budget(SIZE_MAX);
+
+    // the hardware tops out at 8 channels, but nothing in the scheduler depends on that
+    std::vector<Channel> channels;
+    for (size_t i = 0; i < num_channels; i++) {
+        channels.push_back(Channel("Channel " + std::to_string(i), (unsigned char)i, AN_CA_1, 100, 250));
+        scheduler.add_event(channels.back(), Time::Zero, true);
+    }
+
+    // indexed: set and read back every channel, then send the update
+    unsigned long long sum = 0;
+    Clock              indexed_clock;
+    for (int t = 0; t < ticks; t++) {
+        for (size_t i = 0; i < num_channels; i++) {
+            scheduler.set_amp(channels[i], 10 + (t + i) % 50);
+            scheduler.write_pw(channels[i], 20 + (t + i) % 50);
+            sum += scheduler.get_amp(channels[i]) + scheduler.get_pw(channels[i]);
+        }
+        scheduler.update();
+    }
+    double indexed_ns = indexed_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    // linear: the same four lookups per channel done by scanning the events
+    Clock linear_clock;
+    for (int t = 0; t < ticks; t++) {
+        for (size_t i = 0; i < num_channels; i++) {
+            for (int k = 0; k < 4; k++) {
+                const Event* event = find_linear(scheduler.get_events(), channels[i].get_channel_num());
+                sum += event->get_amplitude();
+            }
+        }
+    }
+    double linear_ns = linear_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    // no change: update finds nothing to send from the dirty mask, against asking each event in turn
+    Clock idle_clock;
+    for (int t = 0; t < ticks; t++) {
+        scheduler.update();
+    }
+    double idle_ns = idle_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    Clock scan_clock;
+    for (int t = 0; t < ticks; t++) {
+        const std::vector<Event>& events = scheduler.get_events();
+        for (size_t i = 0; i < events.size(); i++) {
+            sum += events[i].is_dirty();
+        }
+    }
+    double scan_ns = scan_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    std::vector<ChannelState> snapshot;
+    scheduler.get_states(snapshot);
+
+    LOG(Info) << num_channels << " channels: " << indexed_ns << " ns/tick with the index (including update), "
+              << linear_ns << " ns/tick for the lookups alone by linear scan. With no changes, " << idle_ns
+              << " ns/tick from the dirty mask, " << scan_ns << " ns/tick checking each event. Snapshot has " << snapshot.size()
+              << " channels (checksum " << sum << ")";
+}
+
+int main() {
+    run(4, 100000);
+    run(8, 100000);
+    run(16, 50000);
+    run(32, 20000);
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    ChannelStore store;
+    for (unsigned char c = 0; c < 8; c++) store.add_channel(c, 100, 250);
+
+    // a control loop hammering the store: the limit keeps dropping below the amplitude, and the store
+    // lowers the amplitude in the same change. A torn read would show an amplitude above its limit
+    std::atomic<bool> stop(false);
+    std::thread       writer([&]() {
+        for (unsigned int i = 0; !stop; i++) {
+            unsigned char c = (unsigned char)(i % 8);
+            store.set_amplitude(c, 90);
+            store.set_pulsewidth(c, 10 + i % 200);
+            store.set_max_amplitude(c, 20 + i % 60);
+            store.set_max_amplitude(c, 100);
+        }
+    });
+
+    // the gui thread taking snapshots at the same time
+    ChannelStore::Snapshot snapshot;
+    size_t                 torn      = 0;
+    const int              snapshots = 1000000;
+    Clock                  clock;
+    for (int i = 0; i < snapshots; i++) {
+        store.get_snapshot(snapshot);
+        for (size_t c = 0; c < 8; c++) {
+            if (snapshot.amplitude[c] > snapshot.max_amplitude[c]) torn++;
+        }
+    }
+    double snapshot_ns = clock.get_elapsed_time().as_seconds() * 1e9 / snapshots;
+    stop = true;
+    writer.join();
+
+    print_var(torn);
+    print_var(snapshot_ns);
+    print_var(store.get_sequence());
+
+    return torn == 0 ? 0 : 1;
+}
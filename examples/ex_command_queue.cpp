@@ -0,0 +1,108 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+#include <deque>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// A scripted UECU that answers every create event message straight away, except that it drops the
+// first reply for one channel and rejects the first message for another. It counts the events it
+// creates on each channel, so a create that was resent after its reply was lost would show up twice
+class FlakyUecu : public Transport {
+public:
+    FlakyUecu() : Transport("FLAKY"), m_created(), m_next_id(1), m_dropped(false), m_rejected(false) {}
+    bool open() override { return true; }
+    void close() override {}
+    bool is_open() override { return true; }
+    void purge() override { m_rx.clear(); }
+
+    bool write(const unsigned char* data, size_t size) override {
+        if (size < ChangeEventParamsFrame::SIZE || data[2] != CREATE_EVENT_MSG) return true;
+        unsigned char channel = data[WRITE_HEADER_SIZE + 5];
+        if (channel == 2 && !m_dropped) {
+            // the event is created, but its reply never makes it back
+            m_created[channel]++;
+            m_next_id++;
+            m_dropped = true;
+            return true;
+        }
+        if (channel == 3 && !m_rejected) {
+            m_rejected = true;
+            reply(ERROR_REPORT_MSG, {0x01, CREATE_EVENT_MSG});
+            return true;
+        }
+        m_created[channel & 3]++;
+        reply(CREATE_EVENT_REPLY_MSG, {m_next_id++, data[WRITE_HEADER_SIZE], STIM_EVENT, channel});
+        return true;
+    }
+
+    /// returns the number of events created on channel
+    int get_created(unsigned char channel) const { return m_created[channel & 3]; }
+
+    int read(unsigned char* data, size_t size, Time) override {
+        size_t n = std::min(size, m_rx.size());
+        for (size_t i = 0; i < n; i++) {
+            data[i] = m_rx.front();
+            m_rx.pop_front();
+        }
+        return (int)n;
+    }
+
+private:
+    void reply(unsigned char msg_type, std::vector<unsigned char> data) {
+        std::vector<unsigned char> bytes = {0x02, 0x34, 0xAA, (unsigned char)(4 + data.size()), SRC_ADR, DEST_ADR,
+                                            msg_type, (unsigned char)data.size()};
+        bytes.insert(bytes.end(), data.begin(), data.end());
+        unsigned short crc = calc_crc16(&bytes[0], bytes.size());
+        bytes.push_back(lo_byte(crc));
+        bytes.push_back(hi_byte(crc));
+        m_rx.insert(m_rx.end(), bytes.begin(), bytes.end());
+    }
+
+    std::deque<unsigned char> m_rx;
+    int                       m_created[4];
+    unsigned char             m_next_id;
+    bool                      m_dropped;
+    bool                      m_rejected;
+};
+
+int main() {
+    FlakyUecu    uecu;
+    CommandQueue commands(&uecu);
+    commands.set_timeout(milliseconds(50));
+
+    // send all four create event messages at once and collect the event ids as the replies arrive.
+    // Creates are never resent: if only the reply was lost, a resend would make a second event
+    std::vector<std::future<CommandResult>> replies;
+    for (unsigned char channel = 0; channel < 4; channel++) {
+        CreateEventFrame create_event;
+        create_event.data()[0] = 0x01;     // Schedule ID
+        create_event.data()[4] = STIM_EVENT;
+        create_event.data()[5] = channel;  // Channel number
+        replies.push_back(commands.submit_once(create_event, ReplyMatch(CREATE_EVENT_REPLY_MSG, 3, channel),
+                                               [channel](const CommandResult&) {
+                                                   LOG(Info) << "Channel " << (int)channel << " finished";
+                                               }));
+    }
+
+    // one reply is lost and one message is rejected, so channels 2 and 3 fail without being resent
+    Clock clock;
+    bool  passed = !commands.wait_all();
+    for (unsigned char channel = 0; channel < 4; channel++) {
+        CommandResult result = replies[channel].get();
+        bool          ok     = channel < 2;
+        passed = passed && result.success == ok && (!ok || result.reply.get_data()[3] == channel);
+        passed = passed && uecu.get_created(channel) == (channel < 3 ? 1 : 0);
+        if (result.success) {
+            LOG(Info) << "Channel " << (int)channel << " got event id " << (int)result.reply.get_data()[0];
+        }
+    }
+
+    print_var(clock.get_elapsed_time());
+    print_var(commands.get_retry_count());
+    print_var(commands.get_failure_count());
+    print_var(passed);
+
+    return passed ? 0 : 1;
+}
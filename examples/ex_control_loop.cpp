@@ -0,0 +1,71 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// drives one emulated board for ticks periods, either with a plain Timer loop or with ControlLoop, and
+// returns how long each command waited on the board before a pulse used it
+Emulator::LatencyStats run(bool phase_locked, int ticks) {
+    Emulator emulator;
+    if (!emulator.open()) return Emulator::LatencyStats();
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("Control Loop", channels, transports, false);
+    stim.create_scheduler(0xAA, 40);
+    stim.add_events(channels);
+    stim.begin();
+
+    if (phase_locked) {
+        // each update goes out 3 ms before the period (and so the bicep pulse) starts
+        ControlLoop loop(stim, Timer::WaitMode::Hybrid);
+        loop.set_lead(milliseconds(3));
+        loop.run([&](Time t) {
+            stim.write_pw(bicep, 10 + int(10 * sin(2 * PI * t.as_seconds())) + 10);
+            return true;
+        }, ticks);
+
+        ControlLoop::Stats stats = loop.get_stats();
+        print_var(stats.ticks);
+        print_var(stats.missed);
+        print_var(stats.skipped);
+        print_var(stats.mean_lateness);
+        print_var(stats.max_lateness);
+        std::string histogram;
+        for (size_t i = 0; i < ControlLoop::HISTOGRAM_BINS; i++) histogram += std::to_string(stats.lateness[i]) + " ";
+        LOG(Info) << "Lateness in " << stats.bin_width.as_microseconds() << " us bins: " << histogram;
+    } else {
+        // the loop runs at the right rate, but wherever in the period it happened to start
+        Timer timer(stim.get_period(), Timer::WaitMode::Hybrid);
+        Time  t = Time::Zero;
+        for (int i = 0; i < ticks; i++) {
+            stim.write_pw(bicep, 10 + int(10 * sin(2 * PI * t.as_seconds())) + 10);
+            stim.update();
+            t = timer.wait();
+        }
+    }
+
+    Emulator::LatencyStats latency = emulator.get_latency_stats();
+    stim.disable();
+    emulator.stop();
+    return latency;
+}
+
+int main() {
+    const int ticks = 200;
+
+    Emulator::LatencyStats plain = run(false, ticks);
+    LOG(Info) << "Timer loop: update to pulse " << plain.min.as_microseconds() << " to " << plain.max.as_microseconds()
+              << " us (mean " << plain.mean.as_microseconds() << " us)";
+
+    Emulator::LatencyStats locked = run(true, ticks);
+    LOG(Info) << "ControlLoop: update to pulse " << locked.min.as_microseconds() << " to " << locked.max.as_microseconds()
+              << " us (mean " << locked.mean.as_microseconds() << " us)";
+
+    return 0;
+}
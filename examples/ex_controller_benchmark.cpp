@@ -0,0 +1,156 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cmath>
+#include <limits>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// a virtual stimulator with num_channels channels, four to a board
+std::unique_ptr<Stimulator> make_stimulator(size_t num_channels, std::vector<Channel>& channels) {
+    const unsigned char anodes[] = {AN_CA_1, AN_CA_2, AN_CA_3, AN_CA_4};
+    std::vector<std::shared_ptr<Transport>> transports;
+    for (size_t i = 0; i < num_channels; i++) {
+        if (i % 4 == 0) transports.push_back(std::make_shared<NullTransport>());
+        channels.push_back(Channel("Channel " + std::to_string(i), (unsigned char)i, anodes[i % 4], 100, 250));
+    }
+    std::unique_ptr<Stimulator> stim(new Stimulator("Controller Benchmark", channels, transports, true));
+    stim->create_scheduler(0xAA, 40);
+    stim->add_events(channels);
+    stim->begin();
+    return stim;
+}
+
+void run(size_t num_channels, int ticks) {
+    std::vector<Channel>        channels;
+    std::unique_ptr<Stimulator> stim = make_stimulator(num_channels, channels);
+
+    // a reference and a feedforward for every channel, 10 s at 100 Hz
+    const size_t       samples = 1000;
+    std::vector<float> reference(num_channels * samples), feedforward(num_channels * samples);
+    for (size_t c = 0; c < num_channels; c++) {
+        for (size_t s = 0; s < samples; s++) {
+            reference[c * samples + s]   = (float)(30 + 20 * std::sin(2 * PI * s / 200.0 + c));
+            feedforward[c * samples + s] = reference[c * samples + s] / 0.8f;
+        }
+    }
+    Profile reference_profile, feedforward_profile;
+    reference_profile.set_samples(num_channels, samples, milliseconds(10), &reference[0]);
+    feedforward_profile.set_samples(num_channels, samples, milliseconds(10), &feedforward[0]);
+
+    ControllerBank  bank(*stim);
+    ControllerGains gains;
+    gains.kp                = 1.0;
+    gains.ki                = 4.0;
+    gains.kd                = 0.05;
+    gains.derivative_filter = 0.02;
+    gains.rate_limit        = 2000;
+    for (size_t c = 0; c < num_channels; c++) {
+        bank.add_channel(channels[c], gains);
+        bank.set_reference(c, &reference_profile, c);
+        bank.set_feedforward(c, &feedforward_profile, c);
+    }
+
+    std::vector<double> measured(num_channels);
+    double              checksum = 0;
+    // just the controllers
+    Clock compute_clock;
+    for (int t = 0; t < ticks; t++) {
+        for (size_t c = 0; c < num_channels; c++) measured[c] = 25 + (t + c) % 10;
+        bank.compute(milliseconds(t % 10000), &measured[0]);
+        checksum += bank.get_outputs()[0];
+    }
+    double compute_ns = compute_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    // the controllers and writing every output into the events
+    bank.reset();
+    Clock step_clock;
+    for (int t = 0; t < ticks; t++) {
+        for (size_t c = 0; c < num_channels; c++) measured[c] = 25 + (t + c) % 10;
+        bank.step(milliseconds(t % 10000), &measured[0]);
+    }
+    double step_ns = step_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    // the controller UDP_feedback used: feedforward plus a proportional term clamped to the max,
+    // one channel at a time, written through copies of the channels
+    std::vector<unsigned int> pulsewidths(num_channels);
+    Clock                     scalar_clock;
+    for (int t = 0; t < ticks; t++) {
+        for (size_t c = 0; c < num_channels; c++) {
+            double target, open_loop;
+            reference_profile.sample(c, milliseconds(t % 10000), target);
+            feedforward_profile.sample(c, milliseconds(t % 10000), open_loop);
+            double pulse   = std::round(open_loop + 1.0 * (target - (25 + (t + c) % 10)));
+            pulsewidths[c] = pulse < 0 ? 0 : (pulse > 250 ? 250 : (unsigned int)pulse);
+        }
+        stim->write_pws(channels, pulsewidths);
+    }
+    double scalar_ns = scalar_clock.get_elapsed_time().as_seconds() * 1e9 / ticks;
+
+    LOG(Info) << num_channels << " channels: " << compute_ns << " ns/tick to compute, " << step_ns
+              << " ns/tick with the write, " << scalar_ns << " ns/tick for the old P controller per channel (checksum "
+              << checksum << ")";
+    stim->disable();
+}
+
+int main() {
+    // anti-windup: hold one channel at its limit for a second with a reference it cannot reach, then
+    // drop the reference. The output has to come off the limit on the next tick
+    std::vector<Channel>        channels;
+    std::unique_ptr<Stimulator> stim = make_stimulator(1, channels);
+    ControllerBank              bank(*stim);
+    ControllerGains             gains;
+    gains.kp         = 1;
+    gains.ki         = 20;
+    gains.max_output = 100;
+    bank.add_channel(channels[0], gains);
+    double measured = 0;
+    bank.set_setpoint(0, 500);
+    for (int t = 0; t < 40; t++) bank.step(milliseconds(25 * t), &measured);
+    std::vector<ChannelState> snapshot;
+    stim->get_snapshot(snapshot);
+    bool passed = bank.get_outputs()[0] == 100 && snapshot[0].pulsewidth == 100;
+    bank.set_setpoint(0, 50);
+    bank.step(milliseconds(1000), &measured);
+    passed = passed && bank.get_outputs()[0] < 100;
+
+    // rate limit: from rest, a 2000 us/s limit moves at most 50 us in a 25 ms period
+    bank.reset();
+    gains.rate_limit = 2000;
+    bank.set_gains(0, gains);
+    bank.set_setpoint(0, 0);
+    bank.step(Time::Zero, &measured);
+    bank.set_setpoint(0, 500);
+    bank.step(milliseconds(25), &measured);
+    passed = passed && std::fabs(bank.get_outputs()[0] - 50) < 1e-9;
+
+    // a measurement that is not a number holds the last output, and the next good one carries on from it
+    double held = bank.get_outputs()[0];
+    double bad  = std::numeric_limits<double>::quiet_NaN();
+    bank.step(milliseconds(50), &bad);
+    passed = passed && bank.get_outputs()[0] == held;
+    bank.step(milliseconds(75), &measured);
+    passed = passed && std::isfinite(bank.get_outputs()[0]) && std::fabs(bank.get_outputs()[0] - (held + 50)) < 1e-9;
+    stim->disable();
+
+    // the same across channels: only the channel with the bad measurement holds, the rest keep moving
+    std::vector<Channel>        bank_channels;
+    std::unique_ptr<Stimulator> bank_stim = make_stimulator(5, bank_channels);
+    ControllerBank              five(*bank_stim);
+    std::vector<double>         five_measured(5, 0.0);
+    for (size_t c = 0; c < 5; c++) five.add_channel(bank_channels[c], gains);
+    five.step(Time::Zero, &five_measured[0]);
+    for (size_t c = 0; c < 5; c++) five.set_setpoint(c, 500);
+    five_measured[3] = bad;
+    five.step(milliseconds(25), &five_measured[0]);
+    for (size_t c = 0; c < 5; c++) passed = passed && std::fabs(five.get_outputs()[c] - (c == 3 ? 0 : 50)) < 1e-9;
+    bank_stim->disable();
+    print_var(passed);
+
+    run(1, 200000);
+    run(4, 200000);
+    run(8, 100000);
+    run(16, 100000);
+    run(32, 50000);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <random>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+typedef unsigned short (*CrcFunction)(const unsigned char*, size_t, unsigned short);
+
+// times crc over every frame (without the trailing crc bytes) and returns ns per frame
+double time_frames(CrcFunction crc, const std::vector<std::vector<unsigned char>>& frames, int repeats,
+                   unsigned int& checksum) {
+    Clock clock;
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < frames.size(); i++) {
+            checksum += crc(&frames[i][0], frames[i].size() - READ_CRC_SIZE, CRC_SEED);
+        }
+    }
+    return clock.get_elapsed_time().as_seconds() * 1e9 / (frames.size() * repeats);
+}
+
+// times crc over one large buffer (eg. a recorded log being replayed) and returns MB/s
+double time_bulk(CrcFunction crc, const std::vector<unsigned char>& bulk, int repeats, unsigned int& checksum) {
+    Clock clock;
+    for (int r = 0; r < repeats; r++) {
+        checksum += crc(&bulk[0], bulk.size(), CRC_SEED);
+    }
+    return bulk.size() * (double)repeats / clock.get_elapsed_time().as_seconds() / 1e6;
+}
+
+int main() {
+    std::mt19937                       rng(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // a recording of typical replies: short create/command replies and the occasional longer one
+    std::vector<std::vector<unsigned char>> frames;
+    std::vector<unsigned char>              bulk;
+    for (int i = 0; i < 4096; i++) {
+        size_t                     msg_len = i % 16 == 0 ? READ_FRAME_MAX_DATA : 1 + (size_t)byte(rng) % 4;
+        std::vector<unsigned char> frame   = {0x02, 0x34, 0xAA, (unsigned char)(4 + msg_len), SRC_ADR, DEST_ADR,
+                                              CREATE_EVENT_REPLY_MSG, (unsigned char)msg_len};
+        for (size_t j = 0; j < msg_len; j++) frame.push_back((unsigned char)byte(rng));
+        unsigned short crc = crc16_bitwise(&frame[0], frame.size());
+        frame.push_back(lo_byte(crc));
+        frame.push_back(hi_byte(crc));
+        frames.push_back(frame);
+        bulk.insert(bulk.end(), frame.begin(), frame.end());
+    }
+
+    // every variant has to agree with the reference at every length and seed
+    bool passed = true;
+    for (size_t size = 0; size <= 300 && size <= bulk.size(); size++) {
+        for (unsigned int seed = 0; seed <= 0xFFFF; seed += 0x3FFF) {
+            unsigned short expected = crc16_bitwise(&bulk[0], size, (unsigned short)seed);
+            if (crc16_slice8(&bulk[0], size, (unsigned short)seed) != expected ||
+                crc16_clmul(&bulk[0], size, (unsigned short)seed) != expected ||
+                calc_crc16(&bulk[0], size, (unsigned short)seed) != expected) {
+                LOG(Error) << "CRC mismatch at size " << size << " seed " << seed;
+                passed = false;
+            }
+        }
+    }
+    if (crc16_clmul(&bulk[0], bulk.size()) != crc16_bitwise(&bulk[0], bulk.size())) {
+        LOG(Error) << "CRC mismatch over the whole recording";
+        passed = false;
+    }
+    print_var(passed);
+    print_var(crc16_clmul_supported());
+
+    unsigned int checksum = 0;
+    print_var(bulk.size());
+    LOG(Info) << "Per frame (ns): bitwise " << time_frames(crc16_bitwise, frames, 20, checksum) << ", slice-by-8 "
+              << time_frames(crc16_slice8, frames, 20, checksum) << ", clmul "
+              << time_frames(crc16_clmul, frames, 20, checksum) << ", calc_crc16 "
+              << time_frames(calc_crc16, frames, 20, checksum);
+    LOG(Info) << "Bulk (MB/s): bitwise " << time_bulk(crc16_bitwise, bulk, 20, checksum) << ", slice-by-8 "
+              << time_bulk(crc16_slice8, bulk, 20, checksum) << ", clmul " << time_bulk(crc16_clmul, bulk, 20, checksum);
+    // keeps the compiler from optimizing the timed calls away
+    print_var(checksum);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    // create a headless UECU emulator on a pseudo-terminal. The stimulator talks to the slave
+    // side of the pseudo-terminal exactly as it would talk to /dev/ttyUSB0
+    Emulator emulator;
+    if (!emulator.open()) return 1;
+
+    // run the emulator in real time while the stimulator is set up, since setup waits on replies
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("Emulated UECU", channels, transports, false);
+
+    // 40 Hz schedule -> 25 ms period
+    stim.create_scheduler(0xAA, 40);
+    stim.add_events(channels);
+    stim.begin();
+
+    // take over the emulator clock so simulated time only moves when we say so. Each loop
+    // iteration below simulates exactly one schedule period, as fast as the host can go
+    emulator.stop();
+
+    const Time period = milliseconds(25);
+    const int  cycles = 4000;
+
+    Clock wall_clock;
+    for (int i = 0; i < cycles; i++) {
+        stim.write_pw(bicep, 10 + i % 20);
+        stim.write_pw(tricep, 30 - i % 20);
+        stim.update();
+        // handle whatever the stimulator just wrote, then run the board for one period
+        emulator.service();
+        emulator.advance(period);
+    }
+    Time wall_time = wall_clock.get_elapsed_time();
+
+    Emulator::LatencyStats latency = emulator.get_latency_stats();
+
+    print_var(emulator.get_sim_time());
+    print_var(wall_time);
+    print_var(cycles / wall_time.as_seconds());
+    print_var(emulator.get_pulse_count(0));
+    print_var(emulator.get_pulse_count(1));
+    print_var(latency.count);
+    print_var(latency.min);
+    print_var(latency.mean);
+    print_var(latency.max);
+
+    // let the emulator answer the shutdown messages
+    emulator.start();
+    stim.disable();
+    emulator.stop();
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+#include <random>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// builds a reply the way the UECU sends it, with a correct CRC
+std::vector<unsigned char> make_reply(unsigned char msg_type, const std::vector<unsigned char>& data) {
+    unsigned char              msg_len = (unsigned char)data.size();
+    std::vector<unsigned char> reply   = {0x02, 0x34, 0xAA, (unsigned char)(4 + msg_len), SRC_ADR, DEST_ADR, msg_type, msg_len};
+    reply.insert(reply.end(), data.begin(), data.end());
+    unsigned short crc = calc_crc16(&reply[0], reply.size());
+    reply.push_back(lo_byte(crc));
+    reply.push_back(hi_byte(crc));
+    return reply;
+}
+
+// feeds the whole stream to a new parser in chunks of chunk_size and returns the parser
+FrameParser parse_stream(const std::vector<unsigned char>& stream, size_t chunk_size, std::vector<ReadFrame>* frames) {
+    FrameParser parser;
+    size_t      pos = 0;
+    while (pos < stream.size()) {
+        size_t chunk = std::min(chunk_size, stream.size() - pos);
+        size_t used  = 0;
+        // a chunk may hold several messages, and feed stops after each one
+        while (used < chunk) {
+            used += parser.feed(&stream[pos + used], chunk - used);
+            if (parser.frame_ready() && frames) frames->push_back(parser.get_frame());
+        }
+        pos += chunk;
+    }
+    // bytes of a message rejected at the very end of the stream still have to be searched
+    while (parser.bytes_needed() == 0) {
+        parser.feed(nullptr, 0);
+        if (parser.frame_ready() && frames) frames->push_back(parser.get_frame());
+    }
+    return parser;
+}
+
+int main() {
+    std::mt19937                       rng(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const unsigned char                types[] = {ERROR_REPORT_MSG, CREATE_SCHEDULE_REPLY_MSG, CREATE_EVENT_REPLY_MSG,
+                                                  EVENT_COMMAND_REPLY_MSG};
+    const size_t                       num_replies = 20000;
+
+    // a stream of valid replies separated by runs of random noise. Noise can hold any byte, but
+    // it is far too short to form a full header, so every reply must be recovered
+    std::vector<unsigned char> stream;
+    std::vector<unsigned char> types_sent;
+    std::vector<size_t>        reply_start;  // where each reply begins in the stream
+    for (size_t i = 0; i < num_replies; i++) {
+        size_t noise = (size_t)byte(rng) % 8;
+        for (size_t j = 0; j < noise; j++) stream.push_back((unsigned char)byte(rng));
+        reply_start.push_back(stream.size());
+        std::vector<unsigned char> data((size_t)byte(rng) % 9);
+        for (size_t j = 0; j < data.size(); j++) data[j] = (unsigned char)byte(rng);
+        unsigned char type = types[(size_t)byte(rng) % 4];
+        std::vector<unsigned char> reply = make_reply(type, data);
+        stream.insert(stream.end(), reply.begin(), reply.end());
+        types_sent.push_back(type);
+    }
+
+    // the result must not depend on how the bytes are split up
+    const size_t chunk_sizes[] = {1, 3, 7, 64, 4096, stream.size()};
+    bool         passed        = true;
+    for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+        std::vector<ReadFrame> frames;
+        FrameParser            parser = parse_stream(stream, chunk_sizes[c], &frames);
+        bool                   match  = frames.size() == num_replies;
+        for (size_t i = 0; match && i < frames.size(); i++) {
+            match = frames[i].get_type() == types_sent[i] && frames[i].is_valid();
+        }
+        if (!match) {
+            LOG(Error) << "Chunk size " << chunk_sizes[c] << " recovered " << frames.size() << " of " << num_replies
+                       << " replies";
+            passed = false;
+        }
+        print_var(parser.get_discarded_count());
+    }
+
+    // fuzz: corrupt random bytes of the stream. Corrupted replies are dropped, but the parser must
+    // only ever emit replies with a correct CRC and must recover every reply that was left intact
+    reply_start.push_back(stream.size());
+    for (int round = 0; round < 20; round++) {
+        std::vector<unsigned char> fuzzed = stream;
+        std::vector<bool>          damaged(num_replies, false);
+        for (size_t i = 0; i < fuzzed.size() / 100; i++) {
+            size_t        at = (size_t)(rng() % fuzzed.size());
+            unsigned char b  = (unsigned char)byte(rng);
+            if (b == fuzzed[at]) continue;
+            fuzzed[at] = b;
+            // the reply whose bytes (or trailing noise) hold this position
+            size_t reply = (size_t)(std::upper_bound(reply_start.begin(), reply_start.end(), at) - reply_start.begin());
+            if (reply > 0) damaged[reply - 1] = true;
+        }
+        size_t intact = (size_t)std::count(damaged.begin(), damaged.end(), false);
+        std::vector<ReadFrame> frames;
+        FrameParser            parser = parse_stream(fuzzed, 1 + rng() % 256, &frames);
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (calc_crc16(frames[i].get_bytes(), frames[i].get_size() - READ_CRC_SIZE) != frames[i].get_crc()) {
+                LOG(Error) << "Parser emitted a reply with a bad CRC";
+                passed = false;
+            }
+        }
+        if (frames.size() < intact) {
+            LOG(Error) << "Fuzz round " << round << " recovered " << frames.size() << " replies but " << intact
+                       << " were intact";
+            passed = false;
+        }
+        if (round == 0) {
+            print_var(intact);
+            print_var(frames.size());
+            print_var(parser.get_crc_error_count());
+        }
+    }
+    print_var(passed);
+
+    // benchmark feeding one byte at a time (as bytes trickle in from a serial port) against feeding
+    // everything that is buffered at once
+    const size_t bench_chunks[] = {1, 16, 4096};
+    for (size_t c = 0; c < sizeof(bench_chunks) / sizeof(bench_chunks[0]); c++) {
+        Clock clock;
+        parse_stream(stream, bench_chunks[c], nullptr);
+        double seconds = clock.get_elapsed_time().as_seconds();
+        LOG(Info) << "Chunk size " << bench_chunks[c] << ": " << stream.size() / seconds / 1e6 << " MB/s, "
+                  << seconds * 1e9 / num_replies << " ns/reply";
+    }
+
+    return passed ? 0 : 1;
+}
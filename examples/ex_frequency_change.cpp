@@ -0,0 +1,124 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <mutex>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    Emulator emulator;
+    if (!emulator.open()) return 1;
+
+    // count the pulses on the first channel so the frequency the board actually ran at can be checked
+    std::mutex    mtx;
+    size_t        pulses     = 0;
+    unsigned char last_pw    = 0;
+    emulator.set_pulse_callback([&](const Emulator::Pulse& pulse) {
+        if (pulse.board_channel != 0) return;
+        std::lock_guard<std::mutex> lock(mtx);
+        pulses++;
+        last_pw = pulse.pulse_width;
+    });
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("Frequency Change", channels, transports, false);
+
+    bool success = stim.create_scheduler(0xAA, 40);
+    success      = success && stim.add_events(channels);
+    success      = success && stim.begin();
+
+    // each event needs at least Scheduler::EVENT_SPACING ms, so a 2 ms period is refused before
+    // anything is sent
+    bool too_fast = stim.set_frequency(500);
+    print_var(too_fast);
+    bool passed = !too_fast;
+
+    success = success && stim.start_io_thread();
+
+    // sweep the frequency while stimulating, with no gap to recreate the schedule. Each change places
+    // the events again, so the tricep stays in the middle of the period between the bicep's pulses
+    const double frequencies[] = {40, 20, 50, 25};
+    for (size_t i = 0; success && i < sizeof(frequencies) / sizeof(frequencies[0]); i++) {
+        passed = stim.set_frequency(frequencies[i]) && passed;
+        stim.write_pw(bicep, 20 + 10 * i);
+        sleep(milliseconds(100));
+
+        size_t start = 0;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            start = pulses;
+        }
+        sleep(seconds(1));
+        std::lock_guard<std::mutex> lock(mtx);
+        LOG(Info) << "Asked for " << frequencies[i] << " Hz, the board ran at " << pulses - start << " Hz with "
+                  << (int)last_pw << " us pulses";
+        // the period is whole milliseconds and the count is over a sleep, so allow a little either way
+        double measured = (double)(pulses - start);
+        if (measured < frequencies[i] * 0.95 - 1 || measured > frequencies[i] * 1.05 + 1) {
+            LOG(Error) << "The board ran at " << measured << " Hz instead of " << frequencies[i] << " Hz";
+            passed = false;
+        }
+        success = stim.update();
+    }
+
+    stim.stop_io_thread();
+    print_var(success);
+    print_var(stim.get_frequency());
+    print_var(emulator.get_error_count());
+    passed = passed && success && emulator.get_error_count() == 0;
+
+    stim.disable();
+    emulator.stop();
+
+    // on the board the period in progress finishes at its old length before a new one takes over, so a
+    // 50 ms schedule changed to 20 ms at 120 ms still pulses at 150 ms and then every 20 ms after that
+    Emulator            boundary;
+    std::vector<size_t> pulse_times;
+    boundary.set_pulse_callback([&](const Emulator::Pulse& pulse) { pulse_times.push_back((size_t)pulse.time.as_milliseconds()); });
+    CreateScheduleFrame create_schedule;
+    create_schedule.data()[0] = 0xAA;
+    create_schedule.data()[2] = 50;
+    create_schedule.finalize();
+    boundary.feed(create_schedule.get_bytes(), create_schedule.get_size());
+    CreateEventFrame create_event;
+    create_event.data()[0] = 1;  // first schedule id
+    create_event.data()[4] = 3;  // stimulus event
+    create_event.finalize();
+    boundary.feed(create_event.get_bytes(), create_event.get_size());
+    SyncFrame sync;
+    sync.data()[0] = 0xAA;
+    sync.finalize();
+    boundary.feed(sync.get_bytes(), sync.get_size());
+    boundary.advance(milliseconds(120));
+    ChangeScheduleFrame change_schedule;
+    change_schedule.data()[0] = 1;
+    change_schedule.data()[1] = 0xAA;
+    change_schedule.data()[3] = 20;
+    change_schedule.finalize();
+    boundary.feed(change_schedule.get_bytes(), change_schedule.get_size());
+    boundary.advance(milliseconds(100));
+    bool switched_at_boundary = pulse_times == std::vector<size_t>{0, 50, 100, 150, 170, 190, 210};
+    print_var(switched_at_boundary);
+    passed = passed && switched_at_boundary;
+
+    // a channel number the channel store cannot hold would have run past the delay tables when the
+    // events are placed again, so a stimulator with one is never enabled and cannot change frequency
+    std::vector<Channel> out_of_range = {bicep, Channel("Out of Range", (unsigned char)ChannelStore::CAPACITY, AN_CA_1, 100, 250)};
+    std::vector<std::shared_ptr<Transport>> null_transports = {std::make_shared<NullTransport>()};
+    Stimulator bad_stim("Out of Range", out_of_range, null_transports, true);
+    bool bad_enabled   = bad_stim.is_enabled() || bad_stim.enable();
+    bool bad_frequency = bad_stim.set_frequency(20);
+    print_var(bad_enabled);
+    print_var(bad_frequency);
+    passed = passed && !bad_enabled && !bad_frequency;
+    print_var(passed);
+
+    return passed ? 0 : 1;
+}
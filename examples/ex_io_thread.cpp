@@ -0,0 +1,67 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    // run against the emulator so that the example works without hardware
+    Emulator emulator;
+    if (!emulator.open()) return 1;
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("I/O Thread", channels, transports, false);
+
+    stim.create_scheduler(0xAA, 40);
+    stim.add_events(channels);
+    stim.begin();
+
+    // hand the serial port to a dedicated thread, on cpu 1 if there is more than one. Asking for a
+    // realtime priority may fail without permissions, in which case the thread still runs at normal priority
+    int io_cpu = std::thread::hardware_concurrency() > 1 ? 1 : -1;
+    stim.start_io_thread(ThreadSettings(io_cpu, ThreadPriority::Realtime));
+
+    // the control loop runs at 1 kHz, much faster than the 40 Hz schedule. Only the latest command
+    // for each channel is sent each period, and set_amp/write_pw never wait on the serial port
+    set_current_thread_priority(ThreadPriority::High);
+    Timer timer(milliseconds(1), Timer::WaitMode::Hybrid);
+    Time  max_command_time = Time::Zero;
+    for (int i = 0; i < 2000; i++) {
+        Clock command_clock;
+        stim.write_pw(bicep, 10 + i % 20);
+        stim.write_pw(tricep, 30 - i % 20);
+        stim.set_amp(bicep, 20);
+        stim.set_amp(tricep, 20);
+        Time command_time = command_clock.get_elapsed_time();
+        if (command_time > max_command_time) max_command_time = command_time;
+
+        if (!stim.update()) break;
+
+        ReadFrame reply;
+        while (stim.pop_reply(reply)) {
+            LOG(Info) << "Received reply " << print_as_hex(reply.get_type());
+        }
+        timer.wait();
+    }
+
+    stim.stop_io_thread();
+
+    print_var(max_command_time);
+    print_var(stim.get_dropped_reply_count());
+    print_var(emulator.get_pulse_count(0));
+    print_var(emulator.get_pulse_count(1));
+    print_var(emulator.get_latency_stats().mean);
+
+    stim.disable();
+    emulator.stop();
+
+    return 0;
+}
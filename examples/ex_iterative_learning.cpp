@@ -0,0 +1,119 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cmath>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// runs trials of the movement with the control loop at loop_period, and returns the RMS error of the
+// first and last trial
+void run_trials(ControllerBank& bank, IterativeLearning& learning, Time loop_period, double& first_rms,
+                double& last_rms) {
+    const double plant_gain[] = {0.6, 0.5};
+    const double dt           = loop_period.as_seconds();
+    const Time   duration     = seconds(4);
+    for (int trial = 0; trial < 10; trial++) {
+        double angle[] = {30, 30};
+        bank.reset();
+        learning.begin_trial();
+        for (Time t = Time::Zero; t < duration; t += loop_period) {
+            bank.step(t, angle);
+            learning.record(t, bank.get_errors(), bank.get_outputs());
+            for (size_t c = 0; c < 2; c++) angle[c] += (plant_gain[c] * bank.get_outputs()[c] - angle[c]) * dt / 0.15;
+        }
+        double rms = (learning.get_rms_error(0) + learning.get_rms_error(1)) / 2;
+        if (trial == 0) first_rms = rms;
+        last_rms = rms;
+        LOG(Info) << "Trial " << trial + 1 << ": RMS error " << rms << " deg";
+        learning.update();
+    }
+}
+
+int main() {
+    std::vector<Channel> channels;
+    channels.push_back(Channel("Quadriceps", CH_1, AN_CA_1, 100, 250));
+    channels.push_back(Channel("Hamstrings", CH_2, AN_CA_2, 100, 250));
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<NullTransport>()};
+    Stimulator stim("Iterative Learning", channels, transports, true);
+    stim.create_scheduler(0xAA, 100);
+    stim.add_events(channels);
+    stim.begin();
+
+    // a 4 s movement at 100 Hz. The first feedforward assumes each muscle gives 0.8 deg per us, but
+    // they really give 0.6 and 0.5 and lag behind the stimulation
+    const size_t       samples = 400;
+    const Time         period  = milliseconds(10);
+    std::vector<float> desired(2 * samples), feedforward(2 * samples);
+    for (size_t s = 0; s < samples; s++) {
+        double t                 = s * 0.01;
+        desired[s]               = (float)(30 + 25 * std::sin(2 * PI * 0.5 * t));
+        desired[samples + s]     = (float)(20 + 15 * std::sin(2 * PI * 0.5 * t + 1));
+        feedforward[s]           = desired[s] / 0.8f;
+        feedforward[samples + s] = desired[samples + s] / 0.8f;
+    }
+    Profile reference;
+    reference.set_samples(2, samples, period, &desired[0]);
+
+    IterativeLearning learning;
+    learning.initialize(2, samples, period, &feedforward[0]);
+    LearningGains gains;
+    gains.learning_gain = 1.0;
+    gains.lead          = 10;
+    gains.max_output    = 250;
+    learning.set_gains(0, gains);
+    learning.set_gains(1, gains);
+    learning.set_q_filter(3.0);
+
+    // a little feedback on top of the learned feedforward
+    ControllerBank  bank(stim);
+    ControllerGains feedback;
+    feedback.kp = 0.5;
+    for (size_t c = 0; c < 2; c++) {
+        bank.add_channel(channels[c], feedback);
+        bank.set_reference(c, &reference, c);
+        bank.set_feedforward(c, &learning.get_feedforward(), c);
+    }
+
+    double first_rms = 0, last_rms = 0;
+    run_trials(bank, learning, period, first_rms, last_rms);
+
+    // the learned profile survives a save and load
+    bool passed = learning.save("learned.fesp") && learning.save_trial("last_trial.fesp");
+    IterativeLearning restored;
+    passed = restored.load("learned.fesp") && passed;
+    for (size_t s = 0; passed && s < samples; s += 37) {
+        double a, b;
+        passed = learning.get_feedforward().sample(1, period * (int64_t)s, a) &&
+                 restored.get_feedforward().sample(1, period * (int64_t)s, b) && a == b;
+    }
+    passed = passed && last_rms < first_rms / 4;
+
+    // a control loop three times slower than the profile records every third sample; the ones between
+    // are interpolated, so the learning is as smooth and converges as well
+    IterativeLearning slow;
+    slow.initialize(2, samples, period, &feedforward[0]);
+    slow.set_gains(0, gains);
+    slow.set_gains(1, gains);
+    slow.set_q_filter(3.0);
+    for (size_t c = 0; c < 2; c++) bank.set_feedforward(c, &slow.get_feedforward(), c);
+    double slow_first_rms = 0, slow_last_rms = 0;
+    LOG(Info) << "Control loop at 30 ms:";
+    run_trials(bank, slow, milliseconds(30), slow_first_rms, slow_last_rms);
+    passed = passed && slow_last_rms < slow_first_rms / 4;
+    stim.disable();
+
+    // the update between trials for a long trial: 8 channels of 10 minutes at 100 Hz
+    const size_t       long_samples = 60000;
+    std::vector<float> initial(8 * long_samples, 50.0f);
+    IterativeLearning  gait;
+    gait.initialize(8, long_samples, period, &initial[0]);
+    gait.set_q_filter(2.0);
+    std::vector<double> errors(8, 1.0), applied(8, 50.0);
+    for (size_t s = 0; s < long_samples; s++) gait.record(period * (int64_t)s, &errors[0], &applied[0]);
+    Clock update_clock;
+    gait.update();
+    LOG(Info) << "Updating 8 channels of " << long_samples << " samples took " << update_clock.get_elapsed_time();
+
+    print_var(passed);
+    return passed ? 0 : 1;
+}
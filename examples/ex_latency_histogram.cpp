@@ -0,0 +1,101 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// every value has to land in a bucket whose bounds hold it, and the reported value must be within
+// 1/SUB_BUCKETS of it
+bool check_buckets() {
+    bool passed = true;
+    for (uint64_t value = 0; value < (uint64_t(1) << 42); value = value < 64 ? value + 1 : value + value / 7 + 1) {
+        size_t   bucket = LatencyHistogram::bucket_of(value);
+        uint64_t upper  = LatencyHistogram::bucket_upper(bucket);
+        bool     inside = bucket == LatencyHistogram::BUCKETS - 1 ||
+                      (LatencyHistogram::bucket_lower(bucket) <= value && value <= upper &&
+                       upper - value <= value / LatencyHistogram::SUB_BUCKETS);
+        if (!inside) {
+            LOG(Error) << "Value " << value << " is not inside bucket " << bucket;
+            passed = false;
+        }
+    }
+    LatencyHistogram histogram;
+    for (int64_t i = 1; i <= 1000; i++) histogram.record(i * 1000);
+    LatencyHistogram::Snapshot snapshot;
+    histogram.take_snapshot(snapshot, true);
+    uint64_t p50 = snapshot.percentile(50);
+    if (snapshot.count != 1000 || p50 < 500000 || p50 > 500000 + 500000 / LatencyHistogram::SUB_BUCKETS) {
+        LOG(Error) << "Median of 1 to 1000 us came out as " << p50 << " ns";
+        passed = false;
+    }
+    histogram.take_snapshot(snapshot);
+    if (snapshot.count != 0) {
+        LOG(Error) << "Histogram was not emptied by the snapshot";
+        passed = false;
+    }
+    return passed;
+}
+
+void print_stages(const std::string& label, const LatencyRecorder::Snapshot& snapshot) {
+    const LatencyStage stages[] = {LatencyStage::Encode, LatencyStage::Write,    LatencyStage::Read,
+                                   LatencyStage::Parse,  LatencyStage::Validate, LatencyStage::Port};
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        const LatencyHistogram::Snapshot& stage = snapshot[stages[i]];
+        LOG(Info) << label << " " << get_stage_name(stages[i]) << ": " << stage.count << " samples, p50 "
+                  << stage.percentile(50) << " ns, p99 " << stage.percentile(99) << " ns, p99.9 "
+                  << stage.percentile(99.9) << " ns, max " << stage.max_ns << " ns";
+    }
+}
+
+int main() {
+    bool passed = check_buckets();
+    print_var(passed);
+
+    Emulator emulator;
+    if (!emulator.open()) return 1;
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("Latency", channels, transports, false);
+
+    bool success = stim.create_scheduler(0xAA, 100);
+    success      = success && stim.add_events(channels);
+    success      = success && stim.begin();
+
+    // time every stage of the I/O thread's cycles, and snapshot them once a second while it runs
+    success = success && stim.set_latency_tracking(true);
+    success = success && stim.start_io_thread();
+    LatencyRecorder::Snapshot snapshot;
+    for (int second = 0; success && second < 3; second++) {
+        for (int i = 0; i < 100; i++) {
+            stim.write_pw(bicep, 10 + i % 20);
+            stim.write_pw(tricep, 30 - i % 20);
+            sleep(milliseconds(10));
+        }
+        // with reset, each snapshot only holds the second since the last one
+        stim.get_latency_snapshot(0, snapshot, true);
+        print_stages("Second " + std::to_string(second + 1), snapshot);
+    }
+    stim.stop_io_thread();
+
+    // the same stages are timed when the calling thread sends the updates itself
+    for (int i = 0; success && i < 100; i++) {
+        stim.write_pw(bicep, 10 + i % 20);
+        success = stim.update();
+        sleep(milliseconds(10));
+    }
+    success = success && stim.write_latency_csv("latency.csv");
+    success = success && stim.write_latency_json("latency.json");
+
+    stim.disable();
+    emulator.stop();
+
+    print_var(success);
+    return passed && success ? 0 : 1;
+}
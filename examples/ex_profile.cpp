@@ -0,0 +1,92 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <cmath>
+#include <fstream>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// times count lookups spread over the whole profile and returns ns per lookup of every channel
+double time_lookups(const Profile& profile, int count, double& checksum) {
+    std::vector<double> values(profile.get_channel_count());
+    int64_t             step = profile.get_duration().as_microseconds() / count + 1;
+    Clock               clock;
+    for (int i = 0; i < count; i++) {
+        profile.sample_all(microseconds(i * step), &values[0]);
+        checksum += values[0];
+    }
+    return clock.get_elapsed_time().as_seconds() * 1e9 / count;
+}
+
+int main() {
+    // a long gait trial: 20 minutes of a knee angle and three open-loop pulsewidths at 100 Hz, far more
+    // than the 500 samples the old fixed arrays could hold
+    const size_t samples  = 20 * 60 * 100;
+    const size_t channels = 4;
+    {
+        std::ofstream file("gait_trial.txt");
+        file << "# knee angle (deg), then pulsewidths of three channels (us)\n";
+        for (size_t s = 0; s < samples; s++) {
+            double phase = 2 * PI * s / 120.0;
+            file << 20 + 40 * std::sin(phase);
+            for (size_t c = 1; c < channels; c++) file << ", " << 50 + 40 * std::sin(phase - c);
+            file << "\n";
+        }
+    }
+
+    bool    passed = true;
+    Profile text;
+    Clock   text_clock;
+    passed = text.load_text("gait_trial.txt", milliseconds(10)) && passed;
+    Time text_time = text_clock.get_elapsed_time();
+    passed = text.save_binary("gait_trial.fesp") && passed;
+
+    Profile binary;
+    Clock   binary_clock;
+    passed = binary.load_binary("gait_trial.fesp") && passed;
+    Time binary_time = binary_clock.get_elapsed_time();
+    LOG(Info) << "Loaded " << binary.get_channel_count() << " channels of " << binary.get_sample_count()
+              << " samples (" << binary.get_duration() << "): " << text_time << " from text, " << binary_time
+              << " mapped from binary";
+
+    // both have to give the same samples, and linear lookups land exactly on them
+    passed = passed && text.get_sample_count() == samples && binary.get_channel_count() == channels;
+    for (size_t c = 0; passed && c < channels; c++) {
+        for (size_t s = 0; s < samples; s += 997) {
+            double value;
+            passed = binary.sample(c, milliseconds(10 * s), value) && value == text.get_channel(c)[s] && passed;
+        }
+    }
+
+    // interpolation between samples, and each end policy past the last one
+    float   ramp[] = {0, 10, 20, 30};
+    Profile small;
+    double  value  = 0;
+    passed = small.set_samples(1, 4, milliseconds(100), ramp) && passed;
+    passed = small.sample(0, milliseconds(125), value) && std::fabs(value - 12.5) < 1e-9 && passed;
+    small.set_interpolation(Interpolation::Cubic);
+    passed = small.sample(0, milliseconds(125), value) && std::fabs(value - 12.5) < 1e-9 && passed;
+    small.set_interpolation(Interpolation::Nearest);
+    passed = small.sample(0, milliseconds(140), value) && value == 10 && passed;
+    passed = small.sample(0, seconds(1), value) && value == 30 && passed;
+    small.set_end_policy(ProfileEnd::Zero);
+    passed = small.sample(0, seconds(1), value) && value == 0 && passed;
+    small.set_end_policy(ProfileEnd::Loop);
+    passed = small.sample(0, milliseconds(500), value) && value == 10 && passed;
+    small.set_end_policy(ProfileEnd::Stop);
+    passed = !small.sample(0, seconds(1), value) && small.is_finished(seconds(1)) && passed;
+    print_var(passed);
+
+    double checksum = 0;
+    const Interpolation modes[] = {Interpolation::Nearest, Interpolation::Linear, Interpolation::Cubic};
+    const char*         names[] = {"nearest", "linear", "cubic"};
+    for (int m = 0; m < 3; m++) {
+        binary.set_interpolation(modes[m]);
+        LOG(Info) << "Looking up all " << channels << " channels (" << names[m]
+                  << "): " << time_lookups(binary, 1000000, checksum) << " ns";
+    }
+    // keeps the compiler from optimizing the timed calls away
+    print_var(checksum);
+
+    return passed ? 0 : 1;
+}
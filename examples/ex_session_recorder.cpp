@@ -0,0 +1,119 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+struct SessionSummary {
+    size_t        tx_frames     = 0;  // records written to the boards
+    size_t        rx_frames     = 0;  // replies received
+    size_t        rx_reads      = 0;  // reads as they came in
+    size_t        rx_read_bytes = 0;  // bytes in those reads
+    size_t        rx_bytes      = 0;  // bytes in the replies
+    size_t        pw_updates    = 0;  // change event params frames for the bicep
+    unsigned char last_pw       = 0;  // pulsewidth of the last of them
+    int64_t       duration_ns   = 0;  // time of the last record
+};
+
+// reads a session back, splitting each write into its frames to find what the bicep was sent
+bool summarize(const std::string& filename, unsigned char event_id, SessionSummary& summary) {
+    SessionReader reader;
+    if (!reader.open(filename)) return false;
+    SessionRecord record;
+    while (reader.next(record)) {
+        summary.duration_ns = record.time_ns;
+        if (record.direction == FrameDirection::RxRaw) {
+            summary.rx_reads++;
+            summary.rx_read_bytes += record.size;
+            continue;
+        }
+        if (record.direction == FrameDirection::Rx) {
+            summary.rx_frames++;
+            summary.rx_bytes += record.size;
+            continue;
+        }
+        summary.tx_frames++;
+        for (size_t pos = 0; pos + WRITE_HEADER_SIZE <= record.size;) {
+            const unsigned char* frame = record.bytes + pos;
+            if (frame[2] == CHANGE_EVENT_PARAMS_MSG && frame[4] == event_id) {
+                summary.pw_updates++;
+                summary.last_pw = frame[5];
+            }
+            pos += WRITE_HEADER_SIZE + frame[3] + 1;
+        }
+    }
+    return true;
+}
+
+int main() {
+    // the cost of recording a frame from the control loop
+    {
+        SessionRecorder recorder;
+        if (!recorder.open("recorder_benchmark.fes")) return 1;
+        unsigned char frame[] = {DEST_ADR, SRC_ADR, CHANGE_EVENT_PARAMS_MSG, CHANGE_EVENT_PARAMS_LEN, 1, 20, 50, 0, 0};
+        const int     frames  = 200000;
+        Clock         clock;
+        for (int i = 0; i < frames; i++) {
+            frame[5] = (unsigned char)i;
+            recorder.record(FrameDirection::Tx, 0, frame, sizeof(frame));
+        }
+        double ns = clock.get_elapsed_time().as_seconds() * 1e9 / frames;
+        LOG(Info) << "Recording a frame took " << ns << " ns. " << recorder.get_record_count() << " recorded in "
+                  << recorder.get_chunk_count() << " chunks, " << recorder.get_dropped_count()
+                  << " dropped waiting for the next chunk";
+    }
+
+    Emulator emulator;
+    if (!emulator.open()) return 1;
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel bicep("Bicep", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(bicep);
+    Channel tricep("Tricep", CH_2, AN_CA_2, 100, 250);
+    channels.push_back(tricep);
+
+    // record everything the stimulator sends and receives, from setup on
+    const std::string session = "session.fes";
+    SessionRecorder   recorder;
+    if (!recorder.open(session)) return 1;
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<RecordingTransport>(
+        std::make_shared<SerialTransport>(emulator.get_port_name()), &recorder, 0)};
+    Stimulator stim("Recorded", channels, transports, false);
+
+    bool success = stim.create_scheduler(0xAA, 40);
+    success      = success && stim.add_events(channels);
+    success      = success && stim.begin();
+    success      = success && stim.start_io_thread();
+
+    unsigned char last_pw = 0;
+    for (int i = 0; success && i < 100; i++) {
+        last_pw = (unsigned char)(10 + i % 40);
+        stim.write_pw(bicep, last_pw);
+        stim.write_pw(tricep, 60 - i % 40);
+        sleep(milliseconds(10));
+        // the file can be read while it is still being recorded, just as it would be after a crash
+        if (i == 50) {
+            SessionSummary partial;
+            success = summarize(session, 1, partial);
+            LOG(Info) << "Halfway, the recording already holds " << partial.tx_frames << " writes and "
+                      << partial.rx_frames << " replies";
+        }
+    }
+    stim.stop_io_thread();
+    stim.disable();
+    emulator.stop();
+    size_t recorded = recorder.get_record_count();
+    recorder.close();
+
+    SessionSummary summary;
+    success = success && summarize(session, 1, summary);
+    LOG(Info) << "Session of " << summary.duration_ns / 1e6 << " ms: " << summary.tx_frames << " writes, "
+              << summary.rx_frames << " replies in " << summary.rx_reads << " reads, " << summary.pw_updates
+              << " bicep updates";
+    // every byte of every reply was read, and the raw reads hold them along with anything else that came in
+    bool passed = success && summary.tx_frames + summary.rx_frames + summary.rx_reads == recorded &&
+                  summary.last_pw == last_pw && summary.rx_frames > 0 && summary.rx_read_bytes >= summary.rx_bytes;
+    print_var(passed);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// reads every command out of a session, skipping the ones that only repeat the setup
+bool read_commands(const std::string& filename, std::vector<ReplayCommand>& commands) {
+    SessionDecoder decoder;
+    if (!decoder.open(filename)) return false;
+    ReplayCommand command;
+    while (decoder.next(command)) commands.push_back(command);
+    return true;
+}
+
+// true if both sessions sent the same stimulation and schedule changes in the same order
+bool same_commands(const std::vector<ReplayCommand>& a, const std::vector<ReplayCommand>& b) {
+    if (a.size() != b.size()) {
+        LOG(Error) << "Sessions hold " << a.size() << " and " << b.size() << " commands";
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type || a[i].channel_num != b[i].channel_num || a[i].amplitude != b[i].amplitude ||
+            a[i].pulsewidth != b[i].pulsewidth || a[i].value != b[i].value) {
+            LOG(Error) << "Sessions differ at command " << i;
+            return false;
+        }
+    }
+    return true;
+}
+
+// sets up a stimulator on a new emulator that records everything it sends to filename
+struct Rig {
+    Emulator                         emulator;
+    SessionRecorder                  recorder;
+    std::vector<Channel>             channels;
+    std::unique_ptr<Stimulator>      stim;
+
+    bool open(const std::string& filename) {
+        if (!emulator.open() || !recorder.open(filename)) return false;
+        emulator.start();
+        channels.push_back(Channel("Bicep", CH_1, AN_CA_1, 100, 250));
+        channels.push_back(Channel("Tricep", CH_2, AN_CA_2, 100, 250));
+        std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<RecordingTransport>(
+            std::make_shared<SerialTransport>(emulator.get_port_name()), &recorder, 0)};
+        stim.reset(new Stimulator("Replay", channels, transports, false));
+        return stim->create_scheduler(0xAA, 40) && stim->add_events(channels) && stim->begin();
+    }
+
+    void close() {
+        stim->disable();
+        emulator.stop();
+        recorder.close();
+    }
+};
+
+int main() {
+    // the original session: a ramp on both channels, with a change of frequency and delay partway
+    Rig original;
+    if (!original.open("original.fes")) return 1;
+    bool success = true;
+    for (int i = 0; success && i < 300; i++) {
+        original.stim->set_amp(original.channels[0], 20 + i % 30);
+        original.stim->write_pw(original.channels[0], 10 + i % 40);
+        if (i % 3 == 0) original.stim->write_pw(original.channels[1], 50 - i % 40);
+        if (i == 100) success = original.stim->set_frequency(50);
+        if (i == 200) success = original.stim->set_event_delay(original.channels[1], 12);
+        success = success && original.stim->update();
+        sleep(milliseconds(2));
+    }
+    original.close();
+
+    std::vector<ReplayCommand> recorded;
+    success = success && read_commands("original.fes", recorded);
+    LOG(Info) << "Recorded " << recorded.size() << " commands over " << recorded.back().time_ns / 1e6 << " ms";
+
+    // replay it onto a new emulator as fast as possible and at the original speed, recording each again
+    const double speeds[] = {0, 1};
+    for (size_t s = 0; success && s < 2; s++) {
+        std::string replay_file = "replay_" + std::to_string(s) + ".fes";
+        Rig         replay;
+        if (!replay.open(replay_file)) return 1;
+        SessionDecoder source;
+        SessionReplay  player(*replay.stim);
+        player.set_speed(speeds[s]);
+        success = source.open("original.fes") && player.run(source);
+        SessionReplay::Stats stats = player.get_stats();
+        replay.close();
+
+        std::vector<ReplayCommand> replayed;
+        success = success && read_commands(replay_file, replayed) && same_commands(recorded, replayed);
+        LOG(Info) << "Speed " << speeds[s] << ": " << stats.commands << " commands in " << stats.elapsed
+                  << ", at most " << stats.max_lateness << " late, " << stats.unknown << " for unknown channels";
+    }
+
+    // a hand-written command file goes through the same path
+    {
+        std::ofstream file("commands.txt");
+        file << "# time (s), channel, amplitude, pulsewidth\n0.00, 0, 30, 20\n0.01, 1, 30, 25\n0.02, 0, 40, 30\n";
+    }
+    Rig typed;
+    if (!typed.open("typed.fes")) return 1;
+    CommandFile   commands;
+    SessionReplay player(*typed.stim);
+    success = success && commands.open("commands.txt") && player.run(commands) && player.get_stats().commands == 3;
+    std::vector<ChannelState> snapshot;
+    typed.stim->get_snapshot(snapshot);
+    success = success && snapshot[0].amplitude == 40 && snapshot[0].pulsewidth == 30 && snapshot[1].pulsewidth == 25;
+    typed.close();
+
+    print_var(success);
+    return success ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// the shortest time between any two pulses in the period (across both boards), which is when the
+// most current is drawn at once. Equal delays on different boards mean pulses on top of each other
+unsigned int closest_pulses(const std::vector<unsigned int>& delays, unsigned int duration) {
+    std::vector<unsigned int> sorted = delays;
+    std::sort(sorted.begin(), sorted.end());
+    unsigned int closest = duration - sorted.back() + sorted.front();
+    for (size_t i = 1; i < sorted.size(); i++) closest = std::min(closest, sorted[i] - sorted[i - 1]);
+    return closest;
+}
+
+void show(const char* name, SlotPolicy policy, const std::vector<Channel>& channels, unsigned int duration) {
+    SlotAllocator             slots(policy);
+    std::vector<unsigned int> delays;
+    if (!slots.allocate(channels, duration, delays)) {
+        LOG(Info) << name << " at " << duration << " ms: does not fit";
+        return;
+    }
+    std::string line;
+    for (size_t i = 0; i < delays.size(); i++) line += std::to_string(delays[i]) + " ";
+    LOG(Info) << name << " at " << duration << " ms: delays " << line << "(closest pulses " << closest_pulses(delays, duration)
+              << " ms)";
+}
+
+int main() {
+    // eight channels over two boards. The last two have long pulses that take more than 5 ms slots
+    std::vector<Channel> channels;
+    const unsigned char channel_nums[] = {CH_1, CH_2, CH_3, CH_4, CH_5, CH_6, CH_7, CH_8};
+    for (size_t i = 0; i < 8; i++) {
+        unsigned int ip_delay = i < 6 ? 100 : 6000;
+        channels.push_back(Channel("Channel " + std::to_string(i + 1), channel_nums[i], AN_CA_1, 100, 250, ip_delay));
+    }
+
+    SlotAllocator slots;
+    print_var(slots.get_slot_width(channels[0]));
+    print_var(slots.get_slot_width(channels[7]));
+
+    const unsigned int durations[] = {100, 40, 25, 20};
+    for (size_t d = 0; d < sizeof(durations) / sizeof(durations[0]); d++) {
+        show("Packed", SlotPolicy::Packed, channels, durations[d]);
+        show("Spread", SlotPolicy::Spread, channels, durations[d]);
+        show("Interleaved", SlotPolicy::Interleaved, channels, durations[d]);
+    }
+
+    // with the old fixed 5 ms spacing, the last of these would have run past the end of a 20 ms period
+    std::vector<Channel> board_1(channels.begin() + 4, channels.end());
+    std::vector<unsigned int> delays;
+    bool fits = slots.allocate(board_1, 20, delays);
+    print_var(fits);
+
+    return 0;
+}
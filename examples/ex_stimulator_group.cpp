@@ -0,0 +1,71 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+int main() {
+    // two stimulators (eg. one per arm) with two emulated boards each: 16 channels in all
+    const size_t num_boards = 4;
+    Emulator     boards[num_boards];
+    for (size_t i = 0; i < num_boards; i++) {
+        if (!boards[i].open()) return 1;
+        boards[i].start();
+    }
+
+    const char* muscles[] = {"Bicep", "Tricep", "Forearm", "Wrist", "Deltoid", "Pec", "Trap", "Lat"};
+    const unsigned char channel_nums[] = {CH_1, CH_2, CH_3, CH_4, CH_5, CH_6, CH_7, CH_8};
+    const unsigned char anodes[] = {AN_CA_1, AN_CA_2, AN_CA_3, AN_CA_4};
+    std::vector<Channel> left_channels;
+    std::vector<Channel> right_channels;
+    for (size_t i = 0; i < 8; i++) {
+        left_channels.push_back(Channel(std::string("Left ") + muscles[i], channel_nums[i], anodes[i % 4], 100, 250));
+        right_channels.push_back(Channel(std::string("Right ") + muscles[i], channel_nums[i], anodes[i % 4], 100, 250));
+    }
+
+    Stimulator left("Left", left_channels, std::vector<std::string>{boards[0].get_port_name(), boards[1].get_port_name()});
+    Stimulator right("Right", right_channels, std::vector<std::string>{boards[2].get_port_name(), boards[3].get_port_name()});
+
+    StimulatorGroup group("Bilateral");
+    group.add(&left);
+    group.add(&right);
+
+    // all four boards are started within 200 us of each other, and brought back in phase every 10 s
+    group.set_max_sync_skew(microseconds(200));
+    group.set_resync_interval(seconds(10));
+
+    bool success = group.create_scheduler(0xAA, 40);
+    success      = success && left.add_events(left_channels) && right.add_events(right_channels);
+    success      = success && group.begin();
+
+    // one thread and one timer update all four boards every period. The thread is pinned to cpu 1
+    // only if there is more than one
+    int io_cpu = std::thread::hardware_concurrency() > 1 ? 1 : -1;
+    success    = success && group.start_io_thread(ThreadSettings(io_cpu, ThreadPriority::Realtime));
+
+    Timer timer(milliseconds(1), Timer::WaitMode::Hybrid);
+    for (int i = 0; success && i < 2000; i++) {
+        for (size_t c = 0; c < 8; c++) {
+            left.write_pw(left_channels[c], 10 + (i + c) % 20);
+            right.write_pw(right_channels[c], 30 - (i + c) % 20);
+        }
+        success = group.update();
+        timer.wait();
+    }
+
+    group.stop_io_thread();
+
+    print_var(success);
+    print_var(group.get_sync_skew());
+    print_var(group.get_max_sync_skew());
+    for (size_t i = 0; i < num_boards; i++) {
+        LOG(Info) << "Board " << i << " pulses: " << boards[i].get_pulse_count(0) << " " << boards[i].get_pulse_count(1)
+                  << " " << boards[i].get_pulse_count(2) << " " << boards[i].get_pulse_count(3);
+    }
+
+    group.disable();
+    for (size_t i = 0; i < num_boards; i++) boards[i].stop();
+
+    return success ? 0 : 1;
+}
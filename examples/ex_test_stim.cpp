@@ -60,35 +60,25 @@ int main() {
         visualizer.run();
     });
 
-    Clock test_clock;
-
     // start sending stimulation to the board
     stim.begin();
 
-    // set timer for our control loop
-    Timer timer(milliseconds(25), Timer::WaitMode::Hybrid);
-    timer.set_acceptable_miss_rate(0.05);
-    
-    // variable to keep track of our current time
-    double t(0.0);
+    // the control loop runs once per schedule period, waking just before each period starts
+    ControlLoop loop(stim, Timer::WaitMode::Hybrid);
 
     enable_realtime();
 
-    while (!stop) {
-        {
-            // update the pulsewidth of each of the stimulation events
-            stim.set_amp(bicep, 60);
-            stim.write_pw(bicep, 10 + int(10 * sin(t)));
-
-            // command the stimulation patterns to be sent to the stim board.
-            // This is required whether using the gui or updating in code.
-            test_clock.restart();
-            stim.update();
-            print_var(test_clock.get_elapsed_time().as_microseconds());
-        }
-        // wait for the loop to end
-        t = timer.wait().as_seconds();
-    }
+    // the loop calls stim.update() after each step to command the stimulation patterns to be sent to
+    // the stim board. This is required whether using the gui or updating in code.
+    loop.run([&](Time t) {
+        // update the pulsewidth of each of the stimulation events
+        stim.set_amp(bicep, 60);
+        stim.write_pw(bicep, 10 + int(10 * sin(t.as_seconds())));
+        return !stop;
+    });
+
+    print_var(loop.get_stats().missed);
+    print_var(loop.get_stats().max_lateness);
 
     // disable events, schedulers, boards, etc
     stim.disable();
@@ -0,0 +1,153 @@
+#include <Mahi/Fes.hpp>
+#include <Mahi/Util.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::fes;
+
+// writes value into data as a big-endian double, the way the motion capture PC sends it
+void encode_angle(double value, unsigned char* data) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 7; i >= 0; i--, bits >>= 8) data[i] = (unsigned char)(bits & 0xFF);
+}
+
+// Stands in for the limb and the motion capture PC: the angle follows the pulsewidth with a lag and an
+// offset the feedforward does not know about, and is sent over loopback every ms
+class Sender {
+public:
+    Sender(unsigned short port) : m_pw(0), m_stop(false), m_sent(0) {
+        m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        std::memset(&m_target, 0, sizeof(m_target));
+        m_target.sin_family = AF_INET;
+        m_target.sin_port   = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &m_target.sin_addr);
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    ~Sender() {
+        m_stop = true;
+        m_thread.join();
+        ::close(m_socket);
+    }
+
+    std::atomic<int>    m_pw;    // pulsewidth last commanded
+    std::atomic<bool>   m_stop;  // stops the sender
+    std::atomic<size_t> m_sent;  // datagrams sent
+
+private:
+    void run() {
+        double angle = 0;
+        Timer  timer(milliseconds(1), Timer::WaitMode::Hybrid);
+        while (!m_stop) {
+            angle += (0.8 * m_pw - 10 - angle) * 0.001 / 0.1;
+            unsigned char datagram[8];
+            encode_angle(angle, datagram);
+            sendto(m_socket, datagram, sizeof(datagram), 0, reinterpret_cast<sockaddr*>(&m_target), sizeof(m_target));
+            m_sent++;
+            timer.wait();
+        }
+    }
+
+    int         m_socket;
+    sockaddr_in m_target;
+    std::thread m_thread;
+};
+
+// tracks the desired angle for duration with the given gains and returns the mean absolute error
+double track(double kp, double ki, Time duration) {
+    Emulator emulator;
+    if (!emulator.open()) return -1;
+    emulator.start();
+
+    std::vector<Channel> channels;
+    Channel quad("Quadriceps", CH_1, AN_CA_1, 100, 250);
+    channels.push_back(quad);
+    std::vector<std::shared_ptr<Transport>> transports = {std::make_shared<SerialTransport>(emulator.get_port_name())};
+    Stimulator stim("UDP Feedback", channels, transports, false);
+    stim.create_scheduler(0xAA, 50);
+    stim.add_events(channels);
+    stim.begin();
+    stim.set_amp(quad, 50);
+
+    // the desired knee angle, and the open-loop pulsewidth that would give it without the offset
+    const size_t       samples = 1001;
+    std::vector<float> desired(samples), feedforward(samples);
+    for (size_t s = 0; s < samples; s++) {
+        desired[s]     = (float)(30 + 20 * std::sin(2 * PI * 0.5 * s * 0.01));
+        feedforward[s] = desired[s] / 0.8f;
+    }
+    Profile desired_profile, feedforward_profile;
+    desired_profile.set_samples(1, samples, milliseconds(10), &desired[0]);
+    feedforward_profile.set_samples(1, samples, milliseconds(10), &feedforward[0]);
+
+    UdpFeedback feedback(SampleDecoder(SampleEncoding::Float64BigEndian));
+    if (!feedback.open(0, "127.0.0.1")) return -1;
+    Sender sender(feedback.get_port());
+
+    // PI on the angle error on top of the feedforward, once per schedule period
+    double      integral = 0, error_sum = 0;
+    size_t      ticks    = 0;
+    const double dt      = stim.get_period().as_seconds();
+    ControlLoop loop(stim);
+    loop.run([&](Time t) {
+        feedback.poll();
+        FeedbackSample sample;
+        double         target, open_loop;
+        if (!feedback.get_latest(sample) || !desired_profile.sample(0, t, target) ||
+            !feedforward_profile.sample(0, t, open_loop)) {
+            return t < duration;
+        }
+        double error = target - sample.value;
+        double pw    = open_loop + kp * error + ki * integral;
+        // only integrate while the output is not saturated, so the integral does not wind up
+        if (pw > 0 && pw < quad.get_max_pulse_width()) integral += error * dt;
+        pw = std::max(0.0, std::min(pw, (double)quad.get_max_pulse_width()));
+        stim.write_pw(quad, (unsigned int)std::lround(pw));
+        sender.m_pw = (int)std::lround(pw);
+        // the first second is left out while the limb settles
+        if (t > seconds(1)) {
+            error_sum += std::fabs(error);
+            ticks++;
+        }
+        return t < duration;
+    });
+
+    ControlLoop::Stats stats = loop.get_stats();
+    LOG(Info) << "kp " << kp << ", ki " << ki << ": " << stats.ticks << " periods, " << sender.m_sent << " sent, "
+              << feedback.get_received_count() << " received, " << feedback.get_superseded_count()
+              << " superseded by a fresher angle, " << stats.missed << " missed periods";
+    stim.disable();
+    emulator.stop();
+    return ticks > 0 ? error_sum / ticks : -1;
+}
+
+int main() {
+    // the decoder against every layout, and a datagram too short to hold a value
+    bool          passed = true;
+    unsigned char data[12];
+    double        value  = 0;
+    encode_angle(42.125, data);
+    passed = SampleDecoder(SampleEncoding::Float64BigEndian).decode(data, 8, value) && value == 42.125 && passed;
+    std::reverse(data, data + 8);
+    passed = SampleDecoder(SampleEncoding::Float64LittleEndian).decode(data, 8, value) && value == 42.125 && passed;
+    float single = -7.5f;
+    std::memcpy(data + 4, &single, sizeof(single));
+    passed = SampleDecoder(SampleEncoding::Float32LittleEndian, 4).decode(data, 8, value) && value == -7.5 && passed;
+    passed = !SampleDecoder(SampleEncoding::Float64BigEndian).decode(data, 7, value) && passed;
+
+    double open_loop_error = track(0, 0, seconds(4));
+    double pi_error        = track(1.0, 4.0, seconds(4));
+    LOG(Info) << "Mean tracking error: " << open_loop_error << " deg open loop, " << pi_error << " deg with PI";
+    passed = passed && open_loop_error > 0 && pi_error >= 0 && pi_error < open_loop_error;
+    print_var(passed);
+    return passed ? 0 : 1;
+}
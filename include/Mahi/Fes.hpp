@@ -17,13 +17,45 @@
 #pragma once
 
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/ChannelStore.hpp>
+#include <Mahi/Fes/Core/CommandQueue.hpp>
+#include <Mahi/Fes/Core/ControlLoop.hpp>
+#include <Mahi/Fes/Core/ControllerBank.hpp>
+#include <Mahi/Fes/Core/Crc.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <Mahi/Fes/Core/IterativeLearning.hpp>
+#include <Mahi/Fes/Core/LatencyHistogram.hpp>
+#include <Mahi/Fes/Core/Mailbox.hpp>
 #include <Mahi/Fes/Core/Message.hpp>
+#include <Mahi/Fes/Core/MpscRing.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Core/Scheduler.hpp>
+#include <Mahi/Fes/Core/SessionReplay.hpp>
+#include <Mahi/Fes/Core/SlotAllocator.hpp>
+#include <Mahi/Fes/Core/SpscRing.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Fes/Core/StimulatorGroup.hpp>
+#include <Mahi/Fes/Core/SyncCoordinator.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
 #include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
+#ifndef _WIN32
+#include <Mahi/Fes/Utility/Emulator.hpp>
+#endif
+#include <Mahi/Fes/Utility/MappedFile.hpp>
+#include <Mahi/Fes/Utility/NullTransport.hpp>
+#include <Mahi/Fes/Utility/PortPoller.hpp>
+#include <Mahi/Fes/Utility/Profile.hpp>
+#include <Mahi/Fes/Utility/RecordingTransport.hpp>
+#include <Mahi/Fes/Utility/SerialTransport.hpp>
+#include <Mahi/Fes/Utility/SessionRecorder.hpp>
+#include <Mahi/Fes/Utility/Thread.hpp>
+#ifndef _WIN32
+#include <Mahi/Fes/Utility/UdpFeedback.hpp>
+#endif
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Fes/Utility/VirtualStim.hpp>
 #include <Mahi/Fes/Utility/Visualizer.hpp>
\ No newline at end of file
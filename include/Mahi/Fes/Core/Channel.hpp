@@ -16,8 +16,7 @@
 
 #pragma once
 
-#include <Windows.h>
-
+#include <Mahi/Fes/Core/Transport.hpp>
 #include <Mahi/Util.hpp>
 #include <string>
 
@@ -51,19 +50,24 @@ public:
     /// Channel destructor
     ~Channel();
     /// writes the channel setup command to the UECU given the constructor parameters.
-    bool setup_channel(HANDLE serial_handle_, mahi::util::Time delay_time_);
+    bool setup_channel(Transport* transport_, mahi::util::Time delay_time_);
     /// return the max amplitude allowed by the channel
-    unsigned int get_max_amplitude();
+    unsigned int get_max_amplitude() const;
     /// return the max pulsewidth allowed by the channel
-    unsigned int get_max_pulse_width();
+    unsigned int get_max_pulse_width() const;
+    /// return the interphase delay of the channel (us)
+    unsigned int get_ip_delay() const;
+    /// return the longest a pulse on the channel can take (us): the stimulating phase at the max
+    /// pulsewidth, the interphase delay, and the recovery phase stretched by the aspect ratio
+    unsigned int get_pulse_duration() const;
     /// return the board number for the channel (0 or 1)
-    unsigned char get_board_num();
+    unsigned char get_board_num() const;
     /// return the internal channel number with respect to its board (0 through 3)
-    unsigned char get_board_channel_num();
+    unsigned char get_board_channel_num() const;
     /// return the channel number of the channel (0 through 7)
-    unsigned char get_channel_num();
+    unsigned char get_channel_num() const;
     /// return the name of the channel
-    std::string get_channel_name();
+    const std::string& get_channel_name() const;
     /// set the maximum allowed amplitude for the channel
     void set_max_amplitude(unsigned int);
     /// set the maximum allowed pulsewidth for the channel
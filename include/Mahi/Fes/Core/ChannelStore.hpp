@@ -0,0 +1,140 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace mahi {
+namespace fes {
+
+/// returns the index of the lowest set bit of mask, which must not be 0
+inline unsigned int lowest_set_bit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+/// The one copy of the runtime state of every channel: amplitude, pulsewidth, their limits, and the
+/// values last sent to the UECU. It is laid out as a structure of arrays indexed by channel number,
+/// one byte per channel (the UECU only takes one byte for each), packed eight channels to an atomic
+/// word so that whole fields can be read at once. Events, the Scheduler, the Stimulator and the
+/// Visualizer all read and write through this store instead of keeping copies.
+///
+/// Writers are serialized with a mutex and bump a sequence number around each change (a seqlock),
+/// so get_snapshot can take a consistent copy of every channel without ever blocking a writer.
+class ChannelStore {
+public:
+    static const size_t CAPACITY = 32;             // number of channel numbers the store can hold
+    static const size_t WORDS    = CAPACITY / 8;   // number of 8-channel words in each field
+
+    /// A consistent copy of every channel at one point in time
+    struct Snapshot {
+        uint32_t      present;                     // bit i is set if channel i has been added
+        uint32_t      dirty;                       // bit i is set if channel i differs from what was last sent
+        unsigned char amplitude[CAPACITY];         // current amplitude of each channel
+        unsigned char pulsewidth[CAPACITY];        // current pulsewidth of each channel
+        unsigned char max_amplitude[CAPACITY];     // max amplitude allowed on each channel
+        unsigned char max_pulse_width[CAPACITY];   // max pulsewidth allowed on each channel
+        uint64_t      sequence;                    // sequence number the snapshot was taken at
+    };
+
+    /// ChannelStore constructor (no channels)
+    ChannelStore();
+    /// adds (or re-adds) a channel with its limits and initial values, which count as already sent
+    bool add_channel(unsigned char channel_num, unsigned int max_amplitude, unsigned int max_pulse_width,
+                     unsigned int amplitude = 0, unsigned int pulsewidth = 0);
+    /// drops a channel that was added, leaving its values behind until it is added again
+    void remove_channel(unsigned char channel_num);
+    /// returns whether the channel has been added
+    bool has_channel(unsigned char channel_num) const;
+    /// sets the amplitude and pulsewidth of a channel, each clamped to its limit, and counts them as
+    /// already sent. The limits are left as they are
+    void reset_values(unsigned char channel_num, unsigned int amplitude, unsigned int pulsewidth);
+    /// sets the amplitude of a channel. The caller is responsible for clamping it to the limit
+    void set_amplitude(unsigned char channel_num, unsigned int amplitude);
+    /// sets the pulsewidth of a channel. The caller is responsible for clamping it to the limit
+    void set_pulsewidth(unsigned char channel_num, unsigned int pulsewidth);
+    /// sets the pulsewidths of count channels in one change, each clamped to its limit. Channels that
+    /// have not been added are skipped. Returns false if any were skipped
+    bool set_pulsewidths(const unsigned char* channel_nums, const unsigned int* pulsewidths, size_t count);
+    /// sets the max amplitude of a channel, lowering the current amplitude if it is now too high
+    void set_max_amplitude(unsigned char channel_num, unsigned int max_amplitude);
+    /// sets the max pulsewidth of a channel, lowering the current pulsewidth if it is now too high
+    void set_max_pulse_width(unsigned char channel_num, unsigned int max_pulse_width);
+    /// returns the current amplitude of a channel
+    unsigned int get_amplitude(unsigned char channel_num) const;
+    /// returns the current pulsewidth of a channel
+    unsigned int get_pulsewidth(unsigned char channel_num) const;
+    /// returns the max amplitude of a channel
+    unsigned int get_max_amplitude(unsigned char channel_num) const;
+    /// returns the max pulsewidth of a channel
+    unsigned int get_max_pulse_width(unsigned char channel_num) const;
+    /// returns whether the amplitude or pulsewidth of a channel differs from what was last sent
+    bool is_dirty(unsigned char channel_num) const;
+    /// returns a mask with bit i set if channel i differs from what was last sent. All channels are
+    /// compared at once, eight to a word, so a tick with no changes costs a few instructions
+    uint32_t get_dirty_mask() const;
+    /// records the values that were just sent for a channel. Only the thread sending updates calls this
+    void mark_sent(unsigned char channel_num, unsigned int amplitude, unsigned int pulsewidth);
+    /// copies every channel into snapshot. Never blocks; retries if a writer was mid-change
+    void get_snapshot(Snapshot& snapshot) const;
+    /// returns the number of changes made to the store so far
+    uint64_t get_sequence() const;
+
+private:
+    typedef std::atomic<uint64_t> Field[WORDS];
+
+    /// returns a mask with bit i set if byte i of word is not zero
+    static uint32_t nonzero_bytes(uint64_t word);
+    /// returns byte channel_num of field
+    static unsigned char load_byte(const Field& field, unsigned char channel_num);
+    /// sets byte channel_num of field (writer lock held)
+    static void store_byte(Field& field, unsigned char channel_num, unsigned int value);
+    /// starts a change (writer lock held)
+    void begin_write();
+    /// finishes a change (writer lock held)
+    void end_write();
+
+    // the fields written by setters, the values written by the sending thread, and the sequence
+    // number each get their own cache lines. This is done with padding rather than alignas so the
+    // store (and the Scheduler and Stimulator holding it) are not over-aligned for plain new
+    Field                 m_amplitude;        // current amplitude of each channel
+    Field                 m_pulsewidth;       // current pulsewidth of each channel
+    Field                 m_max_amplitude;    // max amplitude of each channel
+    Field                 m_max_pulse_width;  // max pulsewidth of each channel
+    char                  m_pad_values[64];
+    Field                 m_sent_amplitude;   // amplitude last sent for each channel
+    Field                 m_sent_pulsewidth;  // pulsewidth last sent for each channel
+    std::atomic<uint32_t> m_present;          // bit i is set if channel i has been added
+    char                  m_pad_sent[64];
+    std::atomic<uint64_t> m_sequence;         // odd while a writer is mid-change
+    std::mutex            m_write_mtx;        // serializes writers
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Util.hpp>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Outcome of a command sent through a CommandQueue
+struct CommandResult {
+    bool      success;  // whether the matching reply arrived
+    ReadFrame reply;    // the matching reply (empty unless success)
+};
+
+/// Describes the reply that completes a command. Replies do not carry a sequence number, so a reply
+/// goes to the oldest outstanding command whose ReplyMatch it satisfies
+struct ReplyMatch {
+    /// ReplyMatch constructor. data_index of -1 matches any reply of the given type
+    ReplyMatch(unsigned char type_, int data_index_ = -1, unsigned char value_ = 0) :
+        type(type_), data_index(data_index_), value(value_) {}
+
+    unsigned char type;        // reply type that completes the command
+    int           data_index;  // byte of the reply data that must equal value, or -1 for any
+    unsigned char value;       // value required at data_index
+};
+
+/// Sends commands that the UECU replies to (eg. create schedule, create event) on one port and
+/// matches the replies back to them, so that several commands can be outstanding at once instead
+/// of waiting a full round trip for each. Each command resolves a future (and optional callback)
+/// when its reply arrives, or with success = false once it runs out of retries. A command is resent
+/// if the UECU reports an error for it or if it times out, so commands that are not safe to repeat
+/// (a create that timed out may still have been carried out) go through submit_once. The queue is
+/// driven by poll or wait_all from a single thread.
+class CommandQueue {
+public:
+    typedef std::function<void(const CommandResult&)> Callback;
+
+    /// CommandQueue constructor. The parser (the transport's own unless one is given) is shared with
+    /// whatever reads the port afterwards so that a partly received reply is never lost
+    CommandQueue(Transport* transport_ = nullptr, FrameParser* parser_ = nullptr);
+    /// the queue holds promises, so it cannot be copied
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+    /// sets the port the queue sends on and reads from. Only call while nothing is outstanding
+    void set_transport(Transport* transport_, FrameParser* parser_ = nullptr);
+    /// sets how long each command waits for its reply before it is retried
+    void set_timeout(mahi::util::Time timeout_);
+    /// sets how many times a command is resent before it fails
+    void set_max_retries(size_t max_retries_);
+    /// sets how many commands may be waiting on replies at once. More are sent as replies come in
+    void set_max_outstanding(size_t max_outstanding_);
+    /// queues size bytes of a finalized frame to be sent, completed by the reply described by match
+    std::future<CommandResult> submit(const unsigned char* bytes, size_t size, const ReplyMatch& match,
+                                      Callback callback = Callback());
+    /// finalizes and queues a frame to be sent, completed by the reply described by match
+    template <unsigned char MsgType, unsigned char MsgLen>
+    std::future<CommandResult> submit(WriteFrame<MsgType, MsgLen>& frame, const ReplyMatch& match,
+                                      Callback callback = Callback()) {
+        frame.finalize();
+        return submit(frame.get_bytes(), frame.get_size(), match, callback);
+    }
+    /// queues size bytes of a finalized frame like submit, but the command is never resent: it fails
+    /// as soon as it times out or the UECU reports an error. Use it for commands that must not run
+    /// twice, such as creating a schedule or an event
+    std::future<CommandResult> submit_once(const unsigned char* bytes, size_t size, const ReplyMatch& match,
+                                           Callback callback = Callback());
+    /// finalizes and queues a frame like submit, but the command is never resent (see above)
+    template <unsigned char MsgType, unsigned char MsgLen>
+    std::future<CommandResult> submit_once(WriteFrame<MsgType, MsgLen>& frame, const ReplyMatch& match,
+                                           Callback callback = Callback()) {
+        frame.finalize();
+        return submit_once(frame.get_bytes(), frame.get_size(), match, callback);
+    }
+    /// sends queued commands, reads replies for up to timeout, and retries or fails commands that
+    /// have waited too long. Returns whether any commands are still pending
+    bool poll(mahi::util::Time timeout = mahi::util::Time::Zero);
+    /// polls until every command has completed or failed. Returns whether they all succeeded
+    bool wait_all();
+    /// returns the number of commands that have not completed yet
+    size_t get_pending_count() const;
+    /// returns the number of times a command was resent
+    size_t get_retry_count() const;
+    /// returns the number of commands that failed
+    size_t get_failure_count() const;
+    /// returns the number of replies that did not match any outstanding command
+    size_t get_unmatched_count() const;
+
+private:
+    /// A command waiting to be sent or waiting on its reply
+    struct Command {
+        std::vector<unsigned char>   bytes;        // the whole frame
+        ReplyMatch                   match;        // the reply that completes the command
+        mahi::util::Clock            clock;        // restarted whenever the command is sent
+        size_t                       retries;      // number of times the command has been resent
+        size_t                       max_retries;  // times the command may be resent before it fails
+        std::promise<CommandResult>  promise;      // resolved when the command completes or fails
+        Callback                     callback;     // called when the command completes or fails
+    };
+
+    /// queues a command that may be resent up to max_retries times
+    std::future<CommandResult> enqueue(const unsigned char* bytes, size_t size, const ReplyMatch& match,
+                                       Callback callback, size_t max_retries);
+    /// sends waiting commands until max_outstanding are waiting on replies
+    bool send_waiting();
+    /// writes a command to the transport and restarts its clock
+    bool send(Command& command);
+    /// resends the outstanding command at index, or fails it if it is out of retries
+    void retry(size_t index, const char* reason);
+    /// completes the outstanding command at index and removes it
+    void complete(size_t index, bool success, const ReadFrame& reply);
+    /// hands a reply to the outstanding command it belongs to
+    void handle_reply(const ReadFrame& reply);
+    /// returns whether reply satisfies match
+    static bool matches(const ReplyMatch& match, const ReadFrame& reply);
+
+    Transport*           m_transport;        // port the commands are sent on
+    FrameParser*         m_parser;           // parser for the replies on the port
+    mahi::util::Time     m_timeout;          // time each command waits for its reply
+    size_t               m_max_retries;      // times a command is resent before it fails
+    size_t               m_max_outstanding;  // commands that may wait on replies at once
+    std::deque<Command>  m_waiting;          // commands not sent yet
+    std::deque<Command>  m_outstanding;      // commands sent and waiting on replies, oldest first
+    size_t               m_retry_count;      // number of resends
+    size_t               m_failure_count;    // commands that ran out of retries
+    size_t               m_unmatched_count;  // replies that did not match a command
+};
+
+}  // namespace fes
+}  // namespace mahi
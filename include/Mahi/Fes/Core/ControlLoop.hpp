@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Util.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+namespace mahi {
+namespace fes {
+
+/// Runs a control loop at the schedule period of a stimulator, replacing a hand-rolled Timer loop
+/// around Stimulator::update. The loop is phase-locked to the boards' schedules: it counts periods from
+/// when the sync message was sent, and wakes a set lead before each period starts, so every update
+/// lands just before the pulses it is meant for and update-to-pulse latency is the same every period.
+/// It follows changes of frequency and resyncs, and records how late it woke and how many periods it
+/// missed. When the stimulator's I/O thread is running, that thread decides when values go out, and the
+/// loop only paces the calls to set_amp and write_pw.
+class ControlLoop {
+public:
+    static const size_t HISTOGRAM_BINS = 32;  // number of bins in the lateness histogram
+
+    /// Timing of the loop since it started (or since reset_stats)
+    struct Stats {
+        size_t           ticks         = 0;                       // periods the step was run
+        size_t           missed        = 0;                       // updates that finished after their period started
+        size_t           skipped       = 0;                       // periods skipped because the loop fell behind
+        mahi::util::Time max_lateness  = mahi::util::Time::Zero;  // latest the loop woke after its deadline
+        mahi::util::Time mean_lateness = mahi::util::Time::Zero;  // average time the loop woke after its deadline
+        mahi::util::Time bin_width     = mahi::util::Time::Zero;  // lateness covered by each histogram bin
+        std::array<size_t, HISTOGRAM_BINS> lateness = {{}};       // wake-ups by lateness. The last bin holds the rest
+    };
+
+    /// called once per period with the time of the period's start since the loop began. Return false to stop
+    typedef std::function<bool(mahi::util::Time)> Step;
+
+    /// ControlLoop constructor. The stimulator must outlive the loop
+    ControlLoop(Stimulator& stimulator_, mahi::util::Timer::WaitMode mode_ = mahi::util::Timer::WaitMode::Hybrid);
+    /// sets how the loop waits: Busy spins, Sleep sleeps, and Hybrid sleeps until spin_time before the deadline and then spins
+    void set_wait_mode(mahi::util::Timer::WaitMode mode_);
+    /// sets how long before each period starts the loop wakes up to run the step and update (2 ms by default)
+    void set_lead(mahi::util::Time lead_);
+    /// sets how long before the deadline Hybrid stops sleeping and starts spinning (1 ms by default)
+    void set_spin_time(mahi::util::Time spin_time_);
+    /// sets the lateness covered by each histogram bin (10 us by default). Resets the stats
+    void set_bin_width(mahi::util::Time bin_width_);
+    /// runs step and then Stimulator::update once per period, until step returns false, stop is called,
+    /// update fails, or num_ticks periods have run (0 runs forever). Returns false if update failed
+    bool run(const Step& step_, size_t num_ticks = 0);
+    /// asks run to return after the current period. Safe to call from any thread or from the step
+    void stop();
+    /// returns whether run is running
+    bool is_running() const;
+    /// returns the timing of the loop. Safe to call from any thread
+    Stats get_stats() const;
+    /// clears the timing of the loop
+    void reset_stats();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// returns how many periods boundary must move on for its deadline to still be ahead of now
+    size_t periods_behind(Clock::time_point boundary, Clock::duration period, Clock::time_point now) const;
+    /// waits until deadline in the current wait mode
+    void wait_until(Clock::time_point deadline) const;
+
+    Stimulator&                 m_stimulator;  // stimulator updated by the loop
+    mahi::util::Timer::WaitMode m_mode;        // how the loop waits
+    Clock::duration             m_lead;        // time before each period starts that the loop wakes
+    Clock::duration             m_spin_time;   // time Hybrid spins for before each deadline
+    std::atomic<bool>           m_stop;        // asks run to return
+    std::atomic<bool>           m_running;     // whether run is running
+    mutable std::mutex          m_stats_mtx;   // protects m_stats and m_lateness_sum
+    Stats                       m_stats;       // timing of the loop
+    mahi::util::Time            m_lateness_sum;  // running sum for the mean lateness
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Fes/Utility/Profile.hpp>
+#include <Mahi/Util.hpp>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Gains and limits of one channel's controller. Outputs are pulsewidths (us)
+struct ControllerGains {
+    double kp                = 0;   // proportional gain (us per unit of error)
+    double ki                = 0;   // integral gain (us per unit of error per s)
+    double kd                = 0;   // derivative gain (us per unit of error per s), on the measurement
+    double derivative_filter = 0;   // time constant of the low-pass filter on the derivative (s). 0 does not filter
+    double feedforward_gain  = 1;   // scale on the feedforward profile
+    double rate_limit        = 0;   // fastest the output may change (us per s). 0 does not limit
+    double min_output        = 0;   // lowest output (us)
+    double max_output        = -1;  // highest output (us). Below zero uses the channel's max pulsewidth
+};
+
+/// Closed-loop control of the pulsewidths of any number of channels: feedforward from a profile plus
+/// PID feedback on a measurement, with anti-windup, output limits and rate limiting, and its own gains
+/// for each channel. Every per-channel quantity is kept in its own array, so once the references and
+/// feedforwards have been read from their profiles and the measurements screened, each tick is one
+/// branch-free pass over the arrays that the compiler vectorizes (GCC reports it with -fopt-info-vec),
+/// and the results go to the stimulator in one call by channel number.
+///
+/// The integrator only runs while the output is not held at a limit in the direction of the error
+/// (conditional integration), so it never winds up while a channel is saturated or rate limited.
+class ControllerBank {
+public:
+    /// ControllerBank constructor. The stimulator must outlive the bank
+    ControllerBank(Stimulator& stimulator_);
+
+    /// adds a controller for channel_ and returns its index, which is also where its measurement goes
+    size_t add_channel(const Channel& channel_, const ControllerGains& gains_ = ControllerGains());
+    /// changes the gains of controller index_. Returns false if there is no such controller
+    bool set_gains(size_t index_, const ControllerGains& gains_);
+    /// sets a fixed reference for controller index_, replacing any reference profile
+    bool set_setpoint(size_t index_, double setpoint_);
+    /// reads the reference of controller index_ from a channel of profile_ (which must outlive the bank)
+    bool set_reference(size_t index_, const Profile* profile_, size_t profile_channel_ = 0);
+    /// reads the feedforward of controller index_ from a channel of profile_, or none if profile_ is nullptr
+    bool set_feedforward(size_t index_, const Profile* profile_, size_t profile_channel_ = 0);
+
+    /// computes every controller's output at time_ (since the trial started) from measured_, which
+    /// holds one measurement per controller, and writes the outputs to the stimulator
+    void step(mahi::util::Time time_, const double* measured_);
+    /// computes every controller's output without writing them to the stimulator. A controller whose
+    /// measurement is not finite keeps its last output and state for that tick
+    void compute(mahi::util::Time time_, const double* measured_);
+    /// writes the last outputs computed to the stimulator
+    void apply();
+    /// clears the integrators, derivatives and rate limits, to start a new trial
+    void reset();
+
+    /// returns the number of controllers
+    size_t size() const;
+    /// returns the outputs of the last tick (us), one per controller
+    const double* get_outputs() const;
+    /// returns the errors (reference - measurement) of the last tick, one per controller
+    const double* get_errors() const;
+    /// returns the references of the last tick, one per controller
+    const double* get_references() const;
+
+private:
+    /// a channel of a profile that a controller reads from
+    struct Source {
+        const Profile* profile;  // profile read, or nullptr
+        size_t         channel;  // channel of the profile
+    };
+
+    Stimulator& m_stimulator;  // stimulator the outputs go to
+    int64_t     m_last_us;     // time of the last tick (us), or -1 before the first
+
+    // gains and limits, one element per controller
+    std::vector<double> m_kp, m_ki, m_kd, m_filter, m_ff_gain, m_rate, m_min, m_max;
+    // state, one element per controller
+    std::vector<double> m_reference;    // reference of the last tick
+    std::vector<double> m_feedforward;  // feedforward of the last tick
+    std::vector<double> m_error;        // error of the last tick
+    std::vector<double> m_integral;     // integral term (us)
+    std::vector<double> m_derivative;   // filtered derivative term (us)
+    std::vector<double> m_last_measured;  // measurement of the last tick
+    std::vector<double> m_measured;     // measurement of this tick, or the last one if it was not finite
+    std::vector<double> m_hold;         // 1 if this tick's measurement was not finite, 0 otherwise
+    std::vector<double> m_output;       // output of the last tick (us)
+    std::vector<Source> m_reference_source;    // where each reference comes from
+    std::vector<Source> m_feedforward_source;  // where each feedforward comes from
+    std::vector<unsigned char> m_channel_nums;  // channel of each controller
+    std::vector<unsigned int>  m_channel_max;   // max pulsewidth of each controller's channel
+    std::vector<unsigned int>  m_pulsewidths;   // outputs rounded to whole us
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,44 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <cstddef>
+
+#define CRC_SEED 0xFFFF  // seed value for doing the crc calculation
+#define CRC_POLY 0xA001  // poly value for doing the crc calculation
+
+namespace mahi {
+namespace fes {
+
+/// CRC-16 used by the UECU for its replies (poly 0xA001 reflected, seed 0xFFFF, no final xor; the same
+/// as CRC-16/MODBUS). Every variant below gives the same result and none of them allocate. To
+/// calculate a crc incrementally, pass the result for the earlier bytes as crc.
+
+/// calculates the CRC-16 with the fastest variant available for size bytes on this cpu
+unsigned short calc_crc16(const unsigned char* bytes, size_t size, unsigned short crc = CRC_SEED);
+/// calculates the CRC-16 one bit at a time (the reference implementation from the UECU manual)
+unsigned short crc16_bitwise(const unsigned char* bytes, size_t size, unsigned short crc = CRC_SEED);
+/// calculates the CRC-16 eight bytes at a time with slice-by-8 lookup tables
+unsigned short crc16_slice8(const unsigned char* bytes, size_t size, unsigned short crc = CRC_SEED);
+/// calculates the CRC-16 by folding 16 bytes at a time with carry-less multiplication (PCLMULQDQ).
+/// Falls back to crc16_slice8 if the cpu does not support it
+unsigned short crc16_clmul(const unsigned char* bytes, size_t size, unsigned short crc = CRC_SEED);
+/// returns whether crc16_clmul can use carry-less multiplication on this cpu
+bool crc16_clmul_supported();
+
+}  // namespace fes
+}  // namespace mahi
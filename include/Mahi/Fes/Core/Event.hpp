@@ -17,66 +17,109 @@
 #pragma once
 
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/ChannelStore.hpp>
+#include <Mahi/Fes/Core/CommandQueue.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 
-#define DELETE_EVENT_LEN        0x01
-#define CHANGE_EVENT_PARAMS_LEN 0x04
 #define STIM_EVENT              0x03
 
 namespace mahi {
 namespace fes {
 
+/// Snapshot of the commanded values on a single channel
+struct ChannelState {
+    unsigned char channel_num;      // channel number of the channel (0 through 7)
+    unsigned int  amplitude;        // current amplitude
+    unsigned int  pulsewidth;       // current pulsewidth
+    unsigned int  max_amplitude;    // max amplitude allowed on the channel
+    unsigned int  max_pulse_width;  // max pulsewidth allowed on the channel
+};
+
 /// An event controls what happens on a single channel in the scheduler. The scheduler must
 /// be created before an event can be added, because the event is takes the schedule id as
 /// a parameter. The event is the underlying mechanism that controls any real-time control,
 /// as parameters are changed using set_{parameter}, and update sends a message to the UECU
-/// with the actual update.
+/// with the actual update. The amplitude, pulsewidth and limits of the event live in a
+/// ChannelStore shared with the rest of the stimulator, so the event only keeps its setup.
 class Event {
 public:
-    /// Event constructor
-    Event(HANDLE& hComm, unsigned char schedule_id_, int delay_time_, Channel channel_, unsigned char event_id_,
+    /// Event constructor. The channel is added to store_ with the limits of channel_ and the initial
+    /// amplitude and pulsewidth. If store_ already has the channel, its limits are kept and only the
+    /// amplitude and pulsewidth are set. Nothing is sent until create_event is called (or
+    /// encode_create is sent through a CommandQueue)
+    Event(Transport* transport_, ChannelStore* store_, unsigned char schedule_id_, int delay_time_, Channel channel_, unsigned char event_id_,
           bool is_virtual_, unsigned int pulse_width_ = 0, unsigned int amplitude_ = 0,
           unsigned char event_type_ = STIM_EVENT, unsigned char priority_ = 0x00, unsigned char zone_ = 0x00);
     /// Event destructor
     ~Event();
     /// Sends the message to the UECU to create a new event given the constructor params
     bool create_event();
+    /// writes the create event message for the constructor params into frame
+    void encode_create(CreateEventFrame& frame) const;
+    /// returns the reply that acknowledges the create event message of this event
+    ReplyMatch get_create_reply() const;
+    /// takes the event id from the reply to the create event message. Returns whether it was created.
+    /// If it was not, a channel the constructor added to the store is removed again
+    bool handle_create_reply(const CommandResult& result);
+    /// returns whether the UECU created the event
+    bool is_created() const;
     /// Sends the message to the UECU to delete the event
     bool delete_event();
     /// Sends the edit event message given the current amplitude and pulsewidth values
     bool update();
+    /// returns whether the amplitude or pulsewidth changed since the last update was sent
+    bool is_dirty() const;
+    /// writes the edit event message for the current amplitude and pulsewidth values into buffer,
+    /// which must hold at least ChangeEventParamsFrame::SIZE bytes. Returns the number of bytes written
+    size_t encode_update(unsigned char* buffer);
+    /// marks the amplitude and pulsewidth values from the last encode_update as sent to the UECU
+    void mark_updated();
     /// returns the current amplitude
-    unsigned int get_amplitude();
+    unsigned int get_amplitude() const;
     /// returns the current pulsewidth
-    unsigned int get_pulsewidth();
+    unsigned int get_pulsewidth() const;
     /// returns the channel attached to this event
-    Channel get_channel();
+    const Channel& get_channel() const;
     /// returns the channel number of the channel attached to this event
-    unsigned char get_channel_num();
+    unsigned char get_channel_num() const;
     /// returns the name of the channel attached to this event
-    std::string get_channel_name();
+    const std::string& get_channel_name() const;
+    /// returns the maximum amplitude allowed on this event
+    unsigned int get_max_amplitude() const;
+    /// returns the maximum pulsewidth allowed on this event
+    unsigned int get_max_pulse_width() const;
+    /// returns a snapshot of the current values of this event
+    ChannelState get_state() const;
     /// sets the amplitude of the event (does not write to UECU)
     void set_amplitude(unsigned int amplitude_);
     /// sets the pulsewidth of the event (does not write to UECU)
     void set_pulsewidth(unsigned int pulse_width_);
     /// sets the event id as received in a message from the UECU after setting up
     void set_event_id(unsigned char event_id);
+    /// returns the delay of the event from the start of each schedule period (ms)
+    unsigned int get_delay() const;
+    /// sends the message to move the event to delay_time_ ms from the start of each schedule period.
+    /// The schedule keeps running, so stimulation is not interrupted
+    bool change_delay(unsigned int delay_time_);
 
 private:
-    HANDLE        m_hComm;            // serial handle to the appropriate UECU
+    /// removes the channel from the store if the constructor added it
+    void release_channel();
+
+    Transport*    m_transport;        // transport to the appropriate UECU
+    ChannelStore* m_store;            // store holding the amplitude, pulsewidth and limits of the channel
     unsigned char m_schedule_id;      // schedule id of the associated schedule
     unsigned int  m_delay_time;       // delay time from the beginning of the schedule (all events should be different)
     Channel       m_channel;          // channel attached to the event
-    unsigned int  m_pulse_width;      // current pulse-width value
-    unsigned int  m_amplitude;        // current amplitude value
-    unsigned int  m_last_pw;          // previous pulse-width value
-    unsigned int  m_last_amp;         // previous amplitude value
+    unsigned char m_encoded_pw;       // pulse-width value written by the last encode_update
+    unsigned char m_encoded_amp;      // amplitude value written by the last encode_update
     unsigned char m_event_type;       // event type associated to the event
     unsigned char m_priority;         // priority level for events (less has more priority)
     unsigned char m_event_id;         // event id returned from the UECU at event creation time
-    unsigned int  m_max_amplitude;    // max amplitude allowed for the evenet
-    unsigned int  m_max_pulse_width;  // max pulse width allowed for the event
     unsigned char m_zone;             // unused (should be 0x00)
     bool          m_is_virtual;       // determines whether or not to wait for return messages
+    bool          m_created;          // whether the UECU created the event
+    bool          m_added_channel;    // whether the constructor added the channel to the store
 };
 }  // namespace fes
 }  // namespace mahi
@@ -0,0 +1,153 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Crc.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <Mahi/Util.hpp>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#define WRITE_HEADER_SIZE   4     // dest, src, type, length
+#define READ_HEADER_SIZE    8     // Amulet command (2), Amulet address, Amulet length, src, dest, type, length
+#define READ_CRC_SIZE       2     // CRC-16 trailing every message from the UECU
+#define READ_FRAME_MAX_DATA 0x40  // largest data section accepted from the UECU
+
+namespace mahi {
+namespace fes {
+
+/// Non-owning view of a run of bytes, such as the data section of a frame. It is only valid for
+/// as long as the bytes it points to.
+struct ByteView {
+    const unsigned char* data;  // first byte of the view
+    size_t               size;  // number of bytes in the view
+
+    const unsigned char* begin() const { return data; }
+    const unsigned char* end() const { return data + size; }
+    unsigned char        operator[](size_t i) const { return data[i]; }
+    bool                 empty() const { return size == 0; }
+};
+
+/// returns the upper byte of a two byte value (sent first)
+inline unsigned char hi_byte(unsigned int value) { return (unsigned char)((value >> 8) & 0xFF); }
+/// returns the lower byte of a two byte value (sent second)
+inline unsigned char lo_byte(unsigned int value) { return (unsigned char)(value & 0xFF); }
+
+/// calculates the UECU checksum of size bytes: add each of the bytes, add the carry byte to the
+/// lower byte of the sum, then invert
+inline unsigned char calc_checksum(const unsigned char* bytes, size_t size) {
+    unsigned int sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += bytes[i];
+    }
+    return (unsigned char)(((0x00FF & sum) + (sum >> 8)) ^ 0xFF);
+}
+
+/// A message to the UECU with a fixed type and length, stored in place so that building and
+/// sending it never touches the heap. Fill in data(), then finalize() (or write(), which
+/// finalizes) to compute the checksum in place.
+template <unsigned char MsgType, unsigned char MsgLen>
+class WriteFrame {
+public:
+    static const size_t SIZE = WRITE_HEADER_SIZE + MsgLen + 1;  // header + data + checksum
+
+    /// WriteFrame constructor. Fills in the header and zeros the data
+    WriteFrame() {
+        m_bytes.fill(0x00);
+        m_bytes[0] = DEST_ADR;  // Destination
+        m_bytes[1] = SRC_ADR;   // Source
+        m_bytes[2] = MsgType;   // Msg type
+        m_bytes[3] = MsgLen;    // Msg len
+    }
+    /// returns the data section of the frame (MsgLen bytes)
+    unsigned char* data() { return &m_bytes[WRITE_HEADER_SIZE]; }
+    /// computes the checksum into the last byte of the frame
+    void finalize() { m_bytes[SIZE - 1] = calc_checksum(m_bytes.data(), SIZE - 1); }
+    /// returns the checksum byte (valid after finalize)
+    unsigned char get_checksum() const { return m_bytes[SIZE - 1]; }
+    /// returns the whole frame, including header and checksum
+    const unsigned char* get_bytes() const { return m_bytes.data(); }
+    /// returns the size of the whole frame, including header and checksum
+    size_t get_size() const { return SIZE; }
+    /// finalizes the frame and writes it to the transport, logging the activity unless it is "NONE"
+    bool write(Transport* transport, const char* activity = "NONE") {
+        finalize();
+        bool log_message = std::strcmp(activity, "NONE") != 0;
+        if (!transport->write(m_bytes.data(), SIZE)) {
+            if (log_message) LOG(Error) << "Error " << activity;
+            return false;
+        }
+        if (log_message) LOG(Info) << activity << " was Successful.";
+        return true;
+    }
+
+private:
+    std::array<unsigned char, SIZE> m_bytes;  // the whole frame
+};
+
+template <unsigned char MsgType, unsigned char MsgLen>
+const size_t WriteFrame<MsgType, MsgLen>::SIZE;
+
+typedef WriteFrame<CHANNEL_SETUP_MSG, CH_SET_LEN>                    ChannelSetupFrame;
+typedef WriteFrame<CREATE_SCHEDULE_MSG, CREATE_SCHED_LEN>            CreateScheduleFrame;
+typedef WriteFrame<DELETE_SCHEDULE_MSG, DEL_SCHED_LEN>               DeleteScheduleFrame;
+typedef WriteFrame<CREATE_EVENT_MSG, CR_EVT_LEN>                     CreateEventFrame;
+typedef WriteFrame<DELETE_EVENT_MSG, DELETE_EVENT_LEN>               DeleteEventFrame;
+typedef WriteFrame<CHANGE_EVENT_PARAMS_MSG, CHANGE_EVENT_PARAMS_LEN> ChangeEventParamsFrame;
+typedef WriteFrame<CHANGE_SCHEDULE_MSG, CHANGE_SCHED_LEN>            ChangeScheduleFrame;
+typedef WriteFrame<CHANGE_EVENT_SCHED_MSG, CHANGE_EVENT_SCHED_LEN>   ChangeEventSchedFrame;
+typedef WriteFrame<SYNC_MSG, SYNC_MSG_LEN>                           SyncFrame;
+typedef WriteFrame<HALT_MSG, HALT_LEN>                               HaltFrame;
+
+/// A message from the UECU stored in a fixed-size buffer large enough for any reply, so that
+/// replies can be received, validated, and queued without heap allocation. See ReadMessage for
+/// the layout of the bytes.
+class ReadFrame {
+public:
+    static const size_t MAX_SIZE = READ_HEADER_SIZE + READ_FRAME_MAX_DATA + READ_CRC_SIZE;
+
+    /// ReadFrame constructor (empty frame)
+    ReadFrame();
+    /// copies a complete message into the frame. Returns false if it does not fit
+    bool assign(const unsigned char* bytes, size_t size);
+    /// returns the whole message, including header and crc
+    const unsigned char* get_bytes() const;
+    /// returns the size of the whole message, including header and crc
+    size_t get_size() const;
+    /// returns the type of the message (0x00 if the frame is too short to have one)
+    unsigned char get_type() const;
+    /// returns a view of the message data (without header or crc)
+    ByteView get_data() const;
+    /// returns the crc stored at the end of the message
+    unsigned short get_crc() const;
+    /// calculates the crc of the message
+    unsigned short calc_crc() const;
+    /// checks the crc and that the type is one the UECU sends, without logging
+    bool is_valid() const;
+
+private:
+    std::array<unsigned char, MAX_SIZE> m_bytes;  // the whole message
+    size_t                              m_size;   // number of bytes in use
+};
+
+/// returns whether the message type is one that the UECU sends to the host
+bool is_reply_type(unsigned char msg_type);
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/LatencyHistogram.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Util.hpp>
+
+namespace mahi {
+namespace fes {
+
+/// Resumable parser for the byte stream coming back from the UECU. Bytes can be fed in chunks of
+/// any size (including one at a time) and the parser picks up where it left off, so nothing ever
+/// has to wait for the rest of a message to arrive. It stays synchronized on the full header
+/// (Amulet command and address, an Amulet length that matches the message length, and the 0x80
+/// 0x04 addresses), discarding bytes until one is found, and builds the CRC as the body arrives so
+/// a message is checked as soon as its last byte is in. When the CRC is wrong only the first byte
+/// of the message is dropped and the search starts again from the byte after it, so a false header
+/// inside noise cannot swallow a real message that follows it.
+class FrameParser {
+public:
+    /// FrameParser constructor
+    FrameParser();
+    /// consumes bytes until a message is completed or the bytes run out, and returns the number of
+    /// bytes consumed. If a message was completed, frame_ready() is true until the next feed
+    size_t feed(const unsigned char* bytes, size_t size);
+    /// returns whether the last feed completed a message
+    bool frame_ready() const;
+    /// returns the last completed message (valid while frame_ready() is true)
+    const ReadFrame& get_frame() const;
+    /// returns the number of bytes still needed before the current message could be complete.
+    /// Reading no more than this never consumes bytes past the end of a message. Returns 0 while
+    /// bytes from a message with a bad CRC are still to be searched again (feed no bytes to do so)
+    size_t bytes_needed() const;
+    /// returns whether a message header has been found and its body is still arriving
+    bool in_frame() const;
+    /// reads from transport, never more than bytes_needed() at a time, until a message is completed
+    /// or nothing arrives within timeout. With a zero timeout this only takes bytes already waiting.
+    /// Returns true and copies the message into frame if one was completed
+    bool poll(Transport* transport, ReadFrame& frame, mahi::util::Time timeout = mahi::util::Time::Zero);
+    /// drops any partial message and starts looking for a new header
+    void reset();
+    /// returns the number of messages completed with a correct CRC
+    size_t get_frame_count() const;
+    /// returns the number of bytes discarded while looking for a header
+    size_t get_discarded_count() const;
+    /// returns the number of headers dropped because the CRC of their message was wrong
+    size_t get_crc_error_count() const;
+    /// time every read and feed made by poll into latency_ (nullptr, the default, stops timing)
+    void set_latency_recorder(LatencyRecorder* latency_);
+
+private:
+    /// consumes bytes until a message is completed or rejected or the bytes run out, and returns the
+    /// number of bytes consumed
+    size_t consume(const unsigned char* bytes, size_t size);
+    /// drops the first byte of a rejected message and queues the rest to be searched again
+    void rescan();
+    /// returns whether the first READ_HEADER_SIZE bytes of m_buffer form a plausible header
+    bool header_valid() const;
+
+    enum State { SeekHeader, ReadBody };
+
+    unsigned char  m_buffer[ReadFrame::MAX_SIZE];  // message being assembled
+    size_t         m_pos;                          // number of bytes in m_buffer
+    size_t         m_frame_size;                   // size of the message being assembled (once the header is found)
+    unsigned short m_crc;                          // crc of the message so far (without the trailing crc bytes)
+    State          m_state;                        // what the parser is waiting for
+    bool           m_ready;                        // whether m_frame holds a newly completed message
+    bool           m_rejected;                     // whether the message in m_buffer failed its crc
+    unsigned char  m_rescan[ReadFrame::MAX_SIZE];  // bytes of a rejected message still to be searched
+    size_t         m_rescan_pos;                   // next byte of m_rescan to search
+    size_t         m_rescan_size;                  // number of bytes in m_rescan
+    ReadFrame      m_frame;                        // last completed message
+    size_t         m_frame_count;                  // number of messages completed
+    size_t         m_discarded_count;              // number of bytes thrown away
+    size_t         m_crc_error_count;              // number of messages with a bad crc
+    LatencyRecorder* m_latency;                    // where poll times its reads and feeds, if anywhere
+};
+
+}  // namespace fes
+}  // namespace mahi
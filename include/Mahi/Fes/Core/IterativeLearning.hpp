@@ -0,0 +1,113 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Utility/Profile.hpp>
+#include <Mahi/Util.hpp>
+#include <string>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Learning settings of one channel
+struct LearningGains {
+    double learning_gain = 0.5;  // stimulation added per unit of error (us per unit)
+    size_t lead          = 0;    // samples the error is taken ahead of the stimulation it corrects, for the lag of the limb
+    double min_output    = 0;    // lowest learned stimulation (us)
+    double max_output    = 255;  // highest learned stimulation (us)
+};
+
+/// Iterative learning control: refines the feedforward profiles of repeated trials (eg. gait cycles or
+/// reaching movements) from the error of the last trial. Each trial records the error and the
+/// stimulation actually applied on every channel, and between trials every channel's feedforward is
+/// updated as
+///
+///     u_next[n] = Q(u[n] + L * e[n + lead])
+///
+/// where u is the last feedforward (or the stimulation that was applied, feedback included), L the
+/// learning gain and Q a centered low-pass FIR filter that keeps noise from being learned (zero-phase
+/// as long as its kernel is symmetric, which the built-in low-pass is). Samples are stored by channel,
+/// and the update and filter are plain passes over float arrays that the compiler vectorizes, so
+/// thousands of samples update in well under the rest between repetitions. The learned feedforward is a
+/// Profile, so it can drive a ControllerBank directly and is saved in the binary profile format.
+class IterativeLearning {
+public:
+    /// IterativeLearning constructor (no channels)
+    IterativeLearning();
+    /// starts learning channel_count_ channels of sample_count_ samples, from feedforward_ (laid out as in
+    /// Profile::set_samples) or from zero if it is nullptr
+    bool initialize(size_t channel_count_, size_t sample_count_, mahi::util::Time sample_period_,
+                    const float* feedforward_ = nullptr);
+    /// starts learning from an existing feedforward profile
+    bool initialize(const Profile& feedforward_);
+    /// starts learning from a feedforward saved with save
+    bool load(const std::string& filename_);
+    /// saves the learned feedforward as a binary profile
+    bool save(const std::string& filename_) const;
+    /// saves the last trial as a binary profile: the error of every channel, then the stimulation applied
+    bool save_trial(const std::string& filename_) const;
+
+    /// sets the learning gains of channel_
+    bool set_gains(size_t channel_, const LearningGains& gains_);
+    /// sets the Q-filter to a low-pass at cutoff_ Hz (a Hamming-windowed sinc of taps_ taps, or enough
+    /// for the cutoff if taps_ is 0). The sinc is symmetric, so the filter is zero-phase. A cutoff of 0
+    /// or less turns the filter off
+    void set_q_filter(double cutoff_, size_t taps_ = 0);
+    /// sets the Q-filter to a kernel of odd length, which is normalized to a gain of 1 and centered on
+    /// each sample. It is only zero-phase if the kernel is symmetric; any other kernel shifts what is learned
+    bool set_q_filter(const std::vector<double>& kernel_);
+    /// sets whether learning starts from the stimulation applied rather than the last feedforward
+    /// (false by default). Starting from what was applied folds what the feedback did into the feedforward
+    void set_learn_from_applied(bool enabled_);
+
+    /// starts recording a trial
+    void begin_trial();
+    /// records the error (reference - measurement) and the stimulation applied on every channel at
+    /// time_ since the trial started, in the nearest sample. The loop may run slower than the profile:
+    /// samples it skips are interpolated between the recorded ones, and held before the first and after
+    /// the last. Returns false if time_ is past the end of the profile
+    bool record(mahi::util::Time time_, const double* errors_, const double* applied_);
+    /// updates the feedforward from the trial just recorded. Returns false if nothing was recorded
+    bool update();
+
+    /// returns the learned feedforward
+    const Profile& get_feedforward() const;
+    /// returns the RMS error of channel_ over the samples recorded in the last trial
+    double get_rms_error(size_t channel_) const;
+    /// returns the number of updates made
+    size_t get_trial_count() const;
+
+private:
+    std::vector<LearningGains> m_gains;        // learning gains of each channel
+    std::vector<float>         m_feedforward;  // learned feedforward, one channel after another
+    std::vector<float>         m_error;        // error of the last trial, laid out the same way
+    std::vector<float>         m_applied;      // stimulation applied in the last trial, laid out the same way
+    std::vector<float>         m_kernel;       // Q-filter taps, or empty for none
+    std::vector<float>         m_work;         // padded input to the Q-filter
+    std::vector<unsigned char> m_seen;         // whether each sample was recorded in the trial
+    Profile                    m_profile;      // m_feedforward as a profile
+    size_t                     m_channel_count;     // number of channels
+    size_t                     m_sample_count;      // samples per channel
+    int64_t                    m_sample_period_us;  // time between samples (us)
+    size_t                     m_recorded;          // samples recorded in the trial
+    size_t                     m_trials;            // updates made
+    bool                       m_from_applied;      // whether learning starts from the stimulation applied
+};
+
+}  // namespace fes
+}  // namespace mahi
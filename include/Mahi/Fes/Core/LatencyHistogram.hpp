@@ -0,0 +1,137 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// Histogram of latencies (ns) that one thread records into while another takes snapshots, without
+/// either of them locking. The buckets are log-linear, as in an HDR histogram: every power of two is
+/// split into SUB_BUCKETS equal buckets, so any latency from 1 ns to about 18 minutes is reported
+/// within 1/SUB_BUCKETS of its value, in a fixed block of counters that never grows.
+class LatencyHistogram {
+public:
+    static const unsigned int SUB_BITS    = 4;                                  // log2 of the buckets per power of two
+    static const unsigned int SUB_BUCKETS = 1u << SUB_BITS;                     // buckets per power of two
+    static const unsigned int MAX_BITS    = 40;                                 // values up to 2^40 ns are told apart
+    static const size_t       BUCKETS     = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    /// A copy of the counters at one moment, which can be read at leisure
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts;    // number of values in each bucket
+        uint64_t                      count;     // number of values
+        uint64_t                      total_ns;  // sum of the values
+        uint64_t                      max_ns;    // largest value
+
+        /// Snapshot constructor (empty)
+        Snapshot();
+        /// returns the upper bound of the bucket holding the p-th percentile (0-100), or 0 if empty
+        uint64_t percentile(double p) const;
+        /// returns the mean of the values, or 0 if empty
+        double mean() const;
+        /// adds the values of another snapshot (eg. to combine ports)
+        void merge(const Snapshot& other);
+        /// empties the snapshot
+        void clear();
+    };
+
+    /// LatencyHistogram constructor (empty)
+    LatencyHistogram();
+    /// records one latency. Negative values count as 0 and values past the range go in the last bucket
+    void record(int64_t ns);
+    /// copies the counters into snapshot. With reset the counters are emptied as they are copied, so
+    /// every value recorded ends up in exactly one snapshot
+    void take_snapshot(Snapshot& snapshot, bool reset = false);
+    /// empties the histogram
+    void reset();
+
+    /// returns the bucket a value falls in
+    static size_t bucket_of(uint64_t ns);
+    /// returns the smallest value in a bucket
+    static uint64_t bucket_lower(size_t bucket);
+    /// returns the largest value in a bucket
+    static uint64_t bucket_upper(size_t bucket);
+    /// returns a monotonic timestamp (ns) for timing spans. steady_clock is read through the vDSO on
+    /// Linux and QueryPerformanceCounter on Windows, both a few tens of ns, and unlike a raw rdtsc it
+    /// stays correct across cores and frequency changes
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> m_counts;    // number of values in each bucket
+    std::atomic<uint64_t>                      m_total_ns;  // sum of the values
+    std::atomic<uint64_t>                      m_max_ns;    // largest value
+};
+
+/// The stages of sending updates to and reading replies from one port
+enum class LatencyStage {
+    Encode,    // building the frames of the channels that changed
+    Write,     // handing the frames to the transport
+    Read,      // each read from the transport, including the ones that find nothing
+    Parse,     // feeding the bytes read to the frame parser
+    Validate,  // checking and queueing each reply
+    Port       // everything done for the port in one update
+};
+
+/// returns the name of a stage, eg. "encode"
+const char* get_stage_name(LatencyStage stage);
+
+/// One LatencyHistogram for each LatencyStage of a port. The Scheduler and FrameParser of a port
+/// record into it as they work, and any other thread can take snapshots of it
+class LatencyRecorder {
+public:
+    static const size_t STAGES = 6;  // number of LatencyStage values
+
+    /// A snapshot of every stage
+    struct Snapshot {
+        std::array<LatencyHistogram::Snapshot, STAGES> stages;  // indexed by LatencyStage
+        /// returns the snapshot of one stage
+        const LatencyHistogram::Snapshot& operator[](LatencyStage stage) const { return stages[(size_t)stage]; }
+    };
+
+    /// records the latency of one stage
+    void record(LatencyStage stage, int64_t ns) { m_stages[(size_t)stage].record(ns); }
+    /// returns the histogram of one stage
+    LatencyHistogram& get(LatencyStage stage) { return m_stages[(size_t)stage]; }
+    /// copies every stage into snapshot, emptying them if reset is set
+    void take_snapshot(Snapshot& snapshot, bool reset = false);
+    /// empties every stage
+    void reset();
+
+    /// writes the CSV header matching write_csv
+    static void write_csv_header(std::ostream& os);
+    /// writes one row per stage: label, stage, count, mean, p50, p90, p99, p99.9 and max (ns)
+    static void write_csv(std::ostream& os, const std::string& label, const Snapshot& snapshot);
+    /// writes a JSON object keyed by stage name, with the same summary as write_csv and the non-empty
+    /// buckets as [lower, upper, count] triples
+    static void write_json(std::ostream& os, const Snapshot& snapshot);
+
+private:
+    std::array<LatencyHistogram, STAGES> m_stages;  // indexed by LatencyStage
+};
+
+}  // namespace fes
+}  // namespace mahi
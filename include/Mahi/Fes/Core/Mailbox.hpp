@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mahi {
+namespace fes {
+
+/// Latest-value-wins mailbox of amplitude, pulsewidth and event delay commands, one slot per channel
+/// number, plus a single slot for the schedule period.
+/// Posting is a value store and a flag fetch_or, so the control thread never blocks or waits on the
+/// I/O thread. The I/O thread takes every channel posted since the last take, so commands that are
+/// overwritten before it runs are never sent. Producers on more than one thread are safe, but only
+/// the last value written to a slot is delivered.
+class CommandMailbox {
+public:
+    static const size_t CAPACITY = 32;  // number of channel slots (one bit each in the pending masks)
+
+    /// CommandMailbox constructor
+    CommandMailbox();
+    /// posts a new amplitude for channel_num. Returns false if channel_num is out of range
+    bool post_amplitude(unsigned char channel_num, unsigned int amplitude);
+    /// posts a new pulsewidth for channel_num. Returns false if channel_num is out of range
+    bool post_pulsewidth(unsigned char channel_num, unsigned int pulsewidth);
+    /// takes the channels with new amplitudes since the last take (bit i set for channel i)
+    uint32_t take_amplitudes();
+    /// takes the channels with new pulsewidths since the last take (bit i set for channel i)
+    uint32_t take_pulsewidths();
+    /// returns the latest amplitude posted for channel_num
+    unsigned int get_amplitude(unsigned char channel_num) const;
+    /// returns the latest pulsewidth posted for channel_num
+    unsigned int get_pulsewidth(unsigned char channel_num) const;
+    /// posts a new event delay (ms) for channel_num. Returns false if channel_num is out of range
+    bool post_delay(unsigned char channel_num, unsigned int delay);
+    /// takes the channels with new delays since the last take (bit i set for channel i)
+    uint32_t take_delays();
+    /// returns the latest delay posted for channel_num
+    unsigned int get_delay(unsigned char channel_num) const;
+    /// posts a new schedule period (ms, must be nonzero)
+    void post_period(unsigned int period);
+    /// takes the period posted since the last take, or 0 if there is none
+    unsigned int take_period();
+
+private:
+    std::atomic<unsigned int> m_amplitudes[CAPACITY];   // latest amplitude for each channel
+    std::atomic<unsigned int> m_pulsewidths[CAPACITY];  // latest pulsewidth for each channel
+    std::atomic<uint32_t>     m_amp_pending;            // channels with an amplitude not yet taken
+    std::atomic<uint32_t>     m_pw_pending;             // channels with a pulsewidth not yet taken
+    std::atomic<unsigned int> m_delays[CAPACITY];       // latest event delay for each channel
+    std::atomic<uint32_t>     m_delay_pending;          // channels with a delay not yet taken
+    std::atomic<unsigned int> m_period;                 // latest schedule period not yet taken, or 0
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace mahi {
+namespace fes {
+
+/// Fixed-capacity ring buffer for passing items from any number of producer threads to exactly one
+/// consumer thread without locks or allocation (a bounded queue after Dmitry Vyukov's). Each slot
+/// carries a sequence number, so producers claim slots with one compare-and-swap and the consumer
+/// only takes a slot once its producer has finished copying into it. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class MpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpscRing capacity must be a power of two");
+
+public:
+    /// MpscRing constructor
+    MpscRing() : m_head(0), m_tail(0) {
+        for (size_t i = 0; i < Capacity; i++) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    /// copies item into the ring (any thread). Returns false if the ring is full
+    bool push(const T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell&     cell     = m_cells[head & (Capacity - 1)];
+            size_t    sequence = cell.sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff     = (ptrdiff_t)sequence - (ptrdiff_t)head;
+            if (diff == 0) {
+                // the slot is free: claim it, or try again from wherever the other producer left head
+                if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(head + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                head = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    /// copies the oldest item out of the ring (consumer only). Returns false if the ring is empty
+    bool pop(T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        Cell&  cell = m_cells[tail & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != tail + 1) return false;
+        item = cell.item;
+        // hand the slot back to the producers for the next lap around the ring
+        cell.sequence.store(tail + Capacity, std::memory_order_release);
+        m_tail.store(tail + 1, std::memory_order_relaxed);
+        return true;
+    }
+    /// returns the maximum number of items the ring can hold at once
+    size_t capacity() const { return Capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;  // tells producers and the consumer whose turn the slot is
+        T                   item;      // the item in the slot
+    };
+
+    // the indices are padded onto separate cache lines so producers and the consumer do not contend.
+    // Padding instead of alignas keeps the ring at normal alignment, so the objects that hold one can
+    // be made with plain new
+    std::atomic<size_t>        m_head;      // next slot to claim (shared by the producers)
+    char                       m_pad_head[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t>        m_tail;      // next slot to read (owned by the consumer)
+    char                       m_pad_tail[64 - sizeof(std::atomic<size_t>)];
+    std::array<Cell, Capacity> m_cells;     // storage for the items
+};
+
+}  // namespace fes
+}  // namespace mahi
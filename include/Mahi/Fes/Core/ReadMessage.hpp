@@ -16,15 +16,13 @@
 
 #pragma once
 
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Core/Message.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 
 namespace mahi {
 namespace fes {
 
-#define CRC_SEED 0xFFFF  // seed value for doing the crc calculation
-#define CRC_POLY 0xA001  // poly value for doing the crc calculation
-
 /// The UECU was originally designed to work with a device called the Amulet. Because
 /// of this, some of the information in these messages are not important. So anything
 /// starting with the word Amulet is not important for our use, except in reading the
@@ -39,14 +37,16 @@ namespace fes {
 ///  UECU Message - Bytes of the message - must be of length UECU Message Length
 class ReadMessage : public Message {
 public:
-    /// ReadMessage constructor
-    ReadMessage(std::vector<unsigned char> message);
-    /// ReadMessage constructor with message count input
-    ReadMessage(std::vector<unsigned char> message, size_t msg_count);
+    /// ReadMessage constructor with optional message count input
+    ReadMessage(std::vector<unsigned char> message, size_t msg_count = 0);
+    /// ReadMessage constructor from a fixed-size frame
+    ReadMessage(const ReadFrame& frame, size_t msg_count = 0);
     /// calculate the cyclic redundancy check for the given message
     std::vector<unsigned char> calc_crc();
-    /// returns the message data (without header or crc)
+    /// returns a copy of the message data (without header or crc)
     std::vector<unsigned char> get_data();
+    /// returns a view of the message data (without header or crc) that does not copy
+    ByteView get_data_view();
     /// returns the type of the message as an unsigned char
     unsigned char get_read_message_type();
     /// checks if the read message is valid according to size, type, and crc
@@ -54,14 +54,12 @@ public:
 
     size_t                     m_msg_count = 0;      // the total number of messages received from the board
     unsigned char              m_read_message_type;  // the type of message-refer to utility.hpp for msg types
-    std::vector<unsigned char> m_crc;                // the unsigned char values of the crc
 
-    std::vector<unsigned char> valid_msg_types = {ERROR_REPORT_MSG, EVENT_ERROR_MSG, CREATE_SCHEDULE_REPLY_MSG,
-                                                  CREATE_EVENT_REPLY_MSG,
-                                                  EVENT_COMMAND_REPLY_MSG};  // list of message types that can be sent
+    static const std::vector<unsigned char> valid_msg_types;  // list of message types that can be sent
 
 private:
-    std::vector<unsigned char> m_data;  // message data (without header or crc)
+    /// returns the crc stored at the end of the message
+    unsigned short get_crc();
 };
 
 }  // namespace fes
@@ -17,11 +17,14 @@
 #pragma once
 
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/ChannelStore.hpp>
+#include <Mahi/Fes/Core/CommandQueue.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
+#include <Mahi/Fes/Core/LatencyHistogram.hpp>
 #include <Mahi/Util.hpp>
+#include <future>
 #include <vector>
 
-#define DEL_SCHED_LEN 0x01
 #define STIM_EVENT    0x03
 
 namespace mahi {
@@ -29,16 +32,36 @@ namespace fes {
 
 class Scheduler {
 public:
+    static const unsigned int EVENT_SPACING = 5;       // ms kept between the delays of any two events, including across the end of the period
+    static const unsigned int MAX_PERIOD    = 0xFFFF;  // longest schedule period the UECU accepts (ms)
+
     /// Scheduler constructor
     Scheduler();
     /// Scheduler destructor
     ~Scheduler();
     /// creates the scheduler object
-    bool create_scheduler(HANDLE& hComm_, const unsigned char sync_msg, unsigned int duration,
+    bool create_scheduler(Transport* transport_, const unsigned char sync_msg, unsigned int duration,
                           mahi::util::Time setup_time);
-    /// add an event to the stimulator, and sleep for a short time to let the UECU process
+    /// queues the create scheduler message on commands. The schedule id is taken from the reply when
+    /// it arrives, and only then is the scheduler enabled. Events are made with the schedule id, so
+    /// wait for the reply (eg. with commands.wait_all) before adding any
+    std::future<CommandResult> create_scheduler(CommandQueue& commands, Transport* transport_,
+                                                const unsigned char sync_msg, unsigned int duration);
+    /// add an event to the stimulator, EVENT_SPACING ms after the last one. A real UECU is waited on until
+    /// it acknowledges the event, and a virtual one is given sleep_time to process it
     bool add_event(Channel channel_, mahi::util::Time sleep_time, bool is_virtual_,
                    unsigned char event_type = STIM_EVENT);
+    /// add an event to the stimulator delay ms from the start of each period (eg. as given by a SlotAllocator)
+    bool add_event(Channel channel_, unsigned int delay, mahi::util::Time sleep_time, bool is_virtual_,
+                   unsigned char event_type = STIM_EVENT);
+    /// add an event for each channel, each EVENT_SPACING ms after the last, sending all of the create
+    /// messages through commands at once and waiting for their replies. Events the UECU does not create
+    /// are left out and false is returned
+    bool add_events(CommandQueue& commands, const std::vector<Channel>& channels_,
+                    unsigned char event_type = STIM_EVENT);
+    /// add an event for each channel at the matching delay (ms) from the start of each period
+    bool add_events(CommandQueue& commands, const std::vector<Channel>& channels_,
+                    const std::vector<unsigned int>& delays, unsigned char event_type = STIM_EVENT);
     /// enable the scheduler
     void enable();
     /// disable the scheduler
@@ -47,33 +70,106 @@ public:
     unsigned char get_id();
     /// set the scheduler ID
     void set_id(unsigned char sched_id_);
-    /// write a new amplitude to a specified channel
-    void set_amp(Channel channel_, unsigned int amplitude_);
+    /// write a new amplitude to a specified channel. Returns false if the channel has no event here
+    bool set_amp(const Channel& channel_, unsigned int amplitude_);
     /// return the amplitude of a specified channel
-    unsigned int get_amp(Channel channel_);
-    /// set a new pulsewidth value for a specified channel
-    void write_pw(Channel channel_, unsigned int pw_);
+    unsigned int get_amp(const Channel& channel_) const;
+    /// set a new pulsewidth value for a specified channel. Returns false if the channel has no event here
+    bool write_pw(const Channel& channel_, unsigned int pw_);
     /// return the pulsewidth value of a specified channel
-    unsigned int get_pw(Channel channel_);
+    unsigned int get_pw(const Channel& channel_) const;
+    /// use store_ for the values of the events instead of the scheduler's own store. Must be called
+    /// before any events are added, and store_ must outlive the scheduler
+    void set_store(ChannelStore* store_);
+    /// return the store holding the values of the events
+    const ChannelStore& get_store() const;
     /// return the number of events attached to the scheduler
     size_t get_num_events();
     /// return the vector of events for the scheduler
-    std::vector<Event> get_events();
+    const std::vector<Event>& get_events() const;
+    /// return the event attached to the given channel number, or nullptr if there is none
+    Event* get_event(unsigned char channel_num);
+    /// return the event attached to the given channel number, or nullptr if there is none
+    const Event* get_event(unsigned char channel_num) const;
+    /// append a snapshot of every event's current values to states
+    void get_states(std::vector<ChannelState>& states) const;
     /// send the message to halt the scheduler -> stopping all events attached to it
     bool halt_scheduler();
-    /// command each of the events to write it's current pw and amplitude to the
+    /// command each of the events to write it's current pw and amplitude to the UECU. The changed
+    /// events are found from the store's dirty mask and coalesced into a single write that fits within
+    /// the byte budget; any events that do not fit are sent first on the next update. A change event
+    /// params frame is 9 bytes, so at 9600 baud and 40 Hz (24 bytes per period) only 2 channels go out
+    /// per update: with 4 or more channels changing every period, each one is updated at half the rate
     bool update();
+    /// set the maximum number of bytes sent by a single update (at least one event is always sent)
+    void set_byte_budget(size_t byte_budget_);
+    /// return the maximum number of bytes sent by a single update
+    size_t get_byte_budget();
+    /// time the encode and write of every update into latency_ (nullptr, the default, stops timing)
+    void set_latency_recorder(LatencyRecorder* latency_);
     /// send the sync message to start commanding the events attached to it
     bool send_sync_msg();
+    /// fill in and finalize the sync message without sending it
+    void encode_sync(SyncFrame& frame) const;
+    /// return the transport to the UECU (nullptr before the scheduler is created)
+    Transport* get_transport() const;
     /// return whether or not the scheduler is enabled
     bool is_enabled();
+    /// return the schedule period (ms)
+    unsigned int get_period() const;
+    /// return whether a period of duration ms keeps every event EVENT_SPACING ms from the next (logging why not)
+    bool can_change_period(unsigned int duration) const;
+    /// send the message to change the schedule period to duration ms. The schedule keeps running, so the
+    /// frequency can be changed without interrupting stimulation. Fails without sending if the events
+    /// would not fit in the new period
+    bool change_period(unsigned int duration);
+    /// return whether the event on channel_ can be moved to delay ms without coming within EVENT_SPACING
+    /// ms of another event (logging why not)
+    bool can_change_event_delay(const Channel& channel_, unsigned int delay) const;
+    /// send the message to move the event on channel_ to delay ms from the start of each period. Fails
+    /// without sending if it would come too close to another event
+    bool change_event_delay(const Channel& channel_, unsigned int delay);
+    /// return whether a period of duration ms keeps every event EVENT_SPACING ms from the next, with each
+    /// event moved to delays[channel number] (delays holds ChannelStore::CAPACITY entries)
+    bool can_change_schedule(unsigned int duration, const unsigned int* delays) const;
+    /// change the schedule period to duration ms and move each event to delays[channel number], keeping
+    /// the schedule running. A shorter period is sent after the events have moved into it, and a longer
+    /// one before they move out to where it now reaches. Fails without sending if the result would not fit
+    bool change_schedule(unsigned int duration, const unsigned int* delays);
 
 private:
+    /// fills in the create scheduler message and sets up the scheduler to use transport_
+    void encode_create(CreateScheduleFrame& frame, Transport* transport_, const unsigned char sync_msg,
+                       unsigned int duration);
+    /// returns whether an event can be added on channel_ (logging why not)
+    bool can_add_event(const Channel& channel_) const;
+    /// returns a new event for channel_ at delay ms that has not been sent to the UECU, num_pending events after the last one
+    Event make_event(const Channel& channel_, size_t num_pending, unsigned int delay, bool is_virtual_);
+    /// adds an event the UECU has created to the scheduler
+    void insert_event(const Event& event);
+    /// sends the message to change the schedule period to duration ms without checking the events
+    bool change_period_unchecked(unsigned int duration);
+    /// returns whether the events fit a period of duration ms with moved (if any) at moved_delay, and the
+    /// rest at planned[channel number] (or where they are if planned is nullptr)
+    bool check_spacing(const Event* moved, unsigned int moved_delay, const unsigned int* planned,
+                       unsigned int duration) const;
+    /// sets the byte budget to what the port can send in one period of duration ms
+    void size_byte_budget(unsigned int duration);
+
     unsigned char      m_id;         // the schedule id
     std::vector<Event> m_events;     // vector of events for the current scheduler
+    std::vector<int>   m_event_index;  // index into m_events for each channel number, or -1 if it has no event
+    ChannelStore       m_own_store;  // store used when the scheduler is not given one
+    ChannelStore*      m_store;      // store holding the amplitude, pulsewidth and limits of every event
     bool               m_enabled;    // value indicating whether the scheduler is currently enabled
-    HANDLE             m_hComm;      // serial handle to the appropriate UECU
+    Transport*         m_transport;  // transport to the appropriate UECU
     unsigned char      m_sync_char;  // sync message for the scheduler which tells it to begin
+    unsigned int       m_duration = 0;  // schedule period (ms)
+    size_t             m_byte_budget;          // max bytes written per update so the frames fit in one period
+    unsigned int       m_next_update = 0;      // channel number that gets first claim on the byte budget
+    uint32_t           m_channel_mask = 0;     // bit i is set if channel i has an event in this scheduler
+    std::vector<unsigned char> m_update_buffer;  // contiguous buffer of all change event frames for one update
+    LatencyRecorder*   m_latency = nullptr;    // where update times its stages, if anywhere
 };
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
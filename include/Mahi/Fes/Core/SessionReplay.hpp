@@ -0,0 +1,152 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Fes/Utility/SessionRecorder.hpp>
+#include <Mahi/Util.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// One change to replay, at a time relative to the start of the session
+struct ReplayCommand {
+    enum Type : unsigned char {
+        Stimulation,  // amplitude and pulsewidth of a channel
+        Period,       // schedule period (ms) of every board
+        Delay         // delay (ms) of a channel's event from the start of each period
+    };
+
+    int64_t       time_ns     = 0;            // time since the session started
+    Type          type        = Stimulation;  // what changed
+    unsigned char channel_num = 0;            // channel, for Stimulation and Delay
+    unsigned char amplitude   = 0;            // new amplitude, for Stimulation
+    unsigned char pulsewidth  = 0;            // new pulsewidth, for Stimulation
+    unsigned int  value       = 0;            // new period or delay (ms)
+    bool          setup       = false;        // from creating a schedule or event, so only applied if it differs
+};
+
+/// A stream of commands to replay, in time order
+class ReplaySource {
+public:
+    virtual ~ReplaySource() {}
+    /// reads the next command. Returns false at the end
+    virtual bool next(ReplayCommand& command) = 0;
+    /// goes back to the first command
+    virtual bool rewind() = 0;
+};
+
+/// Reads the commands back out of the frames of a session file written by SessionRecorder. Event ids
+/// are matched to channels from the create event replies (or, for a virtual UECU that never replied,
+/// from the order the events were created), and every change event params, change schedule and change
+/// event schedule message sent becomes a command. Only one chunk of the file is mapped at a time
+class SessionDecoder : public ReplaySource {
+public:
+    /// opens a session file
+    bool open(const std::string& filename_);
+    bool next(ReplayCommand& command) override;
+    bool rewind() override;
+
+private:
+    static const size_t MAX_PORTS  = 8;    // boards told apart (channels 1-32)
+    static const size_t MAX_QUEUED = 64;   // commands one write can hold
+
+    /// turns one recorded frame into commands
+    void decode(const SessionRecord& record);
+    /// adds a command to the queue
+    void queue(const ReplayCommand& command);
+    /// returns the channel of an event on a port, or -1 if it is not known
+    int get_channel(unsigned char port, unsigned char event_id) const;
+
+    SessionReader m_reader;                                   // the session file
+    std::array<ReplayCommand, MAX_QUEUED>  m_queued;          // commands decoded from the last record
+    size_t                                 m_num_queued = 0;  // commands in m_queued
+    size_t                                 m_next_queued = 0; // next command to hand out
+    std::array<std::array<int, 256>, MAX_PORTS> m_event_channels;  // board channel of each event id per port, or -1
+    std::array<unsigned char, MAX_PORTS>   m_created = {{}};  // events created on each port so far
+};
+
+/// Reads commands from a text file with one line per change of a channel: the time (s), channel
+/// number (0 for CH_1), amplitude and pulsewidth, separated by spaces or commas. Lines starting with #
+/// are skipped. The file is read as it is replayed, so its length does not matter
+class CommandFile : public ReplaySource {
+public:
+    /// opens a command file
+    bool open(const std::string& filename_);
+    bool next(ReplayCommand& command) override;
+    bool rewind() override;
+
+private:
+    std::ifstream m_file;      // the command file
+    std::string   m_line;      // line being read
+    size_t        m_line_num = 0;  // number of the line being read
+};
+
+/// Re-emits a recorded session through a Stimulator, with the original timing or faster. Setup commands
+/// are only applied where the stimulator differs from them, and every other command is applied as is. Commands
+/// with the same time are applied together, followed by one Stimulator::update (which only checks on the
+/// I/O thread if it is running), so replaying the same source as fast as possible sends the same frames
+/// in the same order every time. The stimulator must already be set up with the session's channels.
+class SessionReplay {
+public:
+    /// Timing of the last replay
+    struct Stats {
+        size_t           commands     = 0;                       // commands applied
+        size_t           unknown      = 0;                       // commands for channels the stimulator does not have
+        size_t           rejected     = 0;                       // period and delay changes the stimulator refused
+        mahi::util::Time max_lateness = mahi::util::Time::Zero;  // latest a command was applied after its time
+        mahi::util::Time elapsed      = mahi::util::Time::Zero;  // time the replay took
+    };
+
+    /// SessionReplay constructor. The stimulator must outlive the replay
+    SessionReplay(Stimulator& stimulator_);
+    /// sets how much faster than recorded the session is replayed (1 by default). 0 replays as fast as possible
+    void set_speed(double speed_);
+    /// sets whether period and delay changes are replayed (true by default)
+    void set_schedule_changes(bool enabled_);
+    /// replays source from its start until it ends or stop is called. Returns false if an update failed
+    bool run(ReplaySource& source_);
+    /// asks run to return. Safe to call from any thread
+    void stop();
+    /// returns the timing of the last replay
+    Stats get_stats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /// applies one command to the stimulator
+    void apply(const ReplayCommand& command);
+    /// waits until deadline, sleeping until shortly before it and spinning the rest
+    void wait_until(Clock::time_point deadline) const;
+
+    Stimulator&          m_stimulator;        // stimulator the session is replayed through
+    std::vector<Channel> m_channels;          // channels of the stimulator
+    std::vector<int>     m_channel_index;     // position in m_channels of each channel number, or -1
+    double               m_speed = 1.0;       // how much faster than recorded
+    bool                 m_schedule = true;   // whether period and delay changes are replayed
+    std::atomic<bool>    m_stop{false};       // asks run to return
+    Stats                m_stats;             // timing of the last replay
+};
+
+}  // namespace fes
+}  // namespace mahi
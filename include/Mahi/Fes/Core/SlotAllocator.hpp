@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/Scheduler.hpp>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// How SlotAllocator places the events within the schedule period
+enum class SlotPolicy {
+    Packed,      // each board's events back to back from the start of the period
+    Spread,      // each board's events spread evenly over the period
+    Interleaved  // spread, with each board's events staggered from the other boards' so that they do not pulse together
+};
+
+/// Works out the delay of each channel's event from the start of the schedule period. Each event gets a
+/// slot as long as its longest pulse, and never shorter than the board's minimum spacing between events.
+/// Spreading the slots over the period instead of packing them at its start keeps the pulses from
+/// overlapping and evens out the current drawn from the boards. Channels that cannot fit in the period
+/// are rejected before anything is sent to the UECU.
+class SlotAllocator {
+public:
+    /// SlotAllocator constructor. min_spacing_ is the shortest time allowed between events on a board (ms)
+    SlotAllocator(SlotPolicy policy_ = SlotPolicy::Spread, unsigned int min_spacing_ = Scheduler::EVENT_SPACING);
+    /// sets how the events are placed within the period
+    void set_policy(SlotPolicy policy_);
+    /// returns how the events are placed within the period
+    SlotPolicy get_policy() const;
+    /// sets the shortest time allowed between events on a board (ms)
+    void set_min_spacing(unsigned int min_spacing_);
+    /// returns the time the event of a channel occupies (ms): its longest pulse rounded up to whole
+    /// milliseconds, and never less than the minimum spacing
+    unsigned int get_slot_width(const Channel& channel_) const;
+    /// fills delays with the delay (ms) of the event of each channel in a period of duration ms, in the
+    /// same order as channels_. Returns false (logging why) if they do not fit
+    bool allocate(const std::vector<Channel>& channels_, unsigned int duration, std::vector<unsigned int>& delays) const;
+
+private:
+    /// places the slots of the channels at indices back to back from the start of the period, with the
+    /// slack left over spread evenly between them if spread is set. Returns false if they do not fit
+    bool place(const std::vector<Channel>& channels_, const std::vector<size_t>& indices, unsigned int duration,
+               bool spread, std::vector<unsigned int>& delays) const;
+
+    SlotPolicy   m_policy;       // how the events are placed within the period
+    unsigned int m_min_spacing;  // shortest time allowed between events on a board (ms)
+};
+
+}  // namespace fes
+}  // namespace mahi
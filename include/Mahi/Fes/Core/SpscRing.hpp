@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace mahi {
+namespace fes {
+
+/// Fixed-capacity ring buffer for passing items from exactly one producer thread to exactly one
+/// consumer thread without locks or allocation. Capacity must be a power of two; one slot is kept
+/// empty to tell a full ring from an empty one.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    /// SpscRing constructor
+    SpscRing() : m_head(0), m_tail(0) {}
+    /// copies item into the ring (producer only). Returns false if the ring is full
+    bool push(const T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (Capacity - 1);
+        if (next == m_tail.load(std::memory_order_acquire)) return false;
+        m_items[head] = item;
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+    /// copies the oldest item out of the ring (consumer only). Returns false if the ring is empty
+    bool pop(T& item) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) return false;
+        item = m_items[tail];
+        m_tail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+    /// returns whether the ring is empty (exact only when called from the consumer)
+    bool empty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+    /// returns the maximum number of items the ring can hold at once
+    size_t capacity() const { return Capacity - 1; }
+
+private:
+    // the indices are padded onto separate cache lines so the two threads do not contend on every
+    // push/pop. Padding instead of alignas keeps the ring at normal alignment, so the objects that
+    // hold one can be made with plain new
+    std::atomic<size_t>     m_head;      // next slot to write (owned by the producer)
+    char                    m_pad_head[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t>     m_tail;      // next slot to read (owned by the consumer)
+    char                    m_pad_tail[64 - sizeof(std::atomic<size_t>)];
+    std::array<T, Capacity> m_items;     // storage for the items
+};
+
+}  // namespace fes
+}  // namespace mahi
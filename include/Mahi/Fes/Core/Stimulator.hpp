@@ -16,102 +16,246 @@
 
 #pragma once
 
-#include <Windows.h>
-
 #include <Mahi/Fes/Core/Channel.hpp>
+#include <Mahi/Fes/Core/ChannelStore.hpp>
+#include <Mahi/Fes/Core/CommandQueue.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <Mahi/Fes/Core/LatencyHistogram.hpp>
+#include <Mahi/Fes/Core/Mailbox.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Core/Scheduler.hpp>
+#include <Mahi/Fes/Core/SlotAllocator.hpp>
+#include <Mahi/Fes/Core/SyncCoordinator.hpp>
+#include <Mahi/Fes/Core/SpscRing.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Fes/Utility/Thread.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace mahi {
 namespace fes {
+
+class StimulatorGroup;
+
 class Stimulator {
 public:
     /// Stimulator constructor
     Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_,  const std::string& com_port_2_ = "NONE", bool is_virtual_ = false);
+    /// Stimulator constructor with any number of comports. The first handles channels 1-4, the second
+    /// channels 5-8, and so on. Ports named "NONE" are skipped
+    Stimulator(const std::string& name_, std::vector<Channel>& channels_, const std::vector<std::string>& com_ports_, bool is_virtual_ = false);
+    /// Stimulator constructor with user-provided transports (eg. a pseudo-terminal attached to an
+    /// emulator). The first transport handles channels 1-4, the second channels 5-8, and so on
+    Stimulator(const std::string& name_, std::vector<Channel>& channels_, std::vector<std::shared_ptr<Transport>> transports_, bool is_virtual_ = false);
     /// Stimulator destructor
     ~Stimulator();
-    /// open, configure, and initialize the serial communication for use with the board
+    /// open, configure, and initialize the serial communication for use with the board. Fails without
+    /// opening anything if a channel number is ChannelStore::CAPACITY or above
     bool enable();
     /// disable all schedulers and events and close serial communication
     void disable();
     /// takes the scheduler objet that already exists and sends the create_scheduler message
-    /// to the UECU, assigning scheduler id in the process
+    /// to the UECU, assigning scheduler id in the process. The event of every channel is given its place
+    /// in the period first, and nothing is sent if the channels do not fit
     bool create_scheduler(const unsigned char sync_msg, double frequency_);
+    /// set how events are placed within the schedule period (Spread by default). Call before create_scheduler.
+    /// Returns false, changing nothing, while the I/O thread is running
+    bool set_slot_policy(SlotPolicy policy_);
+    /// return the delay of a channel's event from the start of each schedule period (ms)
+    unsigned int get_event_delay(const Channel& channel_);
     /// checks whether the stimulator has been enabled
     bool is_enabled();
-    /// set the amplitude for a single channel (event). This runs down to the event object
-    void set_amp(Channel channel_, unsigned int amplitude_);
-    /// set the amplitude for a vector of channels (events). This runs down to the event object
-    void set_amps(std::vector<Channel> channels_, std::vector<unsigned int> amplitudes_);
-    /// set the pulsewidth for a single channel (event). This runs down to the event object
-    void write_pw(Channel channel_, unsigned int pw_);
-    /// set the pulsewidth for a vector of channels (events). This runs down to the event object
-    void write_pws(std::vector<Channel> channels_, std::vector<unsigned int> pulsewidths_);
-    /// update the max amplitude for a single channel. This runs down to the event object
-    void update_max_amp(Channel channel_, unsigned int max_amp_);
-    /// update the max pulsewidth for a single channel. This runs down to the event object
-    void update_max_pw(Channel channel_, unsigned int max_pw_);
+    /// set the amplitude for a single channel (event). This runs down to the event object, or to the
+    /// I/O thread's mailbox if it is running. Returns false if the channel is not on this stimulator
+    /// or the mailbox has no slot for it
+    bool set_amp(const Channel& channel_, unsigned int amplitude_);
+    /// set the amplitude for a vector of channels (events). This runs down to the event object.
+    /// Returns false if any of them was not set
+    bool set_amps(std::vector<Channel> channels_, std::vector<unsigned int> amplitudes_);
+    /// set the pulsewidth for a single channel (event). This runs down to the event object, or to the
+    /// I/O thread's mailbox if it is running. Returns false if the channel is not on this stimulator
+    /// or the mailbox has no slot for it
+    bool write_pw(const Channel& channel_, unsigned int pw_);
+    /// set the pulsewidth for a vector of channels (events). This runs down to the event object.
+    /// Returns false if any of them was not set
+    bool write_pws(std::vector<Channel> channels_, std::vector<unsigned int> pulsewidths_);
+    /// set the pulsewidths of count_ channels given by channel number, without a Channel for each. This
+    /// writes straight into the channel store in one change (or into the I/O thread's mailbox), clamping
+    /// to each channel's max pulsewidth without logging, and allocates nothing. Returns false if any of
+    /// them was not set
+    bool write_pws(const unsigned char* channel_nums_, const unsigned int* pulsewidths_, size_t count_);
+    /// update the max amplitude for a single channel. The current amplitude is lowered if it is now too high
+    void update_max_amp(const Channel& channel_, unsigned int max_amp_);
+    /// update the max pulsewidth for a single channel. The current pulsewidth is lowered if it is now too high
+    void update_max_pw(const Channel& channel_, unsigned int max_pw_);
+    /// change the stimulation frequency of every board while the schedules keep running, instead of
+    /// recreating them. The events are placed again for the new period by the slot policy (replacing
+    /// delays set with set_event_delay), and it fails if they no longer fit. While the I/O thread is
+    /// running that is checked here and the change is posted to it
+    bool set_frequency(double frequency_);
+    /// return the stimulation frequency (Hz)
+    double get_frequency();
+    /// return the schedule period
+    mahi::util::Time get_period();
+    /// move the event of a channel to delay_ ms from the start of each schedule period while the schedule
+    /// keeps running. Fails if it would come within Scheduler::EVENT_SPACING ms of another event on its
+    /// board. While the I/O thread is running the change is posted to it, and a rejected change is only logged
+    bool set_event_delay(const Channel& channel_, unsigned int delay_);
+    /// copy the current values of every channel into snapshot, in the same order as get_channels(). Safe
+    /// to call from any thread. snapshot is only resized, so reusing it between calls does not allocate
+    void get_snapshot(std::vector<ChannelState>& snapshot) const;
+    /// copy the current values of every channel, indexed by channel number, into snapshot. Safe to call
+    /// from any thread and never blocks the thread sending updates
+    void get_snapshot(ChannelStore::Snapshot& snapshot) const;
     /// add an event to the scheduler
     bool add_event(Channel channel_, unsigned char event_type = STIM_EVENT);
     /// add a vector of events to the scheduler
     bool add_events(std::vector<Channel> channels_, unsigned char event_type = STIM_EVENT);
     /// return a vector of the channels of the stimulator
     std::vector<Channel> get_channels();
-    /// start the stimulator by sending the sync message
+    /// start the stimulator by sending the sync message to every board, back to back
     bool begin();
-    /// command values set by set_amp/pw commands by sending messages to the UECU
+    /// set the largest skew accepted between the boards starting. If begin (or a resync) starts them
+    /// further apart, the sync messages are sent again, up to max_attempts_ times in all
+    void set_max_sync_skew(mahi::util::Time max_skew_, int max_attempts_ = 3);
+    /// send the sync messages again every interval_ from update or the I/O thread, so that boards
+    /// drifting apart are brought back in phase. Each resync restarts the schedules. Zero (the default) never does
+    void set_resync_interval(mahi::util::Time interval_);
+    /// return the time between the first and last board receiving the sync message the last time begin
+    /// or a resync sent it (a StimulatorGroup keeps its own, since it syncs the boards of every stimulator)
+    mahi::util::Time get_sync_skew() const;
+    /// return the largest skew between the boards receiving a sync message since the stimulator was created
+    mahi::util::Time get_max_sync_skew() const;
+    /// return the number of times the sync messages have been sent (by begin or a resync)
+    size_t get_sync_count() const;
+    /// return when the sync messages were last sent, which is when the boards' schedules last started
+    std::chrono::steady_clock::time_point get_sync_time() const;
+    /// command values set by set_amp/pw commands by sending messages to the UECU. While the I/O
+    /// thread is running this only checks that the thread is still healthy
     bool update();
+    /// return the time from enabling the stimulator until begin sent the sync message
+    mahi::util::Time get_bring_up_time();
+    /// start a dedicated I/O thread that takes ownership of the serial ports. From then on set_amp and
+    /// write_pw only post to a mailbox, and the thread sends the latest values once per schedule
+    /// period and queues replies for pop_reply. Call after create_scheduler, add_events, and begin
+    bool start_io_thread(ThreadSettings settings_ = ThreadSettings());
+    /// stop the I/O thread and hand the serial ports back to the calling thread
+    void stop_io_thread();
+    /// return whether the I/O thread is running
+    bool is_io_thread_running();
+    /// take the oldest reply received by the I/O thread. Returns false if there are none
+    bool pop_reply(ReadFrame& frame_);
+    /// return the number of replies dropped because pop_reply was not keeping up
+    size_t get_dropped_reply_count();
+    /// time each stage of sending updates and reading replies on every port (see LatencyStage), whether
+    /// update or an I/O thread does the work. Off by default. Fails while an I/O thread is running
+    bool set_latency_tracking(bool enabled_);
+    /// return whether the stages are being timed
+    bool is_latency_tracking() const;
+    /// copy the latencies of a port into snapshot_, emptying them if reset_ is set. Safe to call from
+    /// any thread while the ports are being serviced
+    bool get_latency_snapshot(size_t port_, LatencyRecorder::Snapshot& snapshot_, bool reset_ = false);
+    /// write a summary of the latencies of every port to a CSV file, one row per port and stage
+    bool write_latency_csv(const std::string& filename_, bool reset_ = false);
+    /// write the latencies of every port, including the non-empty histogram buckets, to a JSON file
+    bool write_latency_json(const std::string& filename_, bool reset_ = false);
     /// halt the scheduler, cancelling all events and schedulers
     bool halt_scheduler();
     /// return the name of the stimulator
     std::string get_name();
 
     size_t                   num_events;       // number of events the stimulator is handling
-    std::vector<int>         amplitudes;       // vector of amplitudes corresponding to channels
-    std::vector<int>         pulsewidths;      // vector of pulsewidths corresponding to channels
-    std::vector<int>         max_amplitudes;   // vector of max amplitudes corresponding to channels
-    std::vector<int>         max_pulsewidths;  // vector of max pulsewidths corresponding to channels
     std::vector<std::string> channel_names;    // returns vector of the names of the channels
 
 private:
-    /// open the comport that the UECU is controlled from
-    bool open_port(HANDLE* hComm, std::string com_port);
-    /// configure the comport that the UECU is controlled from
-    bool configure_port(HANDLE* hComm);
+    friend class StimulatorGroup;
+
     /// initialize the board by enabling each of the channels given setup parameters
     bool initialize_board();
     /// halt the stimulator and close the comports
     void close_stimulator();
     /// read all incoming messages from the stimulator
     // void read_all();
+    /// run work(port) for every port at once, each on its own thread, and return whether all succeeded
+    bool for_each_port(const std::function<bool(size_t)>& work);
+    /// return the scheduler for the board of a channel, or nullptr (logging why) if it has no comport
+    Scheduler* get_scheduler(const Channel& channel_);
+    /// open a serial transport for each comport not named "NONE"
+    static std::vector<std::shared_ptr<Transport>> make_serial_transports(const std::vector<std::string>& com_ports_);
+    /// return the position of a channel number in m_channels, or -1 if the stimulator does not have it
+    int get_channel_index(unsigned char channel_num) const;
+    /// find the delay create_scheduler planned for a channel's event. Returns false if it has none
+    bool get_slot_delay(const Channel& channel_, unsigned int& delay) const;
+    /// place the events for a period of duration ms and change every board to it, checking all of them
+    /// before changing any
+    bool apply_period(unsigned int duration);
+    /// record the bring-up time once the boards have been synced skew apart
+    void finish_bring_up(mahi::util::Time skew);
+    /// body of the I/O thread
+    void io_loop(ThreadSettings settings_);
+    /// hand the transports to an I/O thread (this stimulator's or a group's). From then on set_amp and
+    /// write_pw post to the mailbox
+    bool begin_io();
+    /// take the transports back from the I/O thread once it has stopped, and send anything still posted
+    void end_io();
+    /// one cycle of the I/O thread: apply posted commands, send updates, and queue replies
+    bool service_io();
+    /// send the updates of every board, then check the replies that have arrived on each, queueing them
+    /// for pop_reply if queue_replies is set
+    bool update_ports(bool queue_replies);
+    /// check every reply that has fully arrived on a port without waiting, queueing them for pop_reply
+    /// if queue is set. Returns false if any was invalid or an error
+    bool receive_replies(size_t port, bool queue = true);
+    /// take snapshots of the latencies of every port
+    void take_latency_snapshots(std::vector<LatencyRecorder::Snapshot>& snapshots, bool reset);
 
 
-    DCB    m_dcbSerialParams = {0};  // serial parameters to handle the serial communication to UECU
-
     mahi::util::Time m_delay_time = mahi::util::milliseconds(100);  // delay time when sending messages
+    mahi::util::Clock m_bring_up_clock;                               // started when the stimulator is enabled
+    mahi::util::Time  m_bring_up_time = mahi::util::Time::Zero;       // time from enable until begin
 
-    HANDLE                   m_hComm_1;            // serial handle to the appropriate UECU first set of 4 channels
-    HANDLE                   m_hComm_2;            // serial handle to the appropriate UECU second set of 4 channels
-    std::vector<HANDLE*>     m_hComms;             // vector of pointers to m_hComm_1 and m_hComm_2
+    std::vector<std::shared_ptr<Transport>> m_transports; // transports to the UECU, one per board: channels 1-4, 5-8, and so on
+    std::vector<Transport*>  m_transport_ptrs;     // raw pointers to m_transports to hand down to schedulers/events
+    std::vector<std::unique_ptr<CommandQueue>> m_commands;  // setup commands waiting on replies on each transport
     std::string              m_name;               // name of the stimulator
-    std::string              m_com_port_1;         // comport that the 2nd set of 4 channels for the UECU is written to from. should be in format COMX or COMXX.
-    std::string              m_com_port_2;         // comport that the 2nd set of 4 channels for the UECU is written to from. should be in format COMX or COMXX. This defaults to "NONE"
-    std::vector<std::string> m_com_ports;          // vector of {m_com_port_1, m_com_port_2} to iterate over
-    size_t                   m_num_ports = 1;      // total number of comports. This is 1 if m_com_port_2 is "NONE" and 2 if m_com_port_2 is COMX
+    std::vector<std::string> m_com_ports;          // name of the comport for each board, eg. COMX or /dev/ttyUSBX
+    size_t                   m_num_ports = 1;      // total number of comports (and boards)
     bool                     m_enabled;            // shows if the stimulator has been enabled
     bool                     m_is_virtual;         // determines whether or not to wait for responses from the stimulator
     std::vector<Channel>     m_channels;           // vector of channels enabled by the stim board
-    Scheduler                m_scheduler_1;        // scheduler which handles events
-    Scheduler                m_scheduler_2;        // scheduler which handles events
-    std::vector<Scheduler*>  m_schedulers;
+    std::vector<int>         m_channel_index;      // position in m_channels for each channel number, or -1
+    bool                     m_channels_fit = true;  // whether every channel number fits in the channel store
+    ChannelStore             m_store;              // amplitude, pulsewidth and limits of every channel
+    std::vector<std::unique_ptr<Scheduler>> m_schedulers;  // scheduler which handles the events of each board
+    SyncCoordinator          m_sync;               // starts the schedules of every board together
+    SlotAllocator            m_slots;              // places the events within the schedule period
+    std::vector<unsigned int> m_slot_delays;       // planned delay of each channel's event, in the order of m_channels
+    std::vector<unsigned int> m_next_delays;       // delays being planned for a new period
     int                      m_inc_msg_count = 0;  // number of messages the stimulator has received
     std::queue<ReadMessage>  m_inc_messages;       // queue of incoming messages
     std::mutex               m_mtx;                // mutex for handling simultaneous reading/writing
+
+    std::atomic<int64_t>     m_period_us{50000};       // schedule period (us), which the I/O thread runs at and may change
+    std::thread              m_io_thread;              // thread that owns the transports while running
+    std::atomic<bool>        m_io_running{false};      // whether the I/O thread owns the transports
+    StimulatorGroup*         m_group = nullptr;        // group whose I/O thread owns the transports, if any
+    std::atomic<bool>        m_io_stop{false};         // asks the I/O thread to exit
+    std::atomic<bool>        m_io_failed{false};       // set by the I/O thread if a write or reply failed
+    std::atomic<size_t>      m_dropped_replies{0};     // replies dropped because the ring was full
+    CommandMailbox           m_mailbox;                // latest amplitude/pulsewidth commands for the I/O thread
+    SpscRing<ReadFrame, 64>  m_replies;                // replies from the I/O thread to pop_reply
+    std::vector<std::unique_ptr<LatencyRecorder>> m_latency;  // latencies of the stages of each port
+    bool                     m_latency_tracking = false;   // whether the schedulers and parsers record into m_latency
+    std::vector<int64_t>     m_port_ns;                    // time spent sending the updates of each port this cycle
 };
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
@@ -0,0 +1,97 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Fes/Core/SyncCoordinator.hpp>
+#include <Mahi/Fes/Utility/PortPoller.hpp>
+#include <Mahi/Fes/Utility/Thread.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Drives several stimulators (eg. one per limb) from one control loop. A single I/O thread and a
+/// single timer send the updates for every board of every stimulator, so all of them are updated in
+/// the same period, and replies from all of their ports are waited on together.
+class StimulatorGroup {
+public:
+    /// StimulatorGroup constructor (no stimulators)
+    StimulatorGroup(const std::string& name_ = "Stimulator Group");
+    /// StimulatorGroup destructor. Stops the I/O thread, but does not disable the stimulators
+    ~StimulatorGroup();
+    /// adds a stimulator. The group does not own it, and it must outlive the group's I/O thread
+    bool add(Stimulator* stimulator_);
+    /// returns the number of stimulators in the group
+    size_t size() const;
+    /// returns the stimulator at index i
+    Stimulator* get(size_t i) const;
+    /// creates the scheduler on every board of every stimulator with the same sync message and frequency
+    bool create_scheduler(const unsigned char sync_msg, double frequency_);
+    /// starts every board of every stimulator together by sending all of their sync messages back to back
+    bool begin();
+    /// sets the largest skew accepted between the first and last board starting. Above it the sync
+    /// messages are sent again, up to max_attempts_ times in all
+    void set_max_sync_skew(mahi::util::Time max_skew_, int max_attempts_ = 3);
+    /// sends the sync messages of every board again every interval_, so that boards drifting apart are
+    /// brought back in phase. Each resync restarts the schedules. Zero (the default) never does
+    void set_resync_interval(mahi::util::Time interval_);
+    /// returns the time between the first and last board receiving the sync message the last time it was sent
+    mahi::util::Time get_sync_skew() const;
+    /// returns the largest skew between the boards receiving a sync message
+    mahi::util::Time get_max_sync_skew() const;
+    /// updates every stimulator. While the I/O thread is running this only checks that it is still healthy
+    bool update();
+    /// starts one I/O thread that takes over the serial ports of every stimulator. set_amp and write_pw on
+    /// each stimulator then post to its mailbox, and the thread sends them all once per schedule period
+    bool start_io_thread(ThreadSettings settings_ = ThreadSettings());
+    /// stops the I/O thread and hands the serial ports back to the stimulators
+    void stop_io_thread();
+    /// returns whether the I/O thread is running
+    bool is_io_thread_running() const;
+    /// stops the I/O thread and disables every stimulator
+    void disable();
+    /// returns the name of the group
+    std::string get_name() const;
+
+private:
+    StimulatorGroup(const StimulatorGroup&) = delete;
+    StimulatorGroup& operator=(const StimulatorGroup&) = delete;
+
+    /// body of the I/O thread
+    void io_loop(ThreadSettings settings_);
+
+    std::string              m_name;          // name of the group
+    std::vector<Stimulator*> m_stimulators;   // stimulators driven by the group
+    SyncCoordinator          m_sync;          // starts every board of every stimulator together
+    PortPoller               m_poller;        // every port of every stimulator
+    std::vector<size_t>      m_port_owners;   // index of the stimulator of each port in m_poller
+    std::vector<size_t>      m_port_numbers;  // port number within its stimulator of each port in m_poller
+    std::vector<size_t>      m_ready;         // ports with replies waiting, reused between waits
+    mahi::util::Time         m_period;        // shortest schedule period of the stimulators
+    std::thread              m_io_thread;     // thread servicing every stimulator
+    std::atomic<bool>        m_io_stop;       // tells the I/O thread to return
+    std::atomic<bool>        m_io_running;    // whether the I/O thread owns the transports
+    std::atomic<bool>        m_io_failed;     // set by the I/O thread if a stimulator failed
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/Scheduler.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Starts the schedules of several boards together. Every sync message is built before any is
+/// sent, so that nothing but the writes happens between the boards starting. The UECU does not
+/// reply to a sync message, so each port is written and drained before the next, and the skew is
+/// the spread between when the first and last port had sent its message. Because each board
+/// runs its schedule from its own clock, the boards also drift apart over a long session; sending
+/// the sync messages again on a fixed interval restarts every schedule on the same period boundary.
+class SyncCoordinator {
+public:
+    /// SyncCoordinator constructor (no boards)
+    SyncCoordinator();
+    /// adds the scheduler of a board. It must have been created before release is called
+    void add(Scheduler* scheduler_);
+    /// removes every board
+    void clear();
+    /// returns the number of boards
+    size_t size() const;
+    /// sets the largest skew release accepts. If the boards start further apart than max_skew_, every
+    /// sync message is sent again, up to max_attempts_ times in all. Zero (the default) accepts any skew
+    void set_max_skew(mahi::util::Time max_skew_, int max_attempts_ = 3);
+    /// sets how often resync_if_due sends the sync messages again. Zero (the default) never does
+    void set_resync_interval(mahi::util::Time interval_);
+    /// sends the sync message of every board in turn, and again if the skew is above the bound.
+    /// Returns false if a board is not enabled or a write failed
+    bool release();
+    /// calls release if the resync interval has passed since the last release. Returns false only if
+    /// that release failed
+    bool resync_if_due();
+    /// returns the skew of the last release: the time between the first and last port having sent its
+    /// sync message
+    mahi::util::Time get_last_skew() const;
+    /// returns the largest skew of any release
+    mahi::util::Time get_worst_skew() const;
+    /// returns the number of times the sync messages have been sent
+    size_t get_release_count() const;
+    /// returns when the first sync message of the last release had been sent, which is the start of the
+    /// boards' first period
+    std::chrono::steady_clock::time_point get_release_time() const;
+
+private:
+    std::vector<Scheduler*> m_schedulers;                              // scheduler of each board
+    std::vector<SyncFrame>  m_frames;                                  // sync message of each board
+    mahi::util::Time        m_max_skew        = mahi::util::Time::Zero;  // largest skew accepted by release
+    int                     m_max_attempts    = 1;                       // times release may send the sync messages
+    mahi::util::Time        m_resync_interval = mahi::util::Time::Zero;  // time between releases in resync_if_due
+    mahi::util::Clock       m_resync_clock;                              // restarted at every release
+    std::atomic<int64_t>    m_last_skew_us;                              // skew of the last release (us)
+    std::atomic<int64_t>    m_worst_skew_us;                             // largest skew of any release (us)
+    std::atomic<size_t>     m_release_count;                             // number of releases
+    std::atomic<int64_t>    m_release_time_ns;                           // steady clock time of the last release (ns)
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Util.hpp>
+#include <memory>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+class FrameParser;
+
+/// Generic byte transport between the host and a single UECU board. Everything that talks to
+/// the board (channels, events, schedulers, messages) goes through this interface, so the same
+/// stimulator code can run over a Win32 COM port, a POSIX tty, or a pseudo-terminal that is
+/// attached to an emulator instead of real hardware.
+class Transport {
+public:
+    /// Transport constructor
+    Transport(const std::string& port_name_);
+    /// Transport destructor
+    virtual ~Transport();
+    /// opens and configures the port. Returns false if the port could not be opened
+    virtual bool open() = 0;
+    /// closes the port if it is open
+    virtual void close() = 0;
+    /// returns whether or not the port is currently open
+    virtual bool is_open() = 0;
+    /// writes size bytes from data to the port. Returns true only if every byte was written
+    virtual bool write(const unsigned char* data, size_t size) = 0;
+    /// reads up to size bytes into data, waiting at most timeout for the first byte to arrive.
+    /// Returns the number of bytes read (0 on timeout) or -1 if the read failed
+    virtual int read(unsigned char* data, size_t size, mahi::util::Time timeout) = 0;
+    /// discards any bytes that are waiting to be read or written
+    virtual void purge() = 0;
+    /// waits until every byte written so far has left the port. Returns false if that could not be
+    /// confirmed. The default returns true straight away, for transports that buffer nothing
+    virtual bool drain();
+    /// returns the baud rate of the port, used for budgeting how many bytes fit in a schedule period
+    virtual unsigned int get_baud_rate();
+    /// returns a file descriptor that becomes readable when bytes arrive, so that many ports can be
+    /// waited on at once (see PortPoller), or -1 if the transport cannot be waited on that way
+    virtual int get_poll_fd();
+    /// reads exactly size bytes into data unless timeout elapses first. Returns the number of bytes read
+    size_t read_exact(unsigned char* data, size_t size, mahi::util::Time timeout);
+    /// returns the name of the port (eg. COM5 or /dev/ttyUSB0)
+    std::string get_port_name();
+    /// returns the parser that read_message, read_frame and wait_for_reply read through, which
+    /// keeps a partly received reply for the next of those calls
+    FrameParser& get_parser();
+
+protected:
+    std::string m_port_name;  // name of the port that the transport talks over
+
+private:
+    std::unique_ptr<FrameParser> m_parser;  // replies read from this port, kept between reads
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -17,10 +17,9 @@
 # pragma once
 
 #include <Mahi/Fes/Core/Message.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
 #include <string>
 
-#include "Windows.h"
-
 namespace mahi {
 namespace fes {
 
@@ -41,7 +40,7 @@ public:
     /// returns the member variable m_checksum which has already been created
     unsigned char get_checksum();
     /// writes the message to the serial port
-    bool write(HANDLE hComm, const std::string& activity);
+    bool write(Transport* transport, const std::string& activity);
     
     unsigned char m_checksum;  // checksum of the given message
 
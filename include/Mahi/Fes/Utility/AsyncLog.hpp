@@ -0,0 +1,154 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/MpscRing.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mahi {
+namespace fes {
+
+/// One line of text or one frame waiting to be logged
+struct LogRecord {
+    static const size_t TEXT_SIZE = 160;  // longest text kept (longer lines are cut short)
+    static const size_t DATA_SIZE = 80;   // longest frame kept (more than any message to or from the UECU)
+
+    enum Kind : unsigned char { Text, Frame };
+
+    int64_t        time_ns;          // steady clock time it was posted
+    unsigned char  severity;         // mahi::util::Severity
+    unsigned char  kind;             // Text, or a Frame labelled by text
+    unsigned short text_size;        // bytes used in text
+    unsigned short data_size;        // bytes used in data
+    char           text[TEXT_SIZE];  // the text, or the label of a frame
+    unsigned char  data[DATA_SIZE];  // the bytes of a frame
+};
+
+/// What a rate-limited message is about. Each topic has its own limit for every channel, so one
+/// channel saturating does not hide the warnings of another
+enum class LogTopic {
+    AmplitudeClamp,   // amplitude commanded above the channel's maximum
+    PulsewidthClamp,  // pulsewidth commanded above the channel's maximum
+    MissingEvent,     // no event for a channel on a scheduler
+    MissingChannel,   // no channel on a stimulator
+    InvalidReply,     // a reply that was invalid or an error (keyed by port)
+    BadMeasurement    // a controller measurement that was not a finite number
+};
+
+/// returns the rate limit key of a topic on a channel (or port)
+inline size_t log_key(LogTopic topic, unsigned int channel_num) { return (size_t)topic * 32 + (channel_num & 31); }
+
+/// Logs from the threads that send updates without ever blocking them. Lines and frames are copied
+/// into a lock-free ring, and a background thread formats them and hands them to the mahi::util log
+/// (and frames to a binary dump file, if one is open). Messages that can repeat every tick, like a
+/// controller saturating a channel, are rate limited per topic and channel: the first goes out, the
+/// repeats within the interval are only counted, and the next one out says how many were left out.
+class AsyncLog {
+public:
+    static const size_t CAPACITY  = 1024;  // records that can wait at once before new ones are dropped
+    static const size_t RATE_KEYS = 256;   // number of separately rate-limited keys (see log_key)
+
+    /// returns the log, starting its thread on first use
+    static AsyncLog& get();
+    /// AsyncLog destructor. Writes out whatever is still waiting
+    ~AsyncLog();
+    /// queues a record. Returns false (and counts it) if the ring was full
+    bool post(const LogRecord& record);
+    /// queues a frame with a label. Longer frames are cut to LogRecord::DATA_SIZE bytes
+    bool post_frame(mahi::util::Severity severity, const char* label, const unsigned char* bytes, size_t size);
+    /// returns whether a message with key may go out now. If not, it is counted as suppressed
+    bool allow(size_t key);
+    /// returns and clears the number of messages with key suppressed since the last one went out
+    uint32_t take_suppressed(size_t key);
+    /// sets how long a rate-limited message is held back after one with the same key (1 s by default)
+    void set_rate_limit(mahi::util::Time interval_);
+    /// writes every frame to filename_ as binary records from now on, instead of logging their bytes as
+    /// hex. Each record is the time (int64 ns), the label length and label, and the frame length and
+    /// bytes. An empty filename_ closes the file. Returns false if it could not be opened
+    bool set_frame_dump(const std::string& filename_);
+    /// waits until everything posted before the call has been written
+    void flush();
+    /// returns the number of records dropped because the ring was full
+    size_t get_dropped_count() const;
+
+private:
+    /// AsyncLog constructor
+    AsyncLog();
+    /// body of the background thread
+    void drain_loop();
+    /// writes out one record (background thread only)
+    void write(const LogRecord& record);
+
+    MpscRing<LogRecord, CAPACITY> m_ring;                  // records waiting to be written
+    std::atomic<size_t>           m_posted;                // records queued
+    std::atomic<size_t>           m_written;               // records written
+    std::atomic<size_t>           m_dropped;               // records dropped because the ring was full
+    std::atomic<size_t>           m_dropped_reported;      // dropped records already reported in the log
+    std::atomic<int64_t>          m_rate_limit_ns;         // time a rate-limited key is held back
+    std::atomic<int64_t>          m_last_ns[RATE_KEYS];    // when each key last went out
+    std::atomic<uint32_t>         m_suppressed[RATE_KEYS]; // messages of each key held back since
+    std::FILE*                    m_dump;                  // binary frame dump, if open
+    std::mutex                    m_dump_mtx;              // keeps the dump open while a frame is written to it
+    std::atomic<bool>             m_stop;                  // asks the thread to exit
+    std::thread                   m_thread;                // drains the ring
+};
+
+/// Builds one line of text in a LogRecord without allocating, and queues it when it goes out of scope.
+/// Used through LOG_ASYNC and LOG_LIMITED, in the same way as LOG
+class AsyncLogLine {
+public:
+    static const size_t NO_KEY = (size_t)-1;  // the line is not rate limited
+
+    /// AsyncLogLine constructor. A rate-limited line ends by saying how many of its key were suppressed
+    explicit AsyncLogLine(mahi::util::Severity severity, size_t key = NO_KEY);
+    /// queues the line
+    ~AsyncLogLine();
+    AsyncLogLine& operator<<(const char* text);
+    AsyncLogLine& operator<<(const std::string& text);
+    AsyncLogLine& operator<<(char c);
+    AsyncLogLine& operator<<(int value);
+    AsyncLogLine& operator<<(unsigned int value);
+    AsyncLogLine& operator<<(long value);
+    AsyncLogLine& operator<<(unsigned long value);
+    AsyncLogLine& operator<<(long long value);
+    AsyncLogLine& operator<<(unsigned long long value);
+    AsyncLogLine& operator<<(double value);
+
+private:
+    /// appends size bytes of text, cutting the line short if it is full
+    void append(const char* text, size_t size);
+
+    LogRecord m_record;  // the line being built
+    size_t    m_key;     // rate limit key, or NO_KEY
+};
+
+}  // namespace fes
+}  // namespace mahi
+
+/// logs a line from a real-time thread without blocking, eg. LOG_ASYNC(Warning) << "Clamped to " << max;
+#define LOG_ASYNC(severity) ::mahi::fes::AsyncLogLine(::mahi::util::severity)
+/// logs a line that may repeat every tick at most once per rate limit interval for its key (see log_key)
+#define LOG_LIMITED(severity, key)                  \
+    if (!::mahi::fes::AsyncLog::get().allow(key)) { \
+    } else                                          \
+        ::mahi::fes::AsyncLogLine(::mahi::util::severity, key)
@@ -1,18 +1,31 @@
 #pragma once
 
-#include <Windows.h>
-
 #include <Mahi/Util.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/FrameParser.hpp>
 #include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
 #include <queue>
 
 namespace mahi {
 namespace fes {
 /// continues to read messages while messages are available and returns all read messages
-std::vector<ReadMessage> get_all_messages(std::vector<HANDLE*> hComms, size_t num_ports);
+std::vector<ReadMessage> get_all_messages(const std::vector<Transport*>& transports, size_t num_ports);
+/// returns all messages that have fully arrived without waiting. A message that is only partly in is
+/// held by the transport's parser and returned by a later call once the rest arrives
+std::vector<ReadMessage> get_all_messages(const std::vector<Transport*>& transports, std::vector<FrameParser>& parsers,
+                                          size_t num_ports);
 /// currently prints out all of the new incoming messages in a readable format to the commmand line
-void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages);
-/// reads a single message from the serial handle. 
-std::vector<unsigned char> read_message(HANDLE hComm, bool should_wait, mahi::util::Time timeout = mahi::util::seconds(1));
+void process_inc_messages(Transport* transport, std::queue<ReadMessage> &inc_messages);
+/// reads a single message from the serial handle. If should_wait is false, only a message that has
+/// already started arriving is read (waiting up to timeout for the rest of it). These reads share
+/// the transport's parser, so a message cut off by a timeout is finished by the next read
+std::vector<unsigned char> read_message(Transport* transport, bool should_wait, mahi::util::Time timeout = mahi::util::seconds(1));
+/// reads a single message into frame without allocating. Returns false if no complete message
+/// arrives within timeout. Bytes that do not form a message are skipped
+bool read_frame(Transport* transport, ReadFrame& frame, mahi::util::Time timeout);
+/// waits up to timeout for a reply of msg_type and reads it into frame, skipping any other replies.
+/// Returns false if it does not arrive in time or the UECU sends an error report instead
+bool wait_for_reply(Transport* transport, unsigned char msg_type, ReadFrame& frame, mahi::util::Time timeout);
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Headless UECU emulator. It opens a pseudo-terminal whose slave side can be handed to a
+/// SerialTransport (or directly to a Stimulator), decodes the UECU message set, replies with
+/// CRC-correct CreateScheduleReply/CreateEventReply messages, and models the schedule periods
+/// and event delays in simulated time so that pulse timing and command-to-pulse latency can be
+/// measured without hardware. It can either run on its own thread (start/stop) or be stepped
+/// manually with service and advance.
+class Emulator {
+public:
+    /// A single stimulation pulse delivered by the emulated board
+    struct Pulse {
+        mahi::util::Time time;           // simulated time the pulse was delivered
+        unsigned char    event_id;       // id of the event that produced the pulse
+        unsigned char    board_channel;  // channel on the board (0 through 3)
+        unsigned char    pulse_width;    // pulse width of the pulse (us)
+        unsigned char    amplitude;      // amplitude of the pulse (mA)
+    };
+
+    /// Statistics of the time between a CHANGE_EVENT_PARAMS message arriving and the first
+    /// pulse that uses the new parameters, in simulated time
+    struct LatencyStats {
+        size_t           count = 0;                     // number of commands that reached a pulse
+        mahi::util::Time min   = mahi::util::Time::Zero;  // shortest command-to-pulse latency
+        mahi::util::Time max   = mahi::util::Time::Zero;  // longest command-to-pulse latency
+        mahi::util::Time mean  = mahi::util::Time::Zero;  // average command-to-pulse latency
+    };
+
+    /// Emulator constructor
+    Emulator();
+    /// Emulator destructor
+    ~Emulator();
+    /// opens the pseudo-terminal. Returns false if it could not be created
+    bool open();
+    /// stops the emulator thread if it is running and closes the pseudo-terminal
+    void close();
+    /// returns the path of the slave side of the pseudo-terminal (eg. /dev/pts/3)
+    std::string get_port_name();
+    /// starts a thread which services the pseudo-terminal and advances simulated time at
+    /// time_scale times real time (eg. 100 runs the schedules 100x faster than real time)
+    void start(double time_scale_ = 1.0);
+    /// stops the emulator thread
+    void stop();
+    /// reads and handles every message currently waiting on the pseudo-terminal without blocking.
+    /// Returns the number of messages handled
+    size_t service();
+    /// handles raw bytes as if they had arrived on the pseudo-terminal
+    void feed(const unsigned char* data, size_t size);
+    /// advances simulated time by dt, delivering every pulse that falls within it
+    void advance(mahi::util::Time dt);
+    /// returns the current simulated time
+    mahi::util::Time get_sim_time();
+    /// sets a function to be called for every pulse delivered (called with the emulator locked)
+    void set_pulse_callback(std::function<void(const Pulse&)> callback_);
+    /// returns the number of pulses delivered on a board channel (0 through 3)
+    size_t get_pulse_count(unsigned char board_channel_);
+    /// returns the total number of messages received
+    size_t get_message_count();
+    /// returns the number of messages that failed their checksum or were not understood
+    size_t get_error_count();
+    /// returns whether any schedule is currently running
+    bool is_running();
+    /// returns the command-to-pulse latency statistics
+    LatencyStats get_latency_stats();
+
+private:
+    struct ChannelState {
+        bool          setup     = false;  // whether a channel setup message was received
+        unsigned char amp_limit = 0;      // amplitude limit (mA)
+        unsigned char pw_limit  = 0;      // pulse width limit (us)
+    };
+
+    struct ScheduleState {
+        unsigned char    sync_char     = 0;                       // sync character that starts the schedule
+        mahi::util::Time duration      = mahi::util::Time::Zero;  // period of the schedule (0 runs once)
+        bool             running       = false;                   // whether the schedule has been synced
+        mahi::util::Time start         = mahi::util::Time::Zero;  // simulated time the schedule was synced
+        bool             switching     = false;                   // whether a period change awaits the period boundary
+        mahi::util::Time switch_at     = mahi::util::Time::Zero;  // simulated time the period change takes effect
+        mahi::util::Time next_duration = mahi::util::Time::Zero;  // period that takes effect at switch_at
+    };
+
+    struct EventState {
+        unsigned char    schedule_id   = 0;                       // schedule the event belongs to
+        mahi::util::Time delay         = mahi::util::Time::Zero;  // delay from the start of the schedule
+        unsigned char    priority      = 0;                       // priority (unused)
+        unsigned char    event_type    = 0;                       // event type
+        unsigned char    board_channel = 0;                       // channel on the board
+        unsigned char    pulse_width   = 0;                       // current pulse width
+        unsigned char    amplitude     = 0;                       // current amplitude
+        mahi::util::Time next_pulse    = mahi::util::Time::Zero;  // simulated time of the next pulse
+        bool             pending       = false;                   // whether a parameter change awaits a pulse
+        mahi::util::Time changed_at    = mahi::util::Time::Zero;  // simulated time of the last parameter change
+    };
+
+    /// handles a single complete, checksum-verified message from the host
+    void handle_message(const unsigned char* msg, size_t size);
+    /// sends a reply message with the Amulet header and UECU CRC
+    void send_reply(unsigned char msg_type, const std::vector<unsigned char>& data);
+    /// sends an ERROR_REPORT_MSG for a message that could not be processed
+    void send_error(unsigned char error_code, unsigned char failed_msg_type);
+    /// schedules the next pulse of an event relative to the current simulated time
+    void arm_event(EventState& event, const ScheduleState& schedule);
+    /// applies a pending period change, restarting the schedule's periods at start
+    void switch_period(unsigned char schedule_id, ScheduleState& schedule, mahi::util::Time start);
+    /// the emulator thread loop
+    void run();
+
+    int                                  m_master_fd = -1;         // master side of the pseudo-terminal
+    std::string                          m_port_name;              // slave side path of the pseudo-terminal
+    std::mutex                           m_mtx;                    // protects all emulator state
+    std::thread                          m_thread;                 // thread servicing the emulator when started
+    std::atomic<bool>                    m_running;                // whether the thread should keep running
+    double                               m_time_scale = 1.0;       // simulated time per unit real time
+    mahi::util::Time                     m_sim_time;               // current simulated time
+    std::vector<unsigned char>           m_rx_buffer;              // bytes received but not yet handled
+    ChannelState                         m_channels[4];            // the four channels on the board
+    std::map<unsigned char, ScheduleState> m_schedules;            // schedules by schedule id
+    std::map<unsigned char, EventState>  m_events;                 // events by event id
+    unsigned char                        m_next_schedule_id = 1;   // id given to the next created schedule
+    unsigned char                        m_next_event_id    = 1;   // id given to the next created event
+    size_t                               m_pulse_counts[4] = {0};  // pulses delivered per board channel
+    size_t                               m_msg_count       = 0;    // total messages received
+    size_t                               m_error_count     = 0;    // messages that were rejected
+    LatencyStats                         m_latency;                // command-to-pulse latency statistics
+    mahi::util::Time                     m_latency_sum;            // running sum for the mean latency
+    std::function<void(const Pulse&)>    m_pulse_callback;         // called for every delivered pulse
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,72 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// A file read or written through memory mappings of regions of it. On Windows this wraps
+/// CreateFileMapping/MapViewOfFile, and everywhere else mmap. Regions must start at a multiple of
+/// get_alignment(), so files written in fixed-size chunks map one chunk at a time and never need
+/// to map the whole file, however long it grows.
+class MappedFile {
+public:
+    enum Mode { Read, Write };
+
+    /// MappedFile constructor (no file)
+    MappedFile();
+    /// MappedFile destructor. Closes the file; regions still mapped must have been unmapped
+    ~MappedFile();
+    /// opens filename_ for reading, or creates (or empties) it for writing. Returns false (and logs) on failure
+    bool open(const std::string& filename_, Mode mode_);
+    /// closes the file
+    void close();
+    /// returns whether a file is open
+    bool is_open() const;
+    /// returns the size of the file (bytes)
+    size_t size() const;
+    /// reserves disk space so that the file is at least size_ bytes (write mode). Reserving ahead of
+    /// writing means a full disk fails here rather than when a mapped page is first touched
+    bool reserve(size_t size_);
+    /// sets the size of the file, which must have no regions mapped past size_ (write mode)
+    bool truncate(size_t size_);
+    /// maps size_ bytes at offset_, which must be a multiple of get_alignment(). In write mode the
+    /// file is grown to cover the region first. Returns nullptr (and logs) on failure
+    unsigned char* map(size_t offset_, size_t size_);
+    /// unmaps a region returned by map
+    void unmap(unsigned char* region_, size_t size_);
+    /// asks the OS to write a mapped region back to disk, waiting for it to finish if wait_ is set
+    void flush(unsigned char* region_, size_t size_, bool wait_);
+    /// returns the alignment of region offsets (the page size, or the allocation granularity on Windows)
+    static size_t get_alignment();
+
+private:
+    std::string m_filename;  // name of the open file
+    Mode        m_mode;      // whether the file was opened for reading or writing
+    size_t      m_size;      // size of the file
+#ifdef _WIN32
+    void*       m_handle;    // Win32 HANDLE to the file
+#else
+    int         m_fd;        // file descriptor of the file
+#endif
+};
+
+}  // namespace fes
+}  // namespace mahi
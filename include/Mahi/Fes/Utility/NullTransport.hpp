@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Transport.hpp>
+
+namespace mahi {
+namespace fes {
+
+/// Transport that accepts every write and never has anything to read, with no board behind it. It
+/// counts the bytes written, so benchmarks and examples can measure the cost of building and sending
+/// messages, or how many bytes a tick sends, without a port or an Emulator.
+class NullTransport : public Transport {
+public:
+    /// NullTransport constructor. baud_rate_ is what get_baud_rate reports, which sets how many bytes a
+    /// Scheduler budgets for each period
+    NullTransport(unsigned int baud_rate_ = 9600);
+    /// does nothing, since there is no port to open
+    bool open() override;
+    /// does nothing, since there is no port to close
+    void close() override;
+    /// returns true
+    bool is_open() override;
+    /// counts the bytes as written. Returns false only if data is nullptr
+    bool write(const unsigned char* data, size_t size) override;
+    /// returns 0, as if timeout elapsed without a reply
+    int read(unsigned char* data, size_t size, mahi::util::Time timeout) override;
+    /// does nothing, since nothing is ever waiting
+    void purge() override;
+    /// returns the baud rate given to the constructor
+    unsigned int get_baud_rate() override;
+    /// returns the number of bytes written since construction or the last reset_bytes_written
+    size_t get_bytes_written() const;
+    /// sets the number of bytes written back to zero
+    void reset_bytes_written();
+
+private:
+    unsigned int m_baud_rate;      // baud rate reported to the scheduler
+    size_t       m_bytes_written;  // bytes written since the last reset
+};
+
+}  // namespace fes
+}  // namespace mahi
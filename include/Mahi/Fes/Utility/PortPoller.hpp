@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Util.hpp>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// Waits on many transports at once and reports which ones have bytes to read, so a single thread
+/// can service every board of every stimulator. On Linux this is one epoll set, on other POSIX
+/// systems poll(), and transports without a file descriptor (eg. Windows COM ports) are checked
+/// every millisecond instead.
+class PortPoller {
+public:
+    /// PortPoller constructor (no transports)
+    PortPoller();
+    /// PortPoller destructor
+    ~PortPoller();
+    /// adds a transport. Its index in the results of wait is the number of transports added before it
+    bool add(Transport* transport_);
+    /// removes every transport
+    void clear();
+    /// returns the number of transports being waited on
+    size_t size() const;
+    /// waits up to timeout for any transport to have bytes to read, and fills ready with the index
+    /// of each one that does. Returns the number of ready transports
+    size_t wait(mahi::util::Time timeout, std::vector<size_t>& ready);
+
+private:
+    PortPoller(const PortPoller&) = delete;
+    PortPoller& operator=(const PortPoller&) = delete;
+
+    std::vector<Transport*> m_transports;   // transports in the order they were added
+    std::vector<int>        m_fds;          // file descriptor of each transport, or -1
+    size_t                  m_num_polled;   // number of transports with a file descriptor
+    int                     m_epoll_fd;     // epoll set of every file descriptor (Linux only, otherwise -1)
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Utility/MappedFile.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mahi {
+namespace fes {
+
+/// How a profile is read between its samples
+enum class Interpolation {
+    Nearest,  // the closest sample
+    Linear,   // a straight line between the samples either side
+    Cubic     // a Catmull-Rom spline through the two samples either side
+};
+
+/// What a profile gives past its last sample
+enum class ProfileEnd {
+    Hold,  // the last sample
+    Zero,  // zero
+    Loop,  // starts over from the first sample
+    Stop   // nothing, so sample returns false
+};
+
+/// Header at the start of a binary profile file. The samples follow it as 32-bit floats, each channel's
+/// samples together in time order, one channel after another. Files are written in the byte order of
+/// the machine that wrote them
+struct ProfileHeader {
+    char     magic[8];        // "FESPROFL"
+    uint32_t version;         // Profile::VERSION
+    uint32_t channel_count;   // columns of samples
+    uint64_t sample_count;    // samples per channel
+    int64_t  sample_period;   // time between samples (us)
+    unsigned char reserved[32];
+};
+
+/// A set of trajectories (eg. desired joint angles or open-loop pulsewidths) sampled at a fixed rate,
+/// for any number of channels and of any length. Samples are stored by channel so that each channel is
+/// one contiguous array, and looking up a time is O(1) whatever the length. Text files are parsed once;
+/// binary files are memory mapped rather than read, so opening a long trial costs nothing up front and
+/// only the pages that are used are ever loaded.
+class Profile {
+public:
+    static const uint32_t VERSION = 1;
+
+    /// Profile constructor (empty)
+    Profile();
+    /// Profile destructor. Unmaps the file if there is one
+    ~Profile();
+    Profile(const Profile&) = delete;
+    Profile& operator=(const Profile&) = delete;
+    /// loads a text file with one row per sample and one column per channel, separated by spaces,
+    /// tabs or commas. If time_column_ is set, the first column is the time of each row (s) and the rows
+    /// must be evenly spaced; otherwise they are sample_period_ apart. Lines starting with # are skipped
+    bool load_text(const std::string& filename_, mahi::util::Time sample_period_, bool time_column_ = false);
+    /// maps a binary profile file written by save_binary. Fails if the header has no samples, a sample
+    /// period that is not greater than zero, or more samples than the file holds
+    bool load_binary(const std::string& filename_);
+    /// sets the samples directly from channel_count_ arrays of sample_count_ samples, one after another
+    bool set_samples(size_t channel_count_, size_t sample_count_, mahi::util::Time sample_period_, const float* samples_);
+    /// writes the profile as a binary file. Fails for a profile without samples or a sample period
+    bool save_binary(const std::string& filename_) const;
+    /// empties the profile, unmapping its file if it has one
+    void clear();
+
+    /// sets how the profile is read between samples (Linear by default)
+    void set_interpolation(Interpolation interpolation_);
+    /// sets what the profile gives past its last sample (Hold by default)
+    void set_end_policy(ProfileEnd end_);
+
+    /// reads channel_ at time_ (from the first sample). Times before the first sample give the first
+    /// sample. Returns false if there is no such channel, or if time_ is past the end and the policy is Stop
+    bool sample(size_t channel_, mahi::util::Time time_, double& value_) const;
+    /// reads every channel at time_ into values_, which must hold get_channel_count() values
+    bool sample_all(mahi::util::Time time_, double* values_) const;
+    /// returns whether time_ is past the last sample
+    bool is_finished(mahi::util::Time time_) const;
+
+    /// returns the number of channels
+    size_t get_channel_count() const;
+    /// returns the number of samples in each channel
+    size_t get_sample_count() const;
+    /// returns the time between samples
+    mahi::util::Time get_sample_period() const;
+    /// returns the time of the last sample
+    mahi::util::Time get_duration() const;
+    /// returns the samples of channel_, or nullptr if there is no such channel
+    const float* get_channel(size_t channel_) const;
+
+private:
+    /// points the profile at samples that are already in place
+    void attach(const float* samples, size_t channel_count, size_t sample_count, int64_t sample_period_us);
+    /// reads one channel at a position counted in samples
+    double interpolate(const float* samples, double position) const;
+
+    std::vector<float> m_owned;               // samples loaded from text or set directly
+    MappedFile         m_file;                // binary file the samples are mapped from
+    unsigned char*     m_region;              // mapped binary file, or nullptr
+    size_t             m_region_size;         // size of m_region
+    const float*       m_samples;             // first sample of the first channel
+    size_t             m_channel_count;       // number of channels
+    size_t             m_sample_count;        // samples in each channel
+    int64_t            m_sample_period_us;    // time between samples (us)
+    double             m_rate;                // samples per us
+    Interpolation      m_interpolation;       // how the profile is read between samples
+    ProfileEnd         m_end;                 // what the profile gives past its last sample
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <Mahi/Fes/Utility/SessionRecorder.hpp>
+#include <memory>
+
+namespace mahi {
+namespace fes {
+
+/// Transport that passes everything through to another and records the frames that go each way in
+/// a SessionRecorder. Every successful write is recorded as it was sent (an update can hold the
+/// frames of several channels). Every read is recorded as it came in (FrameDirection::RxRaw), so
+/// bytes that were not part of a valid reply are kept too, and the bytes read are also run through a
+/// FrameParser of its own so that each reply is recorded whole (FrameDirection::Rx), however the reads
+/// split it up. Give a Stimulator these in place of its transports to record a session.
+class RecordingTransport : public Transport {
+public:
+    /// RecordingTransport constructor. Frames are recorded as going to or from board port_
+    RecordingTransport(std::shared_ptr<Transport> transport_, SessionRecorder* recorder_, unsigned char port_);
+    /// opens the wrapped transport
+    bool open() override;
+    /// closes the wrapped transport
+    void close() override;
+    /// returns whether the wrapped transport is open
+    bool is_open() override;
+    /// writes to the wrapped transport, recording the bytes if the write succeeded
+    bool write(const unsigned char* data, size_t size) override;
+    /// reads from the wrapped transport, recording the bytes read and every reply they complete
+    int read(unsigned char* data, size_t size, mahi::util::Time timeout) override;
+    /// purges the wrapped transport and drops any partly read reply
+    void purge() override;
+    /// drains the wrapped transport
+    bool drain() override;
+    /// returns the baud rate of the wrapped transport
+    unsigned int get_baud_rate() override;
+    /// returns the poll descriptor of the wrapped transport
+    int get_poll_fd() override;
+
+private:
+    std::shared_ptr<Transport> m_transport;  // the transport to the UECU
+    SessionRecorder*           m_recorder;   // where the frames are recorded
+    unsigned char              m_port;       // board the transport talks to
+    FrameParser                m_parser;     // finds the replies in the bytes read
+};
+
+}  // namespace fes
+}  // namespace mahi
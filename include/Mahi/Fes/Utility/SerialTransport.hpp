@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Core/Transport.hpp>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// Serial port transport for talking to a UECU board. On Windows this wraps a COM port opened
+/// with CreateFileW, and everywhere else it wraps a termios tty (eg. /dev/ttyUSB0 or the slave
+/// side of a pseudo-terminal) opened in non-blocking mode and driven with poll().
+class SerialTransport : public Transport {
+public:
+    /// SerialTransport constructor. The port should be formatted COMX/COMXX on Windows or as a
+    /// device path (eg. /dev/ttyUSB0) on Linux
+    SerialTransport(const std::string& port_name_, unsigned int baud_rate_ = 9600);
+    /// SerialTransport destructor
+    ~SerialTransport();
+    /// opens and configures the serial port for 8N1 communication without flow control
+    bool open() override;
+    /// closes the serial port
+    void close() override;
+    /// returns whether or not the serial port is open
+    bool is_open() override;
+    /// writes size bytes to the serial port, waiting at most the write timeout for room in the driver
+    bool write(const unsigned char* data, size_t size) override;
+    /// reads up to size bytes, waiting at most timeout for the first byte
+    int read(unsigned char* data, size_t size, mahi::util::Time timeout) override;
+    /// discards any bytes waiting in the driver buffers
+    void purge() override;
+    /// waits until the driver has sent every byte written (tcdrain, or FlushFileBuffers on Windows)
+    bool drain() override;
+    /// returns the baud rate the port was configured with
+    unsigned int get_baud_rate() override;
+    /// returns the file descriptor of the tty (-1 on Windows, where COM ports cannot be polled)
+    int get_poll_fd() override;
+    /// sets how long write will wait for the driver to accept all bytes before failing
+    void set_write_timeout(mahi::util::Time write_timeout_);
+
+private:
+    /// configures the port settings (baud rate, 8N1, no flow control, timeouts)
+    bool configure_port();
+
+    unsigned int     m_baud_rate;                                        // baud rate of the port
+    mahi::util::Time m_write_timeout = mahi::util::milliseconds(50);     // maximum time to wait for a write to finish
+#ifdef _WIN32
+    void*            m_handle;                                           // Win32 HANDLE to the COM port
+    long             m_read_timeout_ms = -1;                             // read timeout currently applied to the port
+#else
+    int              m_fd;                                               // file descriptor of the tty
+#endif
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <Mahi/Fes/Utility/MappedFile.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace mahi {
+namespace fes {
+
+/// Which way a recorded frame went
+enum class FrameDirection : unsigned char {
+    Tx    = 0,  // written to the UECU
+    Rx    = 1,  // reply received from the UECU
+    RxRaw = 2   // bytes as read from the UECU, before they are split into replies (noise and all)
+};
+
+/// Start of every chunk of a session file, as it is laid out on disk. Every chunk describes
+/// itself, so a file cut short by a crash can still be read up to its last committed record
+struct SessionChunkHeader {
+    char     magic[8];        // "FESCHUNK"
+    uint32_t version;         // SessionRecorder::VERSION
+    uint32_t chunk_size;      // bytes in every chunk, this header included
+    uint64_t index;           // position of the chunk in the file
+    int64_t  origin_ns;       // steady clock time (ns) the session started, which record times are relative to
+    int64_t  origin_unix_ns;  // wall clock time (ns since the Unix epoch) the session started
+    uint32_t committed;       // bytes of complete records after this header
+    uint32_t record_count;    // number of complete records in the chunk
+    uint8_t  reserved[16];    // zero
+};
+
+/// Start of every record in a chunk. The frame follows, and the next record starts at the next multiple of 8 bytes
+struct SessionRecordHeader {
+    int64_t  time_ns;    // steady clock time since the session started
+    uint16_t size;       // bytes in the frame
+    uint8_t  direction;  // FrameDirection
+    uint8_t  port;       // board the frame went to or came from
+    uint32_t reserved;   // zero
+};
+
+/// Records every frame written to and read from the boards into an append-only binary file, for
+/// auditing the stimulation delivered in a session or replaying it. The file is written through a
+/// memory mapping of one fixed-size chunk at a time, so recording a frame is a copy into memory under
+/// an uncontended lock. A background thread keeps the next chunk mapped and disk space reserved ahead
+/// of the writer, unmaps full chunks, and asks the OS to write back the current one periodically. A
+/// record is only counted in its chunk's header once it is complete, so a crash never leaves a torn one.
+class SessionRecorder {
+public:
+    static const uint32_t VERSION            = 2;          // version of the file layout (2 added FrameDirection::RxRaw)
+    static const size_t   DEFAULT_CHUNK_SIZE = 1u << 20;   // 1 MiB
+
+    /// SessionRecorder constructor (not recording)
+    SessionRecorder();
+    /// SessionRecorder destructor. Closes the file
+    ~SessionRecorder();
+    /// creates filename_ and starts recording into it. The chunk size is rounded up to a multiple of 64 KiB
+    bool open(const std::string& filename_, size_t chunk_size_ = DEFAULT_CHUNK_SIZE);
+    /// writes back and closes the file, trimming the chunk reserved ahead
+    void close();
+    /// returns whether a file is being recorded
+    bool is_open() const;
+    /// records a frame. Safe to call from any thread. Returns false (and counts the frame as dropped)
+    /// if no file is open, the frame does not fit in a chunk, or the next chunk was not ready in time
+    bool record(FrameDirection direction_, unsigned char port_, const unsigned char* bytes_, size_t size_);
+    /// sets how often the current chunk is written back to disk (100 ms by default)
+    void set_flush_interval(mahi::util::Time interval_);
+    /// returns the number of frames recorded
+    size_t get_record_count() const;
+    /// returns the number of frames that could not be recorded
+    size_t get_dropped_count() const;
+    /// returns the number of chunks started
+    size_t get_chunk_count() const;
+
+private:
+    /// maps the chunk at index and writes its header. Returns nullptr on failure
+    unsigned char* prepare_chunk(uint64_t index);
+    /// body of the background thread
+    void maintain_loop();
+
+    MappedFile           m_file;                // the session file
+    size_t               m_chunk_size = 0;      // bytes in every chunk
+    int64_t              m_origin_ns = 0;       // steady clock time the session started
+    int64_t              m_origin_unix_ns = 0;  // wall clock time the session started
+    std::mutex           m_mtx;                 // guards the chunk pointers and m_used
+    unsigned char*       m_chunk = nullptr;     // chunk being written
+    uint64_t             m_chunk_index = 0;     // index of m_chunk in the file
+    size_t               m_used = 0;            // bytes of records in m_chunk
+    unsigned char*       m_spare = nullptr;     // next chunk, mapped ahead by the background thread
+    unsigned char*       m_retired = nullptr;   // full chunk waiting to be unmapped
+    std::atomic<size_t>  m_records{0};          // frames recorded
+    std::atomic<size_t>  m_dropped{0};          // frames not recorded
+    std::atomic<size_t>  m_chunks{0};           // chunks started
+    std::atomic<int64_t> m_flush_interval_ns{100000000};  // time between write-backs of the current chunk
+    std::atomic<bool>    m_stop{false};         // asks the background thread to exit
+    std::thread          m_thread;              // maps chunks ahead and writes them back
+};
+
+/// One frame read back from a session file. bytes points into the file and stays valid until the
+/// reader moves on to the next chunk
+struct SessionRecord {
+    int64_t              time_ns;    // steady clock time since the session started
+    FrameDirection       direction;  // which way the frame went
+    unsigned char        port;       // board the frame went to or came from
+    const unsigned char* bytes;      // the frame
+    size_t               size;       // bytes in the frame
+};
+
+/// Reads the frames of a session file in order. Only one chunk is mapped at a time, so a session of
+/// any length is read in bounded memory. A file still being recorded, or left behind by a crash, reads
+/// up to its last complete record
+class SessionReader {
+public:
+    /// SessionReader constructor (no file)
+    SessionReader();
+    /// SessionReader destructor
+    ~SessionReader();
+    /// opens a session file written by SessionRecorder. Returns false (and logs) if it is not one
+    bool open(const std::string& filename_);
+    /// closes the file
+    void close();
+    /// reads the next frame into record_. Returns false at the end of the session
+    bool next(SessionRecord& record_);
+    /// goes back to the first frame
+    bool rewind();
+    /// returns the wall clock time (ns since the Unix epoch) the session started
+    int64_t get_origin_unix_ns() const;
+
+private:
+    /// maps the chunk at index, returning false if there is no complete chunk there
+    bool load_chunk(uint64_t index);
+
+    MappedFile     m_file;                // the session file
+    size_t         m_chunk_size = 0;      // bytes in every chunk
+    int64_t        m_origin_unix_ns = 0;  // wall clock time the session started
+    unsigned char* m_chunk = nullptr;     // chunk being read
+    uint64_t       m_chunk_index = 0;     // index of m_chunk in the file
+    size_t         m_pos = 0;             // offset of the next record after the chunk header
+    size_t         m_committed = 0;       // bytes of complete records in m_chunk
+};
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+namespace mahi {
+namespace fes {
+
+/// Scheduling priority for a thread. Anything above Normal may need elevated permissions
+/// (eg. CAP_SYS_NICE or an rtprio limit on Linux)
+enum class ThreadPriority {
+    Normal,   // default OS scheduling
+    High,     // above normal, but below anything time critical
+    Realtime  // highest priority the OS allows (SCHED_FIFO on Linux, TIME_CRITICAL on Windows)
+};
+
+/// Settings applied by a thread to itself when it starts
+struct ThreadSettings {
+    ThreadSettings(int cpu_ = -1, ThreadPriority priority_ = ThreadPriority::Normal) :
+        cpu(cpu_), priority(priority_) {}
+
+    int            cpu;       // cpu to pin the thread to, or -1 to let the OS choose
+    ThreadPriority priority;  // scheduling priority of the thread
+};
+
+/// pins the calling thread to a single cpu. Returns false (and logs) if it could not be pinned
+bool set_current_thread_affinity(int cpu);
+/// sets the scheduling priority of the calling thread. Returns false (and logs) if it could not be set
+bool set_current_thread_priority(ThreadPriority priority);
+/// applies both the affinity (if cpu is not -1) and priority of settings to the calling thread
+bool apply_current_thread_settings(const ThreadSettings& settings);
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,114 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mahi {
+namespace fes {
+
+/// How a feedback value is laid out in a datagram
+enum class SampleEncoding {
+    Float64BigEndian,     // IEEE 754 double, most significant byte first
+    Float64LittleEndian,  // IEEE 754 double, least significant byte first
+    Float32BigEndian,     // IEEE 754 float, most significant byte first
+    Float32LittleEndian   // IEEE 754 float, least significant byte first
+};
+
+/// Reads a feedback value straight out of a received datagram, without copying it anywhere first
+class SampleDecoder {
+public:
+    /// SampleDecoder constructor. The value starts offset_ bytes into each datagram
+    SampleDecoder(SampleEncoding encoding_ = SampleEncoding::Float64BigEndian, size_t offset_ = 0);
+    /// returns the bytes a datagram needs to hold a value
+    size_t get_size() const;
+    /// decodes the value in a datagram of size_ bytes. Returns false if it is too short or the value is not finite
+    bool decode(const unsigned char* data_, size_t size_, double& value_) const;
+
+private:
+    SampleEncoding m_encoding;  // layout of the value
+    size_t         m_offset;    // where the value starts in the datagram
+};
+
+/// The latest value received
+struct FeedbackSample {
+    double   value    = 0;  // decoded value (eg. a joint angle)
+    int64_t  time_ns  = 0;  // steady clock time it was received (ns)
+    uint64_t sequence = 0;  // number of valid datagrams received up to and including this one
+};
+
+/// Receives feedback (eg. joint angles from motion capture) as UDP datagrams. The socket never blocks:
+/// each call to poll drains every datagram that has arrived since the last one, in batches with
+/// recvmmsg where it is available, and keeps only the freshest value, so a control loop reading it once
+/// per period always acts on the latest measurement however fast the sender is.
+class UdpFeedback {
+public:
+    static const size_t BATCH_SIZE    = 32;   // datagrams received per system call
+    static const size_t DATAGRAM_SIZE = 256;  // largest datagram read in full; longer ones are truncated
+
+    /// UdpFeedback constructor (no socket)
+    UdpFeedback(const SampleDecoder& decoder_ = SampleDecoder());
+    /// UdpFeedback destructor. Closes the socket
+    ~UdpFeedback();
+    UdpFeedback(const UdpFeedback&) = delete;
+    UdpFeedback& operator=(const UdpFeedback&) = delete;
+
+    /// binds a UDP socket to port_ on address_ (IPv4). Port 0 picks a free port. Returns false (and logs) on failure
+    bool open(unsigned short port_, const std::string& address_ = "0.0.0.0");
+    /// closes the socket
+    void close();
+    /// returns whether the socket is open
+    bool is_open() const;
+    /// returns the port the socket is bound to
+    unsigned short get_port() const;
+    /// sets how values are decoded
+    void set_decoder(const SampleDecoder& decoder_);
+
+    /// receives every datagram waiting on the socket without blocking. Returns how many there were
+    size_t poll();
+    /// gets the latest value received. Returns false if nothing has been received yet
+    bool get_latest(FeedbackSample& sample_) const;
+
+    /// returns the number of datagrams received
+    uint64_t get_received_count() const;
+    /// returns the number of datagrams that could not be decoded
+    uint64_t get_malformed_count() const;
+    /// returns the number of values dropped because a newer one arrived in the same poll
+    uint64_t get_superseded_count() const;
+
+private:
+    typedef std::array<unsigned char, DATAGRAM_SIZE> Datagram;
+
+    /// decodes one datagram received at time_ns
+    bool accept(const unsigned char* data, size_t size, int64_t time_ns);
+
+    SampleDecoder                     m_decoder;     // decodes values from datagrams
+    int                               m_socket;      // socket, or -1
+    unsigned short                    m_port;        // port the socket is bound to
+    std::array<Datagram, BATCH_SIZE>  m_buffers;     // datagrams of one batch
+    FeedbackSample                    m_latest;      // freshest value received
+    bool                              m_has_sample;  // whether m_latest holds a value
+    uint64_t                          m_received;    // datagrams received
+    uint64_t                          m_malformed;   // datagrams that could not be decoded
+    uint64_t                          m_superseded;  // values dropped for a newer one
+};
+
+}  // namespace fes
+}  // namespace mahi
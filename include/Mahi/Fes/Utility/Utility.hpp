@@ -19,8 +19,6 @@
 #include <string>
 #include <vector>
 
-#include "Windows.h"
-
 // Message commands for sending serial packets
 #define TRIGGER_SETUP_MSG         0x03
 #define HALT_MSG                  0x04
@@ -45,12 +43,22 @@
 #define DEST_ADR 0x04
 #define SRC_ADR  0x80
 
+// Amulet header that precedes every reply from the UECU
+#define AMULET_CMD_1 0x02
+#define AMULET_CMD_2 0x34
+#define AMULET_ADR   0xAA
+
 // Length of messages which should never be changed
 #define SYNC_MSG_LEN     0x01
 #define CREATE_SCHED_LEN 0x03
 #define CH_SET_LEN       0x07
 #define CR_EVT_LEN       0x09
 #define HALT_LEN         0x01
+#define DEL_SCHED_LEN    0x01
+#define DELETE_EVENT_LEN 0x01
+#define CHANGE_EVENT_PARAMS_LEN 0x04
+#define CHANGE_SCHED_LEN        0x04
+#define CHANGE_EVENT_SCHED_LEN  0x05
 
 // Anode Cathode pairs for channels 1-4
 #define AN_CA_1 0x01
@@ -69,5 +77,8 @@ std::vector<unsigned char> int_to_twobytes(int input_int);
 std::string print_as_hex(unsigned char num);
 /// prints a single message that was given as an argument
 void print_message(std::vector<unsigned char> message);
+/// prints a single message of size bytes. This prints straight away; from a real-time thread use
+/// AsyncLog::post_frame instead
+void print_message(const unsigned char* bytes, size_t size);
 }  // namespace fes
 }  // namespace mahi
@@ -23,6 +23,7 @@ private:
     ImGuiInputTextFlags          m_enabled_flags = 0;  // flags for showing whether user can read/write or just read
     int                          rt_axis = 0;// & ImAxisFlags_TickLabels & ImAxisFlags_GridLines;  // Flags for Realtime axis
     Stimulator *                 m_stimulator;    // stimulator pointer holding information to read
+    std::vector<ChannelState>    m_snapshot;      // values of every channel read from the stimulator
     std::vector<int>             m_amp;           // amplitudes from the stimulator
     std::vector<int>             m_pw;            // pulsewidths from the stimulator
     std::vector<int>             m_max_amp;       // maximum amplitudes from the stimulator
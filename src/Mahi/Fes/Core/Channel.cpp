@@ -14,11 +14,8 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Windows.h>
-#include <tchar.h>
-
 #include <Mahi/Fes/Core/Channel.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Core/Frame.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
 
@@ -44,25 +41,18 @@ Channel::Channel(const std::string& name_, unsigned char channel_num_, unsigned
 
 Channel::~Channel() {}
 
-bool Channel::setup_channel(HANDLE serial_handle_, Time delay_time_) {
-    std::vector<unsigned char> ip_delay_bytes = int_to_twobytes(m_ip_delay);
-
-    std::vector<unsigned char> setup = {DEST_ADR,                // Destination
-                                        SRC_ADR,                 // Source
-                                        CHANNEL_SETUP_MSG,       // Msg type
-                                        CH_SET_LEN,              // Msg len
-                                        m_board_channel_num,             // Channel
-                                        (unsigned char)m_max_amp,  // AmpLim
-                                        (unsigned char)m_max_pw,   // PWLim
-                                        ip_delay_bytes[0],       // IP delay (byte 1)
-                                        ip_delay_bytes[1],       // IP delay (byte 2)
-                                        ONE_TO_ONE,              // Aspect
-                                        m_an_ca_nums,              // Anode Cathode
-                                        0x00};                   // Checksum
-
-    WriteMessage setup_message(setup);
-
-    if (setup_message.write(serial_handle_, "Setting Up Channel")) {
+bool Channel::setup_channel(Transport* transport_, Time delay_time_) {
+    ChannelSetupFrame setup;
+    unsigned char*    data = setup.data();
+    data[0] = m_board_channel_num;        // Channel
+    data[1] = (unsigned char)m_max_amp;   // AmpLim
+    data[2] = (unsigned char)m_max_pw;    // PWLim
+    data[3] = hi_byte(m_ip_delay);        // IP delay (byte 1)
+    data[4] = lo_byte(m_ip_delay);        // IP delay (byte 2)
+    data[5] = ONE_TO_ONE;                 // Aspect
+    data[6] = m_an_ca_nums;               // Anode Cathode
+
+    if (setup.write(transport_, "Setting Up Channel")) {
         // Sleep for delay time to allow the board to process
         sleep(delay_time_);
         return true;
@@ -71,20 +61,30 @@ bool Channel::setup_channel(HANDLE serial_handle_, Time delay_time_) {
     }
 }
 
-unsigned int Channel::get_max_amplitude() { return m_max_amp; }
+unsigned int Channel::get_max_amplitude() const { return m_max_amp; }
+
+unsigned int Channel::get_max_pulse_width() const { return m_max_pw; }
 
-unsigned int Channel::get_max_pulse_width() { return m_max_pw; }
+unsigned int Channel::get_ip_delay() const { return m_ip_delay; }
+
+unsigned int Channel::get_pulse_duration() const {
+    // the recovery phase balances the charge at a lower amplitude, so it lasts aspect times as long
+    unsigned int first  = m_aspect >> 4;
+    unsigned int second = m_aspect & 0x0F;
+    unsigned int recovery = second > 0 ? (m_max_pw * first + second - 1) / second : m_max_pw;
+    return m_max_pw + m_ip_delay + recovery;
+}
 
 void Channel::set_max_amplitude(unsigned int max_amp_) { m_max_amp = max_amp_; }
 
 void Channel::set_max_pulse_width(unsigned int max_pw_) { m_max_pw = max_pw_; }
 
-unsigned char Channel::get_board_num() { return m_board_num; }
+unsigned char Channel::get_board_num() const { return m_board_num; }
 
-unsigned char Channel::get_board_channel_num() { return m_board_channel_num; }
+unsigned char Channel::get_board_channel_num() const { return m_board_channel_num; }
 
-unsigned char Channel::get_channel_num() { return m_channel_num; }
+unsigned char Channel::get_channel_num() const { return m_channel_num; }
 
-std::string Channel::get_channel_name() { return m_name; }
+const std::string& Channel::get_channel_name() const { return m_name; }
 }  // namespace fes
 }  // namespace mahi
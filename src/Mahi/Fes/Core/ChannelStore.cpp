@@ -0,0 +1,254 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/ChannelStore.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+const size_t ChannelStore::CAPACITY;
+const size_t ChannelStore::WORDS;
+
+ChannelStore::ChannelStore() : m_present(0), m_sequence(0) {
+    for (size_t i = 0; i < WORDS; i++) {
+        m_amplitude[i].store(0, std::memory_order_relaxed);
+        m_pulsewidth[i].store(0, std::memory_order_relaxed);
+        m_max_amplitude[i].store(0, std::memory_order_relaxed);
+        m_max_pulse_width[i].store(0, std::memory_order_relaxed);
+        m_sent_amplitude[i].store(0, std::memory_order_relaxed);
+        m_sent_pulsewidth[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+unsigned char ChannelStore::load_byte(const Field& field, unsigned char channel_num) {
+    return (unsigned char)(field[channel_num / 8].load(std::memory_order_relaxed) >> (8 * (channel_num % 8)));
+}
+
+void ChannelStore::store_byte(Field& field, unsigned char channel_num, unsigned int value) {
+    // values above a byte never reach the UECU, so they are saturated here rather than wrapped
+    uint64_t byte  = value > 0xFF ? 0xFF : value;
+    int      shift = 8 * (channel_num % 8);
+    uint64_t word  = field[channel_num / 8].load(std::memory_order_relaxed);
+    word           = (word & ~(uint64_t(0xFF) << shift)) | (byte << shift);
+    field[channel_num / 8].store(word, std::memory_order_relaxed);
+}
+
+void ChannelStore::begin_write() {
+    // the sequence goes odd before any field changes...
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ChannelStore::end_write() {
+    // ...and back to even once every change is visible
+    m_sequence.store(m_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool ChannelStore::add_channel(unsigned char channel_num, unsigned int max_amplitude, unsigned int max_pulse_width,
+                               unsigned int amplitude, unsigned int pulsewidth) {
+    if (channel_num >= CAPACITY) {
+        LOG(Error) << "Channel number " << (int)channel_num << " is outside of the channel store.";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_max_amplitude, channel_num, max_amplitude);
+    store_byte(m_max_pulse_width, channel_num, max_pulse_width);
+    store_byte(m_amplitude, channel_num, amplitude);
+    store_byte(m_pulsewidth, channel_num, pulsewidth);
+    store_byte(m_sent_amplitude, channel_num, amplitude);
+    store_byte(m_sent_pulsewidth, channel_num, pulsewidth);
+    m_present.fetch_or(uint32_t(1) << channel_num, std::memory_order_relaxed);
+    end_write();
+    return true;
+}
+
+void ChannelStore::remove_channel(unsigned char channel_num) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    m_present.fetch_and(~(uint32_t(1) << channel_num), std::memory_order_relaxed);
+    end_write();
+}
+
+bool ChannelStore::has_channel(unsigned char channel_num) const {
+    return channel_num < CAPACITY && (m_present.load(std::memory_order_relaxed) >> channel_num) & 1;
+}
+
+void ChannelStore::reset_values(unsigned char channel_num, unsigned int amplitude, unsigned int pulsewidth) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    unsigned int max_amplitude   = load_byte(m_max_amplitude, channel_num);
+    unsigned int max_pulse_width = load_byte(m_max_pulse_width, channel_num);
+    if (amplitude > max_amplitude) amplitude = max_amplitude;
+    if (pulsewidth > max_pulse_width) pulsewidth = max_pulse_width;
+    store_byte(m_amplitude, channel_num, amplitude);
+    store_byte(m_pulsewidth, channel_num, pulsewidth);
+    store_byte(m_sent_amplitude, channel_num, amplitude);
+    store_byte(m_sent_pulsewidth, channel_num, pulsewidth);
+    end_write();
+}
+
+void ChannelStore::set_amplitude(unsigned char channel_num, unsigned int amplitude) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_amplitude, channel_num, amplitude);
+    end_write();
+}
+
+void ChannelStore::set_pulsewidth(unsigned char channel_num, unsigned int pulsewidth) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_pulsewidth, channel_num, pulsewidth);
+    end_write();
+}
+
+bool ChannelStore::set_pulsewidths(const unsigned char* channel_nums, const unsigned int* pulsewidths, size_t count) {
+    uint32_t                    present  = m_present.load(std::memory_order_relaxed);
+    bool                        all_here = true;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    for (size_t i = 0; i < count; i++) {
+        unsigned char channel_num = channel_nums[i];
+        if (channel_num >= CAPACITY || !((present >> channel_num) & 1)) {
+            all_here = false;
+            continue;
+        }
+        unsigned int max_pulse_width = load_byte(m_max_pulse_width, channel_num);
+        store_byte(m_pulsewidth, channel_num, pulsewidths[i] > max_pulse_width ? max_pulse_width : pulsewidths[i]);
+    }
+    end_write();
+    return all_here;
+}
+
+void ChannelStore::set_max_amplitude(unsigned char channel_num, unsigned int max_amplitude) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_max_amplitude, channel_num, max_amplitude);
+    if (load_byte(m_amplitude, channel_num) > load_byte(m_max_amplitude, channel_num)) {
+        store_byte(m_amplitude, channel_num, load_byte(m_max_amplitude, channel_num));
+    }
+    end_write();
+}
+
+void ChannelStore::set_max_pulse_width(unsigned char channel_num, unsigned int max_pulse_width) {
+    if (channel_num >= CAPACITY) return;
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_max_pulse_width, channel_num, max_pulse_width);
+    if (load_byte(m_pulsewidth, channel_num) > load_byte(m_max_pulse_width, channel_num)) {
+        store_byte(m_pulsewidth, channel_num, load_byte(m_max_pulse_width, channel_num));
+    }
+    end_write();
+}
+
+unsigned int ChannelStore::get_amplitude(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? load_byte(m_amplitude, channel_num) : 0;
+}
+
+unsigned int ChannelStore::get_pulsewidth(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? load_byte(m_pulsewidth, channel_num) : 0;
+}
+
+unsigned int ChannelStore::get_max_amplitude(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? load_byte(m_max_amplitude, channel_num) : 0;
+}
+
+unsigned int ChannelStore::get_max_pulse_width(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? load_byte(m_max_pulse_width, channel_num) : 0;
+}
+
+bool ChannelStore::is_dirty(unsigned char channel_num) const {
+    if (channel_num >= CAPACITY) return false;
+    return load_byte(m_amplitude, channel_num) != load_byte(m_sent_amplitude, channel_num) ||
+           load_byte(m_pulsewidth, channel_num) != load_byte(m_sent_pulsewidth, channel_num);
+}
+
+uint32_t ChannelStore::nonzero_bytes(uint64_t word) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    // the high bit of each byte is set if any bit of that byte is set, without carries between bytes
+    uint64_t high = (((word & low7) + low7) | word) & ~low7;
+    // gather the eight high bits into the top byte, byte i landing on bit 56 + i
+    return (uint32_t)(((high >> 7) * 0x0102040810204080ULL) >> 56);
+}
+
+uint32_t ChannelStore::get_dirty_mask() const {
+    uint32_t dirty = 0;
+    for (size_t i = 0; i < WORDS; i++) {
+        uint64_t changed = (m_amplitude[i].load(std::memory_order_relaxed) ^
+                            m_sent_amplitude[i].load(std::memory_order_relaxed)) |
+                           (m_pulsewidth[i].load(std::memory_order_relaxed) ^
+                            m_sent_pulsewidth[i].load(std::memory_order_relaxed));
+        dirty |= nonzero_bytes(changed) << (8 * i);
+    }
+    return dirty;
+}
+
+void ChannelStore::mark_sent(unsigned char channel_num, unsigned int amplitude, unsigned int pulsewidth) {
+    if (channel_num >= CAPACITY) return;
+    // the values that were actually encoded are recorded (not the current ones), so a change made
+    // by another thread while the update was being sent stays dirty and goes out next time
+    std::lock_guard<std::mutex> lock(m_write_mtx);
+    begin_write();
+    store_byte(m_sent_amplitude, channel_num, amplitude);
+    store_byte(m_sent_pulsewidth, channel_num, pulsewidth);
+    end_write();
+}
+
+void ChannelStore::get_snapshot(Snapshot& snapshot) const {
+    uint64_t words[4][WORDS];
+    uint64_t sent[2][WORDS];
+    uint64_t before, after;
+    do {
+        before = m_sequence.load(std::memory_order_acquire);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[0][i] = m_amplitude[i].load(std::memory_order_relaxed);
+            words[1][i] = m_pulsewidth[i].load(std::memory_order_relaxed);
+            words[2][i] = m_max_amplitude[i].load(std::memory_order_relaxed);
+            words[3][i] = m_max_pulse_width[i].load(std::memory_order_relaxed);
+            sent[0][i]  = m_sent_amplitude[i].load(std::memory_order_relaxed);
+            sent[1][i]  = m_sent_pulsewidth[i].load(std::memory_order_relaxed);
+        }
+        snapshot.present = m_present.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    snapshot.dirty    = 0;
+    snapshot.sequence = before / 2;
+    for (size_t i = 0; i < WORDS; i++) {
+        snapshot.dirty |= nonzero_bytes((words[0][i] ^ sent[0][i]) | (words[1][i] ^ sent[1][i])) << (8 * i);
+    }
+    for (size_t c = 0; c < CAPACITY; c++) {
+        int shift                   = 8 * (c % 8);
+        snapshot.amplitude[c]       = (unsigned char)(words[0][c / 8] >> shift);
+        snapshot.pulsewidth[c]      = (unsigned char)(words[1][c / 8] >> shift);
+        snapshot.max_amplitude[c]   = (unsigned char)(words[2][c / 8] >> shift);
+        snapshot.max_pulse_width[c] = (unsigned char)(words[3][c / 8] >> shift);
+    }
+}
+
+uint64_t ChannelStore::get_sequence() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+
+}  // namespace fes
+}  // namespace mahi
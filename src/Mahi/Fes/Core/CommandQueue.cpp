@@ -0,0 +1,185 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/CommandQueue.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+CommandQueue::CommandQueue(Transport* transport_, FrameParser* parser_) :
+    m_transport(transport_),
+    m_parser(parser_ ? parser_ : transport_ ? &transport_->get_parser() : nullptr),
+    m_timeout(seconds(1)),
+    m_max_retries(2),
+    m_max_outstanding(4),
+    m_retry_count(0),
+    m_failure_count(0),
+    m_unmatched_count(0) {}
+
+void CommandQueue::set_transport(Transport* transport_, FrameParser* parser_) {
+    m_transport = transport_;
+    m_parser    = parser_ ? parser_ : &transport_->get_parser();
+}
+
+void CommandQueue::set_timeout(Time timeout_) { m_timeout = timeout_; }
+
+void CommandQueue::set_max_retries(size_t max_retries_) { m_max_retries = max_retries_; }
+
+void CommandQueue::set_max_outstanding(size_t max_outstanding_) {
+    m_max_outstanding = max_outstanding_ > 0 ? max_outstanding_ : 1;
+}
+
+std::future<CommandResult> CommandQueue::submit(const unsigned char* bytes, size_t size, const ReplyMatch& match,
+                                                Callback callback) {
+    return enqueue(bytes, size, match, callback, m_max_retries);
+}
+
+std::future<CommandResult> CommandQueue::submit_once(const unsigned char* bytes, size_t size,
+                                                     const ReplyMatch& match, Callback callback) {
+    return enqueue(bytes, size, match, callback, 0);
+}
+
+std::future<CommandResult> CommandQueue::enqueue(const unsigned char* bytes, size_t size, const ReplyMatch& match,
+                                                 Callback callback, size_t max_retries) {
+    Command command = {std::vector<unsigned char>(bytes, bytes + size), match, Clock(), 0, max_retries,
+                       std::promise<CommandResult>(), callback};
+    std::future<CommandResult> result = command.promise.get_future();
+    m_waiting.push_back(std::move(command));
+    return result;
+}
+
+bool CommandQueue::send(Command& command) {
+    command.clock.restart();
+    if (!m_transport || !m_transport->write(&command.bytes[0], command.bytes.size())) {
+        LOG(Error) << "Failed to send message " << print_as_hex(command.bytes[2]) << ".";
+        return false;
+    }
+    return true;
+}
+
+bool CommandQueue::send_waiting() {
+    while (!m_waiting.empty() && m_outstanding.size() < m_max_outstanding) {
+        m_outstanding.push_back(std::move(m_waiting.front()));
+        m_waiting.pop_front();
+        // a command that cannot even be written is retried like one that was lost on the way
+        if (!send(m_outstanding.back())) retry(m_outstanding.size() - 1, "could not be written");
+    }
+    return !m_waiting.empty() || !m_outstanding.empty();
+}
+
+void CommandQueue::retry(size_t index, const char* reason) {
+    Command& command = m_outstanding[index];
+    while (command.retries < command.max_retries) {
+        command.retries++;
+        m_retry_count++;
+        LOG(Warning) << "Message " << print_as_hex(command.bytes[2]) << " " << reason << ". Resending (attempt "
+                     << command.retries + 1 << ").";
+        if (send(command)) return;
+    }
+    LOG(Error) << "Message " << print_as_hex(command.bytes[2]) << " " << reason << " and is out of retries.";
+    complete(index, false, ReadFrame());
+}
+
+void CommandQueue::complete(size_t index, bool success, const ReadFrame& reply) {
+    Command       command = std::move(m_outstanding[index]);
+    m_outstanding.erase(m_outstanding.begin() + index);
+    CommandResult result  = {success, reply};
+    if (!success) m_failure_count++;
+    if (command.callback) command.callback(result);
+    command.promise.set_value(result);
+}
+
+bool CommandQueue::matches(const ReplyMatch& match, const ReadFrame& reply) {
+    if (reply.get_type() != match.type) return false;
+    // a reply too short to hold the byte falls back to matching the oldest command of its type
+    ByteView data = reply.get_data();
+    return match.data_index < 0 || (size_t)match.data_index >= data.size || data[match.data_index] == match.value;
+}
+
+void CommandQueue::handle_reply(const ReadFrame& reply) {
+    if (reply.get_type() == ERROR_REPORT_MSG) {
+        // the error report names the type of message that failed; blame the oldest one of that type
+        ByteView data = reply.get_data();
+        for (size_t i = 0; data.size > 1 && i < m_outstanding.size(); i++) {
+            if (m_outstanding[i].bytes[2] == data[1]) {
+                retry(i, "was rejected by the UECU");
+                return;
+            }
+        }
+    } else {
+        for (size_t i = 0; i < m_outstanding.size(); i++) {
+            if (matches(m_outstanding[i].match, reply)) {
+                complete(i, true, reply);
+                return;
+            }
+        }
+    }
+    m_unmatched_count++;
+    LOG(Warning) << "Received reply " << print_as_hex(reply.get_type()) << " that did not match any message.";
+}
+
+bool CommandQueue::poll(Time timeout) {
+    send_waiting();
+
+    // wait for the first reply no longer than the oldest command has left, then take what else is in
+    ReadFrame reply;
+    Time      wait = timeout;
+    for (size_t i = 0; i < m_outstanding.size(); i++) {
+        Time left = m_timeout - m_outstanding[i].clock.get_elapsed_time();
+        if (left < wait) wait = left;
+    }
+    if (!m_outstanding.empty() && m_parser->poll(m_transport, reply, wait > Time::Zero ? wait : Time::Zero)) {
+        handle_reply(reply);
+        while (!m_outstanding.empty() && m_parser->poll(m_transport, reply)) {
+            handle_reply(reply);
+        }
+    }
+
+    for (size_t i = 0; i < m_outstanding.size();) {
+        if (m_outstanding[i].clock.get_elapsed_time() < m_timeout) {
+            i++;
+            continue;
+        }
+        size_t pending = m_outstanding.size();
+        retry(i, "timed out");
+        // a failed command is removed, so the next one is now at i
+        if (m_outstanding.size() == pending) i++;
+    }
+
+    return send_waiting();
+}
+
+bool CommandQueue::wait_all() {
+    size_t failures = m_failure_count;
+    while (poll(m_timeout)) {
+    }
+    return m_failure_count == failures;
+}
+
+size_t CommandQueue::get_pending_count() const { return m_waiting.size() + m_outstanding.size(); }
+
+size_t CommandQueue::get_retry_count() const { return m_retry_count; }
+
+size_t CommandQueue::get_failure_count() const { return m_failure_count; }
+
+size_t CommandQueue::get_unmatched_count() const { return m_unmatched_count; }
+
+}  // namespace fes
+}  // namespace mahi
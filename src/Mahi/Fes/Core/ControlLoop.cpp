@@ -0,0 +1,141 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/ControlLoop.hpp>
+#include <thread>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+const size_t ControlLoop::HISTOGRAM_BINS;
+
+namespace {
+std::chrono::steady_clock::duration to_duration(Time time) { return std::chrono::microseconds(time.as_microseconds()); }
+
+Time to_time(std::chrono::steady_clock::duration duration) {
+    return microseconds(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+}  // namespace
+
+ControlLoop::ControlLoop(Stimulator& stimulator_, Timer::WaitMode mode_) :
+    m_stimulator(stimulator_),
+    m_mode(mode_),
+    m_lead(std::chrono::milliseconds(2)),
+    m_spin_time(std::chrono::milliseconds(1)),
+    m_stop(false),
+    m_running(false) {
+    m_stats.bin_width = microseconds(10);
+    reset_stats();
+}
+
+void ControlLoop::set_wait_mode(Timer::WaitMode mode_) { m_mode = mode_; }
+
+void ControlLoop::set_lead(Time lead_) { m_lead = to_duration(lead_); }
+
+void ControlLoop::set_spin_time(Time spin_time_) { m_spin_time = to_duration(spin_time_); }
+
+void ControlLoop::set_bin_width(Time bin_width_) {
+    std::lock_guard<std::mutex> lock(m_stats_mtx);
+    m_stats.bin_width = bin_width_ > Time::Zero ? bin_width_ : microseconds(1);
+    Time bin_width    = m_stats.bin_width;
+    m_stats           = Stats();
+    m_stats.bin_width = bin_width;
+    m_lateness_sum    = Time::Zero;
+}
+
+bool ControlLoop::run(const Step& step_, size_t num_ticks) {
+    m_stop    = false;
+    m_running = true;
+
+    // the boards' periods start when the sync message was sent, so count them from there. A stimulator
+    // that has not been started has no schedule to follow yet, so the loop keeps its own from now
+    size_t            sync_count = m_stimulator.get_sync_count();
+    Clock::time_point start      = Clock::now();
+    Clock::time_point boundary   = sync_count > 0 ? m_stimulator.get_sync_time() : start;
+    Clock::duration   period     = to_duration(m_stimulator.get_period());
+    boundary += period * periods_behind(boundary, period, start);
+    Clock::time_point first = boundary;
+
+    bool success = true;
+    for (size_t tick = 0; !m_stop && (num_ticks == 0 || tick < num_ticks); tick++) {
+        Clock::time_point deadline = boundary - m_lead;
+        wait_until(deadline);
+        Time lateness = to_time(Clock::now() - deadline);
+
+        bool keep_going = step_(to_time(boundary - first));
+        if (keep_going && !m_stimulator.update()) success = false;
+        bool missed = Clock::now() > boundary;
+
+        // a resync restarts the schedules, so the periods are counted from it instead
+        if (m_stimulator.get_sync_count() != sync_count) {
+            sync_count = m_stimulator.get_sync_count();
+            boundary   = m_stimulator.get_sync_time();
+        }
+        period = to_duration(m_stimulator.get_period());
+        boundary += period;
+        // if the loop has fallen more than a period behind, skip to the next period it can still make
+        size_t skipped = periods_behind(boundary, period, Clock::now());
+        boundary += period * skipped;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mtx);
+            m_stats.ticks++;
+            if (missed) m_stats.missed++;
+            m_stats.skipped += skipped;
+            if (lateness > m_stats.max_lateness) m_stats.max_lateness = lateness;
+            m_lateness_sum += lateness;
+            m_stats.mean_lateness = m_lateness_sum / (int64_t)m_stats.ticks;
+            size_t bin = (size_t)(lateness.as_microseconds() / m_stats.bin_width.as_microseconds());
+            m_stats.lateness[bin < HISTOGRAM_BINS ? bin : HISTOGRAM_BINS - 1]++;
+        }
+        if (!keep_going || !success) break;
+    }
+
+    m_running = false;
+    return success;
+}
+
+void ControlLoop::stop() { m_stop = true; }
+
+bool ControlLoop::is_running() const { return m_running; }
+
+ControlLoop::Stats ControlLoop::get_stats() const {
+    std::lock_guard<std::mutex> lock(m_stats_mtx);
+    return m_stats;
+}
+
+void ControlLoop::reset_stats() { set_bin_width(get_stats().bin_width); }
+
+size_t ControlLoop::periods_behind(Clock::time_point boundary, Clock::duration period, Clock::time_point now) const {
+    Clock::time_point deadline = boundary - m_lead;
+    if (deadline > now || period <= Clock::duration::zero()) return 0;
+    return (size_t)((now - deadline) / period) + 1;
+}
+
+void ControlLoop::wait_until(Clock::time_point deadline) const {
+    if (m_mode == Timer::WaitMode::Sleep) {
+        std::this_thread::sleep_until(deadline);
+        return;
+    }
+    if (m_mode == Timer::WaitMode::Hybrid) std::this_thread::sleep_until(deadline - m_spin_time);
+    while (Clock::now() < deadline) {
+    }
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,215 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/ControllerBank.hpp>
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+
+/// the control law of every controller in one pass. Every array is its own member of the bank, so
+/// none of them overlap, and saying so (restrict) is what lets the compiler vectorize the pass instead
+/// of giving up on checking each pair of arrays at run time
+void control_pass(size_t n, double dt, double inv_dt, double filter_dt, double filtering, double rate_dt,
+                  const double* __restrict kp, const double* __restrict ki, const double* __restrict kd,
+                  const double* __restrict filter, const double* __restrict ff_gain, const double* __restrict rate,
+                  const double* __restrict lo_limit, const double* __restrict hi_limit,
+                  const double* __restrict reference, const double* __restrict ff, const double* __restrict measured,
+                  const double* __restrict hold, double* __restrict error, double* __restrict integral,
+                  double* __restrict derivative, double* __restrict last_y, double* __restrict output) {
+    const double unlimited = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < n; i++) {
+        double y = measured[i];
+        double e = reference[i] - y;
+
+        // derivative of the measurement rather than the error, so a step in the reference does not kick.
+        // The filter is skipped if there is no time step to weigh it against (a stimulator with no period)
+        double alpha = filtering * filter[i] / (filter[i] + filter_dt);
+        double d     = alpha * derivative[i] - (1 - alpha) * kd[i] * (y - last_y[i]) * inv_dt;
+
+        double u = ff_gain[i] * ff[i] + kp[i] * e + integral[i] + d;
+
+        // limit how far the output moves from the last tick, then to the output limits. Nothing limits
+        // the rate on the first tick
+        double step = rate[i] * rate_dt > 0 ? rate[i] * rate_dt : unlimited;
+        double out  = std::min(std::max(u, output[i] - step), output[i] + step);
+        out         = std::min(std::max(out, lo_limit[i]), hi_limit[i]);
+
+        // integrate only if the output is not being held back in the direction the error pushes it. The
+        // choice is a weight rather than a branch, since the compiler will not if-convert a branch around
+        // floating point math that could trap
+        double integrating = (u - out) * e > 0 ? 0.0 : 1.0;
+        double next        = integral[i] + integrating * ki[i] * e * dt;
+
+        // a held channel keeps everything from its last good tick. hold is exactly 0 or 1 and every
+        // value is finite, so weighing the two picks one of them exactly
+        double keep   = hold[i];
+        double take   = 1 - keep;
+        error[i]      = keep * error[i] + take * e;
+        integral[i]   = keep * integral[i] + take * next;
+        derivative[i] = keep * derivative[i] + take * d;
+        last_y[i]     = keep * last_y[i] + take * y;
+        output[i]     = keep * output[i] + take * out;
+    }
+}
+
+}  // namespace
+
+ControllerBank::ControllerBank(Stimulator& stimulator_) : m_stimulator(stimulator_), m_last_us(-1) {}
+
+size_t ControllerBank::add_channel(const Channel& channel_, const ControllerGains& gains_) {
+    Source none = {nullptr, 0};
+    std::vector<double>* arrays[] = {&m_kp, &m_ki, &m_kd, &m_filter, &m_ff_gain, &m_rate, &m_min, &m_max,
+                                     &m_reference, &m_feedforward, &m_error, &m_integral, &m_derivative,
+                                     &m_last_measured, &m_measured, &m_hold, &m_output};
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) arrays[a]->push_back(0);
+    m_reference_source.push_back(none);
+    m_feedforward_source.push_back(none);
+    m_channel_nums.push_back(channel_.get_channel_num());
+    m_channel_max.push_back(channel_.get_max_pulse_width());
+    m_pulsewidths.push_back(0);
+    set_gains(size() - 1, gains_);
+    return size() - 1;
+}
+
+bool ControllerBank::set_gains(size_t index_, const ControllerGains& gains_) {
+    if (index_ >= size()) {
+        LOG(Error) << "There is no controller " << index_;
+        return false;
+    }
+    m_kp[index_]      = gains_.kp;
+    m_ki[index_]      = gains_.ki;
+    m_kd[index_]      = gains_.kd;
+    m_filter[index_]  = std::max(gains_.derivative_filter, 0.0);
+    m_ff_gain[index_] = gains_.feedforward_gain;
+    m_rate[index_]    = std::max(gains_.rate_limit, 0.0);
+    // the channel's own limit is the most the output can ever be
+    double channel_max = m_channel_max[index_];
+    m_max[index_]      = gains_.max_output < 0 ? channel_max : std::min(gains_.max_output, channel_max);
+    m_min[index_]      = std::min(std::max(gains_.min_output, 0.0), m_max[index_]);
+    return true;
+}
+
+bool ControllerBank::set_setpoint(size_t index_, double setpoint_) {
+    if (index_ >= size()) {
+        LOG(Error) << "There is no controller " << index_;
+        return false;
+    }
+    m_reference_source[index_].profile = nullptr;
+    m_reference[index_]                = setpoint_;
+    return true;
+}
+
+bool ControllerBank::set_reference(size_t index_, const Profile* profile_, size_t profile_channel_) {
+    if (index_ >= size() || !profile_ || profile_channel_ >= profile_->get_channel_count()) {
+        LOG(Error) << "Cannot read the reference of controller " << index_ << " from channel " << profile_channel_
+                   << " of that profile";
+        return false;
+    }
+    m_reference_source[index_].profile = profile_;
+    m_reference_source[index_].channel = profile_channel_;
+    return true;
+}
+
+bool ControllerBank::set_feedforward(size_t index_, const Profile* profile_, size_t profile_channel_) {
+    if (index_ >= size() || (profile_ && profile_channel_ >= profile_->get_channel_count())) {
+        LOG(Error) << "Cannot read the feedforward of controller " << index_ << " from channel " << profile_channel_
+                   << " of that profile";
+        return false;
+    }
+    m_feedforward_source[index_].profile = profile_;
+    m_feedforward_source[index_].channel = profile_channel_;
+    if (!profile_) m_feedforward[index_] = 0;
+    return true;
+}
+
+void ControllerBank::step(Time time_, const double* measured_) {
+    compute(time_, measured_);
+    apply();
+}
+
+void ControllerBank::compute(Time time_, const double* measured_) {
+    const size_t n = size();
+    if (n == 0) return;
+
+    // the time step is whatever passed since the last tick, so skipped periods are accounted for
+    int64_t now_us = time_.as_microseconds();
+    bool    first  = m_last_us < 0 || now_us <= m_last_us;
+    double  dt     = first ? m_stimulator.get_period().as_seconds() : (now_us - m_last_us) * 1e-6;
+    m_last_us      = now_us;
+
+    // the profiles are read and the measurements screened first, so the pass below only touches the
+    // arrays. A profile that has stopped leaves the last value in place
+    for (size_t i = 0; i < n; i++) {
+        const Source& reference = m_reference_source[i];
+        if (reference.profile) reference.profile->sample(reference.channel, time_, m_reference[i]);
+        const Source& feedforward = m_feedforward_source[i];
+        if (feedforward.profile) feedforward.profile->sample(feedforward.channel, time_, m_feedforward[i]);
+        // a measurement that is not a number would be carried in the integrator, the derivative and the
+        // output from then on, so the channel holds its last output until a good one comes in. The last
+        // measurement stands in for it, so the pass below works on numbers either way
+        bool bad      = !std::isfinite(measured_[i]);
+        m_hold[i]     = bad ? 1.0 : 0.0;
+        m_measured[i] = bad ? m_last_measured[i] : measured_[i];
+        if (bad) {
+            LOG_LIMITED(Warning, log_key(LogTopic::BadMeasurement, m_channel_nums[i]))
+                << "Measurement for channel " << (unsigned int)m_channel_nums[i]
+                << " was not a finite number. Holding the last output.";
+        }
+    }
+
+    const double inv_dt    = first ? 0 : 1 / dt;
+    const double filter_dt = dt > 0 ? dt : 1;
+    const double filtering = dt > 0 ? 1 : 0;
+    const double rate_dt   = first ? 0 : dt;
+    control_pass(n, dt, inv_dt, filter_dt, filtering, rate_dt, &m_kp[0], &m_ki[0], &m_kd[0], &m_filter[0],
+                 &m_ff_gain[0], &m_rate[0], &m_min[0], &m_max[0], &m_reference[0], &m_feedforward[0],
+                 &m_measured[0], &m_hold[0], &m_error[0], &m_integral[0], &m_derivative[0], &m_last_measured[0],
+                 &m_output[0]);
+}
+
+void ControllerBank::apply() {
+    const size_t n = size();
+    // anything below zero (or not a number) goes out as 0, since converting it to unsigned is undefined
+    for (size_t i = 0; i < n; i++) m_pulsewidths[i] = m_output[i] > 0 ? (unsigned int)(m_output[i] + 0.5) : 0;
+    if (n > 0) m_stimulator.write_pws(&m_channel_nums[0], &m_pulsewidths[0], n);
+}
+
+void ControllerBank::reset() {
+    m_last_us = -1;
+    std::fill(m_integral.begin(), m_integral.end(), 0.0);
+    std::fill(m_derivative.begin(), m_derivative.end(), 0.0);
+    std::fill(m_error.begin(), m_error.end(), 0.0);
+    std::fill(m_output.begin(), m_output.end(), 0.0);
+}
+
+size_t ControllerBank::size() const { return m_channel_nums.size(); }
+
+const double* ControllerBank::get_outputs() const { return m_output.empty() ? nullptr : &m_output[0]; }
+
+const double* ControllerBank::get_errors() const { return m_error.empty() ? nullptr : &m_error[0]; }
+
+const double* ControllerBank::get_references() const { return m_reference.empty() ? nullptr : &m_reference[0]; }
+
+}  // namespace fes
+}  // namespace mahi
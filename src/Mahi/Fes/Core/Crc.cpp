@@ -0,0 +1,189 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/Crc.hpp>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MAHI_FES_CRC_CLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MAHI_FES_TARGET_CLMUL
+#else
+#define MAHI_FES_TARGET_CLMUL __attribute__((target("pclmul,sse2")))
+#endif
+#endif
+
+namespace mahi {
+namespace fes {
+
+namespace {
+
+// below this many bytes the setup for folding costs more than it saves
+const size_t CLMUL_MIN_SIZE = 64;
+
+/// Slice-by-8 lookup tables. table[0] is the usual byte-at-a-time table, and table[k][b] is the crc
+/// of byte b followed by k zero bytes
+struct Crc16Tables {
+    unsigned short table[8][256];
+
+    Crc16Tables() {
+        for (unsigned int b = 0; b < 256; b++) {
+            unsigned int crc = b;
+            for (int i = 0; i < 8; i++) {
+                crc = (crc & 0x0001) ? (crc >> 1) ^ CRC_POLY : crc >> 1;
+            }
+            table[0][b] = (unsigned short)crc;
+        }
+        for (unsigned int b = 0; b < 256; b++) {
+            for (int k = 1; k < 8; k++) {
+                unsigned short prev = table[k - 1][b];
+                table[k][b]         = (unsigned short)((prev >> 8) ^ table[0][prev & 0xFF]);
+            }
+        }
+    }
+};
+
+const Crc16Tables& get_tables() {
+    static const Crc16Tables tables;
+    return tables;
+}
+
+#ifdef MAHI_FES_CRC_CLMUL
+
+/// returns x^n mod P for the (non-reflected) UECU polynomial P = x^16 + x^15 + x^2 + 1
+unsigned int xpow_mod(unsigned int n) {
+    unsigned int r = 1;
+    for (unsigned int i = 0; i < n; i++) {
+        r <<= 1;
+        if (r & 0x10000) r ^= 0x18005;
+    }
+    return r;
+}
+
+/// Encodes a polynomial of degree < 64 the way a reflected 64-bit lane holds it (bit i is the
+/// coefficient of x^(63 - i))
+unsigned long long reflect_lane(unsigned int poly) {
+    unsigned long long lane = 0;
+    for (int d = 0; d < 32; d++) {
+        if (poly & (1u << d)) lane |= 1ull << (63 - d);
+    }
+    return lane;
+}
+
+bool detect_clmul() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") != 0;
+#endif
+}
+
+/// Folds 16-byte blocks of the (reflected) message. With a block V split into a high-degree half H
+/// and a low-degree half L, V * x^128 = H * x^192 + L * x^128, and each half is multiplied by
+/// that power of x reduced mod P. A carry-less multiply of two reflected lanes comes out one degree
+/// short, so the constants are x^191 and x^127 instead. The 128 bit remainder is finished with
+/// the tables
+MAHI_FES_TARGET_CLMUL
+unsigned short crc16_fold(const unsigned char* bytes, size_t size, unsigned short crc) {
+    static const unsigned long long k_hi = reflect_lane(xpow_mod(191));
+    static const unsigned long long k_lo = reflect_lane(xpow_mod(127));
+
+    const __m128i constants = _mm_set_epi64x((long long)k_lo, (long long)k_hi);
+
+    // a reflected crc seed is the same as xor-ing it into the first two bytes and starting from zero
+    __m128i value = _mm_loadu_si128((const __m128i*)bytes);
+    value         = _mm_xor_si128(value, _mm_cvtsi32_si128(crc));
+    size_t pos    = 16;
+    while (pos + 16 <= size) {
+        __m128i hi = _mm_clmulepi64_si128(value, constants, 0x00);
+        __m128i lo = _mm_clmulepi64_si128(value, constants, 0x11);
+        value      = _mm_xor_si128(_mm_xor_si128(hi, lo), _mm_loadu_si128((const __m128i*)(bytes + pos)));
+        pos += 16;
+    }
+
+    unsigned char remainder[16];
+    _mm_storeu_si128((__m128i*)remainder, value);
+    unsigned short result = crc16_slice8(remainder, 16, 0x0000);
+    return crc16_slice8(bytes + pos, size - pos, result);
+}
+
+#endif
+
+}  // namespace
+
+unsigned short calc_crc16(const unsigned char* bytes, size_t size, unsigned short crc) {
+    return size >= CLMUL_MIN_SIZE ? crc16_clmul(bytes, size, crc) : crc16_slice8(bytes, size, crc);
+}
+
+unsigned short crc16_bitwise(const unsigned char* bytes, size_t size, unsigned short crc_) {
+    unsigned int crc = crc_;
+    for (size_t pos = 0; pos < size; pos++) {
+        crc = crc ^ bytes[pos];
+        for (int i = 8; i > 0; i--) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ CRC_POLY;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return (unsigned short)crc;
+}
+
+unsigned short crc16_slice8(const unsigned char* bytes, size_t size, unsigned short crc_) {
+    const Crc16Tables& t   = get_tables();
+    unsigned int       crc = crc_;
+    while (size >= 8) {
+        // the crc only overlaps the first two bytes; the rest are looked up as if followed by zeros
+        unsigned int b0 = (bytes[0] ^ crc) & 0xFF;
+        unsigned int b1 = (bytes[1] ^ (crc >> 8)) & 0xFF;
+        crc = t.table[7][b0] ^ t.table[6][b1] ^ t.table[5][bytes[2]] ^ t.table[4][bytes[3]] ^
+              t.table[3][bytes[4]] ^ t.table[2][bytes[5]] ^ t.table[1][bytes[6]] ^ t.table[0][bytes[7]];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc = (crc >> 8) ^ t.table[0][(crc ^ *bytes) & 0xFF];
+        bytes++;
+        size--;
+    }
+    return (unsigned short)crc;
+}
+
+unsigned short crc16_clmul(const unsigned char* bytes, size_t size, unsigned short crc) {
+#ifdef MAHI_FES_CRC_CLMUL
+    if (size >= 16 && crc16_clmul_supported()) return crc16_fold(bytes, size, crc);
+#endif
+    return crc16_slice8(bytes, size, crc);
+}
+
+bool crc16_clmul_supported() {
+#ifdef MAHI_FES_CRC_CLMUL
+    static const bool supported = detect_clmul();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -17,7 +17,7 @@
 #include <Mahi/Fes/Core/Channel.hpp>
 #include <Mahi/Fes/Core/Event.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
 #include <Mahi/Util.hpp>
@@ -28,118 +28,118 @@ using namespace mahi::util;
 namespace mahi {
 namespace fes {
 
-Event::Event(HANDLE& hComm_, unsigned char schedule_id_, int delay_time_, Channel channel_,
-             unsigned char event_id_, bool is_virtual_, unsigned int pulse_width_, unsigned int amplitude_,
-             unsigned char event_type_, unsigned char priority_, unsigned char zone_) :
-    m_hComm(hComm_),
+Event::Event(Transport* transport_, ChannelStore* store_, unsigned char schedule_id_, int delay_time_,
+             Channel channel_, unsigned char event_id_, bool is_virtual_, unsigned int pulse_width_,
+             unsigned int amplitude_, unsigned char event_type_, unsigned char priority_, unsigned char zone_) :
+    m_transport(transport_),
+    m_store(store_),
     m_schedule_id(schedule_id_),
     m_delay_time(delay_time_),
     m_channel(channel_),
     m_is_virtual(is_virtual_),
-    m_pulse_width(pulse_width_),
-    m_amplitude(amplitude_),
-    m_last_pw(0),
-    m_last_amp(0),
+    m_encoded_pw(0),
+    m_encoded_amp(0),
     m_event_type(event_type_),
     m_priority(priority_),
     m_event_id(event_id_),
-    m_max_amplitude(m_channel.get_max_amplitude()),
-    m_max_pulse_width(m_channel.get_max_pulse_width()),
-    m_zone(zone_) {
-    create_event();
+    m_zone(zone_),
+    m_created(false),
+    m_added_channel(false) {
+    // the values sent with the create message count as already sent
+    unsigned char channel_num = m_channel.get_channel_num();
+    if (m_store->has_channel(channel_num)) {
+        m_store->reset_values(channel_num, amplitude_, pulse_width_);
+    } else {
+        m_added_channel = m_store->add_channel(channel_num, m_channel.get_max_amplitude(),
+                                               m_channel.get_max_pulse_width(), amplitude_, pulse_width_);
+    }
 }
 
 Event::~Event() {}
 
+void Event::encode_create(CreateEventFrame& frame) const {
+    unsigned char* data = frame.data();
+    data[0] = m_schedule_id;                      // Schedule ID
+    data[1] = hi_byte(m_delay_time);              // Delay time (byte 1)
+    data[2] = lo_byte(m_delay_time);              // Delay time (byte 2)
+    data[3] = m_priority;                         // priority (default none)
+    data[4] = STIM_EVENT;                         // Event type
+    data[5] = m_channel.get_board_channel_num();  // Channel number
+    data[6] = (unsigned char)get_pulsewidth();    // Pulse Width
+    data[7] = (unsigned char)get_amplitude();     // Amplitude
+    data[8] = m_zone;                             // Zone
+}
+
+ReplyMatch Event::get_create_reply() const {
+    // the reply echoes the channel number in its fourth data byte
+    return ReplyMatch(CREATE_EVENT_REPLY_MSG, 3, m_channel.get_board_channel_num());
+}
+
+bool Event::handle_create_reply(const CommandResult& result) {
+    m_created = result.success && !result.reply.get_data().empty();
+    if (m_created)
+        set_event_id(result.reply.get_data()[0]);
+    else
+        release_channel();
+    return m_created;
+}
+
 bool Event::create_event() {
-    std::vector<unsigned char> delay_time_chars = int_to_twobytes(m_delay_time);
-
-    std::vector<unsigned char> create_event = {DEST_ADR,             // Destination
-                                               SRC_ADR,              // Source
-                                               CREATE_EVENT_MSG,     // Msg type
-                                               CR_EVT_LEN,           // Message length
-                                               m_schedule_id,          // Schedule ID
-                                               delay_time_chars[0],  // Delay time (byte 1)
-                                               delay_time_chars[1],  // Delay time (byte 2)
-                                               m_priority,             // priority (default none)
-                                               STIM_EVENT,           // Event type
-                                               m_channel.get_board_channel_num(),   // Channel number
-                                               (unsigned char)m_pulse_width,  // Pulse Width
-                                               (unsigned char)m_amplitude,    // Amplitude
-                                               m_zone,                        // Zone
-                                               0x00};                       // Checksum Placeholder
-
-    WriteMessage create_event_message(create_event);
-
-    if (create_event_message.write(m_hComm, "Creating Event")) {
-        sleep(milliseconds(100));
+    CreateEventFrame create_event;
+    encode_create(create_event);
+
+    if (create_event.write(m_transport, "Creating Event")) {
         if (!m_is_virtual){
-            ReadMessage event_created_msg(read_message(m_hComm, true));
-            if (event_created_msg.is_valid()){
-                set_event_id(event_created_msg.get_data()[0]);
-            }
-            else{
-                LOG(Error) << "Event created return message (below) either invalid or an error. Returning false.";
-                print_message(event_created_msg.get_message());
+            // the event exists as soon as the UECU acknowledges it, so wait on the reply instead of a fixed time
+            CommandResult event_created;
+            event_created.success = wait_for_reply(m_transport, CREATE_EVENT_REPLY_MSG, event_created.reply, seconds(1));
+            if (!handle_create_reply(event_created)) {
+                LOG(Error) << "Did not receive a valid event created reply. Returning false.";
                 return false;
             }
         }
+        m_created = true;
         return true;
     } else {
+        release_channel();
         return false;
     }
 }
 
 void Event::set_amplitude(unsigned int amplitude_) {
-    if (amplitude_ > m_max_amplitude) {
-        m_amplitude = m_max_amplitude;
-        LOG(Warning) << "Commanded too high of a amplitude on " << get_channel_name()
-                     << " channel. It was clamped to " << m_max_amplitude << ".";
-    } else if (amplitude_ < 0) {
-        m_amplitude = 0;
-        LOG(Warning) << "Commanded a negative amplitude on " << get_channel_name()
-                     << " channel. It was clamped to 0.";
-    } else {
-        m_amplitude = amplitude_;
+    unsigned int max_amplitude = get_max_amplitude();
+    if (amplitude_ > max_amplitude) {
+        amplitude_ = max_amplitude;
+        // a saturated controller clamps every tick, so this is only logged once in a while
+        LOG_LIMITED(Warning, log_key(LogTopic::AmplitudeClamp, m_channel.get_channel_num()))
+            << "Commanded too high of a amplitude on " << get_channel_name() << " channel. It was clamped to "
+            << max_amplitude << ".";
     }
+    m_store->set_amplitude(m_channel.get_channel_num(), amplitude_);
 }
 
-unsigned int Event::get_amplitude() { return m_amplitude; }
+unsigned int Event::get_amplitude() const { return m_store->get_amplitude(m_channel.get_channel_num()); }
 
 void Event::set_pulsewidth(unsigned int pulsewidth_) {
-    if (pulsewidth_ > m_max_pulse_width) {
-        m_pulse_width = m_max_pulse_width;
-        LOG(Warning) << "Commanded too high of a pulsewidth on " << get_channel_name()
-                     << " channel. It was clamped to " << m_max_pulse_width << ".";
-    } else if (pulsewidth_ < 0) {
-        m_pulse_width = 0;
-        LOG(Warning) << "Commanded a negative pulsewidth on " << get_channel_name()
-                     << " channel. It was clamped to 0.";
-    } else {
-        m_pulse_width = pulsewidth_;
+    unsigned int max_pulse_width = get_max_pulse_width();
+    if (pulsewidth_ > max_pulse_width) {
+        pulsewidth_ = max_pulse_width;
+        LOG_LIMITED(Warning, log_key(LogTopic::PulsewidthClamp, m_channel.get_channel_num()))
+            << "Commanded too high of a pulsewidth on " << get_channel_name() << " channel. It was clamped to "
+            << max_pulse_width << ".";
     }
+    m_store->set_pulsewidth(m_channel.get_channel_num(), pulsewidth_);
 }
 
-unsigned int Event::get_pulsewidth() { return m_pulse_width; }
+unsigned int Event::get_pulsewidth() const { return m_store->get_pulsewidth(m_channel.get_channel_num()); }
 
 bool Event::update() {
-    std::vector<unsigned char> edit_event = {DEST_ADR,                    // Destination
-                                             SRC_ADR,                     // Source
-                                             CHANGE_EVENT_PARAMS_MSG,     // Msg type
-                                             CHANGE_EVENT_PARAMS_LEN,     // Msg len
-                                             m_event_id,                    // Event ID
-                                             (unsigned char)m_pulse_width,  // Pulsewidth to update
-                                             (unsigned char)m_amplitude,    // Amplitude to update
-                                             0x00,   // Placeholder for other parameters
-                                             0x00};  // Checksum placeholder
-                                             
-    if((m_last_pw != m_pulse_width) || (m_last_amp != m_amplitude)){
-        m_last_pw  = m_pulse_width;
-        m_last_amp = m_amplitude;
-
-        WriteMessage edit_event_message(edit_event);
-
-        if (edit_event_message.write(m_hComm, "NONE")) {
+    if (is_dirty()) {
+        unsigned char edit_event[ChangeEventParamsFrame::SIZE];
+        size_t        size = encode_update(edit_event);
+
+        if (m_transport->write(edit_event, size)) {
+            mark_updated();
             return true;
         } else {
             return false;
@@ -148,31 +148,82 @@ bool Event::update() {
     else return true;
 }
 
+unsigned int Event::get_delay() const { return m_delay_time; }
+
+bool Event::change_delay(unsigned int delay_time_) {
+    ChangeEventSchedFrame change_event;
+    unsigned char*        data = change_event.data();
+    data[0] = m_event_id;              // Event ID
+    data[1] = m_schedule_id;           // Schedule ID
+    data[2] = hi_byte(delay_time_);    // Delay time (byte 1)
+    data[3] = lo_byte(delay_time_);    // Delay time (byte 2)
+    data[4] = m_priority;              // priority (default none)
+
+    if (!change_event.write(m_transport)) {
+        LOG(Error) << "Error changing the delay of " << get_channel_name() << ".";
+        return false;
+    }
+    m_delay_time = delay_time_;
+    return true;
+}
+
+bool Event::is_dirty() const { return m_store->is_dirty(m_channel.get_channel_num()); }
+
+size_t Event::encode_update(unsigned char* buffer) {
+    const size_t size = ChangeEventParamsFrame::SIZE;
+    m_encoded_pw  = (unsigned char)get_pulsewidth();
+    m_encoded_amp = (unsigned char)get_amplitude();
+    buffer[0] = DEST_ADR;                       // Destination
+    buffer[1] = SRC_ADR;                        // Source
+    buffer[2] = CHANGE_EVENT_PARAMS_MSG;        // Msg type
+    buffer[3] = CHANGE_EVENT_PARAMS_LEN;        // Msg len
+    buffer[4] = m_event_id;                     // Event ID
+    buffer[5] = m_encoded_pw;                   // Pulsewidth to update
+    buffer[6] = m_encoded_amp;                  // Amplitude to update
+    buffer[7] = 0x00;                           // Placeholder for other parameters
+    buffer[size - 1] = calc_checksum(buffer, size - 1);
+
+    return size;
+}
+
+void Event::mark_updated() { m_store->mark_sent(m_channel.get_channel_num(), m_encoded_amp, m_encoded_pw); }
+
+bool Event::is_created() const { return m_created; }
+
 void Event::set_event_id(unsigned char event_id_){
     m_event_id = event_id_;
 }
 
-bool Event::delete_event() {
-    std::vector<unsigned char> del_evt = {DEST_ADR,          // Destination
-                                          SRC_ADR,           // Source
-                                          DELETE_EVENT_MSG,  // Msg type
-                                          DELETE_EVENT_LEN,  // Msg len
-                                          m_event_id,          // Event ID
-                                          0x00};             // Checksum placeholder
+void Event::release_channel() {
+    if (!m_added_channel) return;
+    m_store->remove_channel(m_channel.get_channel_num());
+    m_added_channel = false;
+}
 
-    WriteMessage del_evt_message(del_evt);
+bool Event::delete_event() {
+    DeleteEventFrame del_evt;
+    del_evt.data()[0] = m_event_id;  // Event ID
 
-    if (del_evt_message.write(m_hComm, "Deleting Event")) {
-        return true;
-    } else {
-        return false;
-    }
+    return del_evt.write(m_transport, "Deleting Event");
 }
 
-Channel Event::get_channel() { return m_channel; }
+const Channel& Event::get_channel() const { return m_channel; }
+
+unsigned char Event::get_channel_num() const { return m_channel.get_channel_num(); }
 
-unsigned char Event::get_channel_num() { return m_channel.get_channel_num(); }
+const std::string& Event::get_channel_name() const { return m_channel.get_channel_name(); }
+unsigned int Event::get_max_amplitude() const { return m_store->get_max_amplitude(m_channel.get_channel_num()); }
 
-std::string Event::get_channel_name() { return m_channel.get_channel_name(); }
+unsigned int Event::get_max_pulse_width() const { return m_store->get_max_pulse_width(m_channel.get_channel_num()); }
+
+ChannelState Event::get_state() const {
+    ChannelState state;
+    state.channel_num     = m_channel.get_channel_num();
+    state.amplitude       = get_amplitude();
+    state.pulsewidth      = get_pulsewidth();
+    state.max_amplitude   = get_max_amplitude();
+    state.max_pulse_width = get_max_pulse_width();
+    return state;
+}
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Core/ReadMessage.hpp>
+#include <cstring>
+
+namespace mahi {
+namespace fes {
+
+const size_t ReadFrame::MAX_SIZE;
+
+bool is_reply_type(unsigned char msg_type) {
+    switch (msg_type) {
+        case ERROR_REPORT_MSG:
+        case EVENT_ERROR_MSG:
+        case CREATE_SCHEDULE_REPLY_MSG:
+        case CREATE_EVENT_REPLY_MSG:
+        case EVENT_COMMAND_REPLY_MSG: return true;
+        default: return false;
+    }
+}
+
+ReadFrame::ReadFrame() : m_size(0) {}
+
+bool ReadFrame::assign(const unsigned char* bytes, size_t size) {
+    if (size > MAX_SIZE) return false;
+    std::memcpy(m_bytes.data(), bytes, size);
+    m_size = size;
+    return true;
+}
+
+const unsigned char* ReadFrame::get_bytes() const { return m_bytes.data(); }
+
+size_t ReadFrame::get_size() const { return m_size; }
+
+unsigned char ReadFrame::get_type() const { return m_size > 6 ? m_bytes[6] : 0x00; }
+
+ByteView ReadFrame::get_data() const {
+    ByteView view = {m_bytes.data() + READ_HEADER_SIZE, 0};
+    if (m_size > READ_HEADER_SIZE + READ_CRC_SIZE) view.size = m_size - READ_HEADER_SIZE - READ_CRC_SIZE;
+    return view;
+}
+
+unsigned short ReadFrame::get_crc() const {
+    if (m_size < READ_CRC_SIZE) return 0;
+    // the crc is sent lower byte first
+    return (unsigned short)(m_bytes[m_size - 2] | (m_bytes[m_size - 1] << 8));
+}
+
+unsigned short ReadFrame::calc_crc() const {
+    if (m_size < READ_CRC_SIZE) return CRC_SEED;
+    return calc_crc16(m_bytes.data(), m_size - READ_CRC_SIZE);
+}
+
+bool ReadFrame::is_valid() const {
+    return m_size >= READ_HEADER_SIZE + READ_CRC_SIZE && calc_crc() == get_crc() && is_reply_type(get_type());
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,185 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+FrameParser::FrameParser() :
+    m_pos(0),
+    m_frame_size(0),
+    m_crc(CRC_SEED),
+    m_state(SeekHeader),
+    m_ready(false),
+    m_rejected(false),
+    m_rescan_pos(0),
+    m_rescan_size(0),
+    m_frame_count(0),
+    m_discarded_count(0),
+    m_crc_error_count(0),
+    m_latency(nullptr) {}
+
+size_t FrameParser::feed(const unsigned char* bytes, size_t size) {
+    m_ready     = false;
+    size_t used = 0;
+    while (true) {
+        // bytes left over from a message with a bad crc come before anything new
+        bool                 rescanning = m_rescan_pos < m_rescan_size;
+        const unsigned char* in         = rescanning ? m_rescan + m_rescan_pos : bytes + used;
+        size_t               available  = rescanning ? m_rescan_size - m_rescan_pos : size - used;
+        if (available == 0) return used;
+        size_t count = consume(in, available);
+        if (rescanning)
+            m_rescan_pos += count;
+        else
+            used += count;
+        if (m_rejected) rescan();
+        if (m_ready) return used;
+    }
+}
+
+bool FrameParser::frame_ready() const { return m_ready; }
+
+const ReadFrame& FrameParser::get_frame() const { return m_frame; }
+
+size_t FrameParser::bytes_needed() const {
+    if (m_rescan_pos < m_rescan_size) return 0;
+    return m_state == SeekHeader ? READ_HEADER_SIZE - m_pos : m_frame_size - m_pos;
+}
+
+bool FrameParser::in_frame() const { return m_state == ReadBody; }
+
+bool FrameParser::poll(Transport* transport, ReadFrame& frame, Time timeout) {
+    unsigned char bytes[ReadFrame::MAX_SIZE];
+    Clock         timeout_clock;
+    while (true) {
+        // work through anything left over from a bad message before reading more
+        if (bytes_needed() == 0) {
+            feed(bytes, 0);
+            if (m_ready) {
+                frame = m_frame;
+                return true;
+            }
+        }
+        Time remaining = timeout - timeout_clock.get_elapsed_time();
+        if (remaining < Time::Zero) remaining = Time::Zero;
+        int64_t start  = m_latency ? LatencyHistogram::now() : 0;
+        int     result = transport->read(bytes, bytes_needed(), remaining);
+        int64_t read   = m_latency ? LatencyHistogram::now() : 0;
+        if (m_latency) m_latency->record(LatencyStage::Read, read - start);
+        if (result <= 0) return false;
+        // reads never go past the end of a message, so every byte read is consumed here
+        feed(bytes, (size_t)result);
+        if (m_latency) m_latency->record(LatencyStage::Parse, LatencyHistogram::now() - read);
+        if (m_ready) {
+            frame = m_frame;
+            return true;
+        }
+    }
+}
+
+void FrameParser::reset() {
+    m_pos         = 0;
+    m_state       = SeekHeader;
+    m_ready       = false;
+    m_rejected    = false;
+    m_rescan_pos  = 0;
+    m_rescan_size = 0;
+}
+
+size_t FrameParser::get_frame_count() const { return m_frame_count; }
+
+size_t FrameParser::get_discarded_count() const { return m_discarded_count; }
+
+size_t FrameParser::get_crc_error_count() const { return m_crc_error_count; }
+
+void FrameParser::set_latency_recorder(LatencyRecorder* latency_) { m_latency = latency_; }
+
+size_t FrameParser::consume(const unsigned char* bytes, size_t size) {
+    size_t used = 0;
+    while (used < size) {
+        if (m_state == SeekHeader) {
+            m_buffer[m_pos++] = bytes[used++];
+            if (m_pos < READ_HEADER_SIZE) continue;
+            if (header_valid()) {
+                m_frame_size = READ_HEADER_SIZE + m_buffer[7] + READ_CRC_SIZE;
+                m_crc        = calc_crc16(m_buffer, READ_HEADER_SIZE);
+                m_state      = ReadBody;
+            } else {
+                // slide the header window forward one byte and keep looking
+                std::memmove(m_buffer, m_buffer + 1, READ_HEADER_SIZE - 1);
+                m_pos--;
+                m_discarded_count++;
+            }
+        } else {
+            size_t count   = std::min(size - used, m_frame_size - m_pos);
+            size_t crc_end = m_frame_size - READ_CRC_SIZE;
+            std::memcpy(m_buffer + m_pos, bytes + used, count);
+            // only the data bytes count towards the crc, not the crc itself
+            if (m_pos < crc_end) {
+                m_crc = calc_crc16(m_buffer + m_pos, std::min(m_pos + count, crc_end) - m_pos, m_crc);
+            }
+            m_pos += count;
+            used += count;
+            if (m_pos == m_frame_size) {
+                unsigned short crc = (unsigned short)(m_buffer[m_frame_size - 2] | (m_buffer[m_frame_size - 1] << 8));
+                if (crc == m_crc) {
+                    m_frame.assign(m_buffer, m_frame_size);
+                    m_ready = true;
+                    m_frame_count++;
+                    m_pos   = 0;
+                    m_state = SeekHeader;
+                } else {
+                    m_crc_error_count++;
+                    m_rejected = true;
+                }
+                return used;
+            }
+        }
+    }
+    return used;
+}
+
+void FrameParser::rescan() {
+    // the header was a false match or the message was damaged, so only its first byte is known to
+    // be bad. The rest go back through the header search, ahead of any rescan bytes still waiting
+    unsigned char rest[ReadFrame::MAX_SIZE];
+    size_t        count = m_frame_size - 1;
+    std::memcpy(rest, m_buffer + 1, count);
+    size_t waiting = m_rescan_size - m_rescan_pos;
+    std::memcpy(rest + count, m_rescan + m_rescan_pos, waiting);
+    std::memcpy(m_rescan, rest, count + waiting);
+    m_rescan_pos  = 0;
+    m_rescan_size = count + waiting;
+    m_discarded_count++;
+    m_rejected = false;
+    m_pos      = 0;
+    m_state    = SeekHeader;
+}
+
+bool FrameParser::header_valid() const {
+    return m_buffer[0] == AMULET_CMD_1 && m_buffer[1] == AMULET_CMD_2 && m_buffer[2] == AMULET_ADR &&
+           m_buffer[4] == SRC_ADR && m_buffer[5] == DEST_ADR && m_buffer[7] <= READ_FRAME_MAX_DATA &&
+           m_buffer[3] == 4 + m_buffer[7];
+}
+
+}  // namespace fes
+}  // namespace mahi
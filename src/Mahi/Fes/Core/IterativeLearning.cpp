@@ -0,0 +1,242 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/IterativeLearning.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+// fills the samples of x that were not recorded: between two recorded samples by a straight line, and
+// before the first or after the last by holding the nearest one
+void fill_unrecorded(float* x, const unsigned char* seen, size_t n) {
+    size_t last = n;  // last recorded sample, or n for none yet
+    for (size_t i = 0; i < n; i++) {
+        if (!seen[i]) continue;
+        if (last == n) {
+            std::fill(x, x + i, x[i]);
+        } else {
+            float step = (x[i] - x[last]) / (float)(i - last);
+            for (size_t j = last + 1; j < i; j++) x[j] = x[last] + step * (float)(j - last);
+        }
+        last = i;
+    }
+    if (last < n) std::fill(x + last + 1, x + n, x[last]);
+}
+}  // namespace
+
+IterativeLearning::IterativeLearning() :
+    m_channel_count(0),
+    m_sample_count(0),
+    m_sample_period_us(0),
+    m_recorded(0),
+    m_trials(0),
+    m_from_applied(false) {}
+
+bool IterativeLearning::initialize(size_t channel_count_, size_t sample_count_, Time sample_period_,
+                                   const float* feedforward_) {
+    if (channel_count_ == 0 || sample_count_ == 0 || sample_period_ <= Time::Zero) {
+        LOG(Error) << "Iterative learning needs at least one channel, one sample and a sample period greater than zero";
+        return false;
+    }
+    size_t size = channel_count_ * sample_count_;
+    if (feedforward_) {
+        m_feedforward.assign(feedforward_, feedforward_ + size);
+    } else {
+        m_feedforward.assign(size, 0.0f);
+    }
+    if (!m_profile.set_samples(channel_count_, sample_count_, sample_period_, &m_feedforward[0])) return false;
+    m_channel_count    = channel_count_;
+    m_sample_count     = sample_count_;
+    m_sample_period_us = sample_period_.as_microseconds();
+    m_gains.assign(channel_count_, LearningGains());
+    m_error.assign(size, 0.0f);
+    m_applied.assign(size, 0.0f);
+    m_seen.assign(sample_count_, 0);
+    m_trials = 0;
+    begin_trial();
+    return true;
+}
+
+bool IterativeLearning::initialize(const Profile& feedforward_) {
+    if (feedforward_.get_channel_count() == 0) {
+        LOG(Error) << "Cannot learn from an empty profile";
+        return false;
+    }
+    return initialize(feedforward_.get_channel_count(), feedforward_.get_sample_count(),
+                      feedforward_.get_sample_period(), feedforward_.get_channel(0));
+}
+
+bool IterativeLearning::load(const std::string& filename_) {
+    Profile saved;
+    return saved.load_binary(filename_) && initialize(saved);
+}
+
+bool IterativeLearning::save(const std::string& filename_) const { return m_profile.save_binary(filename_); }
+
+bool IterativeLearning::save_trial(const std::string& filename_) const {
+    if (m_channel_count == 0) return false;
+    std::vector<float> trial(m_error);
+    trial.insert(trial.end(), m_applied.begin(), m_applied.end());
+    Profile profile;
+    return profile.set_samples(2 * m_channel_count, m_sample_count, microseconds(m_sample_period_us), &trial[0]) &&
+           profile.save_binary(filename_);
+}
+
+bool IterativeLearning::set_gains(size_t channel_, const LearningGains& gains_) {
+    if (channel_ >= m_channel_count || gains_.min_output > gains_.max_output) {
+        LOG(Error) << "Cannot set the learning gains of channel " << channel_;
+        return false;
+    }
+    m_gains[channel_] = gains_;
+    return true;
+}
+
+void IterativeLearning::set_q_filter(double cutoff_, size_t taps_) {
+    double dt = m_sample_period_us * 1e-6;
+    if (cutoff_ <= 0 || dt <= 0 || cutoff_ >= 0.5 / dt) {
+        m_kernel.clear();
+        return;
+    }
+    // a Hamming window's transition band is about 3.3 / taps wide, which is made as wide as the passband
+    double fc   = cutoff_ * dt;
+    size_t taps = taps_ > 0 ? taps_ : (size_t)std::ceil(3.3 / fc);
+    taps        = std::min<size_t>(taps | 1, 1001);
+    std::vector<double> kernel(taps);
+    double              middle = (taps - 1) / 2.0;
+    for (size_t k = 0; k < taps; k++) {
+        double x    = k - middle;
+        double sinc = x == 0 ? 2 * fc : std::sin(2 * PI * fc * x) / (PI * x);
+        double w    = taps > 1 ? 0.54 - 0.46 * std::cos(2 * PI * k / (taps - 1)) : 1;
+        kernel[k]   = sinc * w;
+    }
+    set_q_filter(kernel);
+}
+
+bool IterativeLearning::set_q_filter(const std::vector<double>& kernel_) {
+    double sum = 0;
+    for (size_t k = 0; k < kernel_.size(); k++) sum += kernel_[k];
+    if (kernel_.size() % 2 == 0 || sum == 0) {
+        LOG(Error) << "A Q-filter needs an odd number of taps that do not sum to zero";
+        return false;
+    }
+    m_kernel.resize(kernel_.size());
+    for (size_t k = 0; k < kernel_.size(); k++) m_kernel[k] = (float)(kernel_[k] / sum);
+    return true;
+}
+
+void IterativeLearning::set_learn_from_applied(bool enabled_) { m_from_applied = enabled_; }
+
+void IterativeLearning::begin_trial() {
+    // until a sample is recorded it has no error, and what was applied is taken to be the feedforward.
+    // update fills whatever is still unrecorded from the recorded samples around it
+    std::fill(m_error.begin(), m_error.end(), 0.0f);
+    std::copy(m_feedforward.begin(), m_feedforward.end(), m_applied.begin());
+    std::fill(m_seen.begin(), m_seen.end(), 0);
+    m_recorded = 0;
+}
+
+bool IterativeLearning::record(Time time_, const double* errors_, const double* applied_) {
+    if (m_sample_count == 0 || time_ < Time::Zero) return false;
+    size_t n = (size_t)((time_.as_microseconds() + m_sample_period_us / 2) / m_sample_period_us);
+    if (n >= m_sample_count) return false;
+    for (size_t c = 0; c < m_channel_count; c++) {
+        m_error[c * m_sample_count + n]   = (float)errors_[c];
+        m_applied[c * m_sample_count + n] = (float)applied_[c];
+    }
+    m_recorded += m_seen[n] ? 0 : 1;
+    m_seen[n] = 1;
+    return true;
+}
+
+bool IterativeLearning::update() {
+    if (m_recorded == 0) {
+        LOG(Error) << "No samples were recorded, so there is nothing to learn from";
+        return false;
+    }
+    const size_t n    = m_sample_count;
+    const size_t taps = m_kernel.empty() ? 1 : m_kernel.size();
+    const size_t half = taps / 2;
+    m_work.resize(n + taps - 1);
+
+    // a loop slower than the profile leaves samples unrecorded, which are filled from their neighbours
+    // so they neither learn nothing nor pull the feedforward toward what was never applied
+    if (m_recorded < n) {
+        for (size_t c = 0; c < m_channel_count; c++) {
+            fill_unrecorded(&m_error[c * n], &m_seen[0], n);
+            fill_unrecorded(&m_applied[c * n], &m_seen[0], n);
+        }
+    }
+
+    for (size_t c = 0; c < m_channel_count; c++) {
+        const LearningGains& gains = m_gains[c];
+        const float*         base  = m_from_applied ? &m_applied[c * n] : &m_feedforward[c * n];
+        const float*         error = &m_error[c * n];
+        float*               out   = &m_feedforward[c * n];
+        float*               work  = &m_work[half];
+        const float          gain  = (float)gains.learning_gain;
+
+        // the learning law, with the error taken lead samples ahead (the last ones reuse the final error)
+        size_t lead  = std::min(gains.lead, n - 1);
+        size_t ahead = n - lead;
+        for (size_t i = 0; i < ahead; i++) work[i] = base[i] + gain * error[i + lead];
+        for (size_t i = ahead; i < n; i++) work[i] = base[i] + gain * error[n - 1];
+
+        // the ends are held so the filter does not pull them toward zero
+        for (size_t i = 0; i < half; i++) {
+            m_work[i]   = work[0];
+            work[n + i] = work[n - 1];
+        }
+
+        // centered FIR (zero-phase for a symmetric kernel), one tap at a time over every sample so each pass is a plain multiply-add
+        if (m_kernel.empty()) {
+            std::copy(work, work + n, out);
+        } else {
+            std::fill(out, out + n, 0.0f);
+            for (size_t k = 0; k < taps; k++) {
+                const float  h  = m_kernel[k];
+                const float* in = &m_work[k];
+                for (size_t i = 0; i < n; i++) out[i] += h * in[i];
+            }
+        }
+
+        const float lo = (float)gains.min_output;
+        const float hi = (float)gains.max_output;
+        for (size_t i = 0; i < n; i++) out[i] = std::min(std::max(out[i], lo), hi);
+    }
+
+    m_trials++;
+    return m_profile.set_samples(m_channel_count, n, microseconds(m_sample_period_us), &m_feedforward[0]);
+}
+
+const Profile& IterativeLearning::get_feedforward() const { return m_profile; }
+
+double IterativeLearning::get_rms_error(size_t channel_) const {
+    if (channel_ >= m_channel_count || m_recorded == 0) return 0;
+    const float* error = &m_error[channel_ * m_sample_count];
+    double       sum   = 0;
+    for (size_t i = 0; i < m_sample_count; i++) sum += m_seen[i] ? (double)error[i] * error[i] : 0.0;
+    return std::sqrt(sum / m_recorded);
+}
+
+size_t IterativeLearning::get_trial_count() const { return m_trials; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/LatencyHistogram.hpp>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace mahi {
+namespace fes {
+
+namespace {
+
+/// returns the index of the highest set bit of value, which must not be 0
+unsigned int highest_set_bit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (unsigned int)index;
+#else
+    return 63u - (unsigned int)__builtin_clzll(value);
+#endif
+}
+
+}  // namespace
+
+LatencyHistogram::Snapshot::Snapshot() { clear(); }
+
+uint64_t LatencyHistogram::Snapshot::percentile(double p) const {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)count);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        // the bucket's upper bound is never above the largest value actually recorded
+        if (seen >= rank) return bucket_upper(i) < max_ns ? bucket_upper(i) : max_ns;
+    }
+    return max_ns;
+}
+
+double LatencyHistogram::Snapshot::mean() const { return count == 0 ? 0.0 : (double)total_ns / (double)count; }
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    for (size_t i = 0; i < BUCKETS; i++) counts[i] += other.counts[i];
+    count += other.count;
+    total_ns += other.total_ns;
+    if (other.max_ns > max_ns) max_ns = other.max_ns;
+}
+
+void LatencyHistogram::Snapshot::clear() {
+    counts.fill(0);
+    count    = 0;
+    total_ns = 0;
+    max_ns   = 0;
+}
+
+LatencyHistogram::LatencyHistogram() : m_total_ns(0), m_max_ns(0) {
+    for (size_t i = 0; i < BUCKETS; i++) m_counts[i].store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    uint64_t value = ns < 0 ? 0 : (uint64_t)ns;
+    m_counts[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    m_total_ns.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = m_max_ns.load(std::memory_order_relaxed);
+    while (value > max && !m_max_ns.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::take_snapshot(Snapshot& snapshot, bool reset) {
+    // the count is summed from the buckets so that the percentiles always agree with it
+    snapshot.count = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        snapshot.counts[i] = reset ? m_counts[i].exchange(0, std::memory_order_relaxed)
+                                   : m_counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.total_ns = reset ? m_total_ns.exchange(0, std::memory_order_relaxed) : m_total_ns.load(std::memory_order_relaxed);
+    snapshot.max_ns   = reset ? m_max_ns.exchange(0, std::memory_order_relaxed) : m_max_ns.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (size_t i = 0; i < BUCKETS; i++) m_counts[i].store(0, std::memory_order_relaxed);
+    m_total_ns.store(0, std::memory_order_relaxed);
+    m_max_ns.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+    // below 2 * SUB_BUCKETS every value has a bucket of its own
+    if (ns < 2 * SUB_BUCKETS) return (size_t)ns;
+    unsigned int msb = highest_set_bit(ns);
+    if (msb >= MAX_BITS) return BUCKETS - 1;
+    unsigned int shift = msb - SUB_BITS;
+    return (size_t)shift * SUB_BUCKETS + (size_t)(ns >> shift);
+}
+
+uint64_t LatencyHistogram::bucket_lower(size_t bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    unsigned int shift = (unsigned int)(bucket / SUB_BUCKETS) - 1;
+    return (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    unsigned int shift = (unsigned int)(bucket / SUB_BUCKETS) - 1;
+    return bucket_lower(bucket) + ((uint64_t)1 << shift) - 1;
+}
+
+const char* get_stage_name(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Encode: return "encode";
+        case LatencyStage::Write: return "write";
+        case LatencyStage::Read: return "read";
+        case LatencyStage::Parse: return "parse";
+        case LatencyStage::Validate: return "validate";
+        case LatencyStage::Port: return "port";
+    }
+    return "unknown";
+}
+
+void LatencyRecorder::take_snapshot(Snapshot& snapshot, bool reset) {
+    for (size_t i = 0; i < STAGES; i++) m_stages[i].take_snapshot(snapshot.stages[i], reset);
+}
+
+void LatencyRecorder::reset() {
+    for (size_t i = 0; i < STAGES; i++) m_stages[i].reset();
+}
+
+void LatencyRecorder::write_csv_header(std::ostream& os) {
+    os << "label,stage,count,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+}
+
+void LatencyRecorder::write_csv(std::ostream& os, const std::string& label, const Snapshot& snapshot) {
+    for (size_t i = 0; i < STAGES; i++) {
+        const LatencyHistogram::Snapshot& stage = snapshot.stages[i];
+        os << label << ',' << get_stage_name((LatencyStage)i) << ',' << stage.count << ',' << stage.mean() << ','
+           << stage.percentile(50) << ',' << stage.percentile(90) << ',' << stage.percentile(99) << ','
+           << stage.percentile(99.9) << ',' << stage.max_ns << '\n';
+    }
+}
+
+void LatencyRecorder::write_json(std::ostream& os, const Snapshot& snapshot) {
+    os << '{';
+    for (size_t i = 0; i < STAGES; i++) {
+        const LatencyHistogram::Snapshot& stage = snapshot.stages[i];
+        if (i > 0) os << ',';
+        os << '"' << get_stage_name((LatencyStage)i) << "\":{\"count\":" << stage.count << ",\"mean_ns\":" << stage.mean()
+           << ",\"p50_ns\":" << stage.percentile(50) << ",\"p90_ns\":" << stage.percentile(90)
+           << ",\"p99_ns\":" << stage.percentile(99) << ",\"p999_ns\":" << stage.percentile(99.9)
+           << ",\"max_ns\":" << stage.max_ns << ",\"buckets\":[";
+        bool first = true;
+        for (size_t b = 0; b < LatencyHistogram::BUCKETS; b++) {
+            if (stage.counts[b] == 0) continue;
+            if (!first) os << ',';
+            os << '[' << LatencyHistogram::bucket_lower(b) << ',' << LatencyHistogram::bucket_upper(b) << ','
+               << stage.counts[b] << ']';
+            first = false;
+        }
+        os << "]}";
+    }
+    os << '}';
+}
+
+}  // namespace fes
+}  // namespace mahi
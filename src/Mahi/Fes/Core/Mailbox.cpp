@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/Mailbox.hpp>
+
+namespace mahi {
+namespace fes {
+
+const size_t CommandMailbox::CAPACITY;
+
+CommandMailbox::CommandMailbox() : m_amp_pending(0), m_pw_pending(0), m_delay_pending(0), m_period(0) {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        m_amplitudes[i].store(0, std::memory_order_relaxed);
+        m_pulsewidths[i].store(0, std::memory_order_relaxed);
+        m_delays[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool CommandMailbox::post_amplitude(unsigned char channel_num, unsigned int amplitude) {
+    if (channel_num >= CAPACITY) return false;
+    // the value must be visible before the flag that announces it
+    m_amplitudes[channel_num].store(amplitude, std::memory_order_relaxed);
+    m_amp_pending.fetch_or(uint32_t(1) << channel_num, std::memory_order_release);
+    return true;
+}
+
+bool CommandMailbox::post_pulsewidth(unsigned char channel_num, unsigned int pulsewidth) {
+    if (channel_num >= CAPACITY) return false;
+    m_pulsewidths[channel_num].store(pulsewidth, std::memory_order_relaxed);
+    m_pw_pending.fetch_or(uint32_t(1) << channel_num, std::memory_order_release);
+    return true;
+}
+
+uint32_t CommandMailbox::take_amplitudes() { return m_amp_pending.exchange(0, std::memory_order_acquire); }
+
+uint32_t CommandMailbox::take_pulsewidths() { return m_pw_pending.exchange(0, std::memory_order_acquire); }
+
+unsigned int CommandMailbox::get_amplitude(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? m_amplitudes[channel_num].load(std::memory_order_relaxed) : 0;
+}
+
+unsigned int CommandMailbox::get_pulsewidth(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? m_pulsewidths[channel_num].load(std::memory_order_relaxed) : 0;
+}
+
+bool CommandMailbox::post_delay(unsigned char channel_num, unsigned int delay) {
+    if (channel_num >= CAPACITY) return false;
+    m_delays[channel_num].store(delay, std::memory_order_relaxed);
+    m_delay_pending.fetch_or(uint32_t(1) << channel_num, std::memory_order_release);
+    return true;
+}
+
+uint32_t CommandMailbox::take_delays() { return m_delay_pending.exchange(0, std::memory_order_acquire); }
+
+unsigned int CommandMailbox::get_delay(unsigned char channel_num) const {
+    return channel_num < CAPACITY ? m_delays[channel_num].load(std::memory_order_relaxed) : 0;
+}
+
+void CommandMailbox::post_period(unsigned int period) { m_period.store(period, std::memory_order_release); }
+
+unsigned int CommandMailbox::take_period() { return m_period.exchange(0, std::memory_order_acquire); }
+
+}  // namespace fes
+}  // namespace mahi
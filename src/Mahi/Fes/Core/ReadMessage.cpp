@@ -24,70 +24,44 @@ using namespace mahi::util;
 namespace mahi {
 namespace fes {
 
-ReadMessage::ReadMessage(std::vector<unsigned char> message) {
-    m_message           = message;
-    m_size              = m_message.size();
-    if(m_size > 1){
-        std::vector<unsigned char> crc(m_message.end()-2, m_message.end());
-        m_crc = crc;
-    }
-    else{
-        m_crc = {0x00, 0x00};
-    } 
-    m_read_message_type = m_size > 1 ? m_message[6] : 0x00;
-    std::vector<unsigned char> data_vec;
-    if(m_size > 2) std::copy(m_message.begin() + 8, m_message.begin() + m_size - 2, std::back_inserter(data_vec));
-    m_data = data_vec;
-}
+const std::vector<unsigned char> ReadMessage::valid_msg_types = {ERROR_REPORT_MSG, EVENT_ERROR_MSG,
+                                                               CREATE_SCHEDULE_REPLY_MSG, CREATE_EVENT_REPLY_MSG,
+                                                               EVENT_COMMAND_REPLY_MSG};
 
 ReadMessage::ReadMessage(std::vector<unsigned char> message, size_t msg_count) {
-    m_message           = message;
+    // the crc and data are read out of m_message on demand rather than copied
+    m_message           = std::move(message);
     m_size              = m_message.size();
-    if(m_size > 1){
-        std::vector<unsigned char> crc(m_message.end()-2, m_message.end());
-        m_crc = crc;
-    }
-    else{
-        m_crc = {0x00, 0x00};
-    } 
-    m_read_message_type = m_size > 1 ? m_message[6] : 0x00;
+    m_read_message_type = m_size > 6 ? m_message[6] : 0x00;
     m_msg_count         = msg_count;
-    std::vector<unsigned char> data_vec;
-    if(m_size > 2) std::copy(m_message.begin() + 8, m_message.begin() + m_size - 2, std::back_inserter(data_vec));
-    m_data = data_vec;
 }
 
+ReadMessage::ReadMessage(const ReadFrame& frame, size_t msg_count) :
+    ReadMessage(std::vector<unsigned char>(frame.get_bytes(), frame.get_bytes() + frame.get_size()), msg_count) {}
+
 std::vector<unsigned char> ReadMessage::calc_crc(){
-    auto cnt = m_message.size()-2;
-    int crc = CRC_SEED; // initialize CRC
-    int i, pos;
-    pos = 0;
-    while (cnt-- > 0){
-        crc = crc ^ m_message[pos++];
-        for (i=8; i>0; i--){
-            if (crc & 0x0001){
-                crc = (crc >> 1) ^ CRC_POLY;
-            }
-            else{
-                crc >>= 1;
-            }
-        }
-    }
-    std::vector<unsigned char> crc_bytes = int_to_twobytes(crc);
-    return {crc_bytes[1], crc_bytes[0]};
+    unsigned short crc = m_size >= READ_CRC_SIZE ? calc_crc16(get_message_pointer(), m_size - READ_CRC_SIZE) : CRC_SEED;
+    return {lo_byte(crc), hi_byte(crc)};
+}
+
+unsigned short ReadMessage::get_crc() {
+    if (m_size < READ_CRC_SIZE) return 0;
+    return (unsigned short)(m_message[m_size - 2] | (m_message[m_size - 1] << 8));
 }
 
 unsigned char ReadMessage::get_read_message_type() { return m_read_message_type; }
 
 bool ReadMessage::is_valid() {
-    if (calc_crc() != m_crc) {
-        print_message(calc_crc());
-        print_message(m_crc);
+    unsigned short crc = m_size >= READ_CRC_SIZE ? calc_crc16(get_message_pointer(), m_size - READ_CRC_SIZE) : CRC_SEED;
+    if (m_size < READ_CRC_SIZE || crc != get_crc()) {
+        // report the crc we already have rather than calculating it again
+        LOG(Error) << "Calculated crc: " << print_as_hex(lo_byte(crc)) << ", " << print_as_hex(hi_byte(crc));
+        print_message(m_message);
         LOG(Error) << "Read checksum is wrong; message is likely invalid.";
         return false;
     } else if (!binary_search(valid_msg_types.begin(), valid_msg_types.end(),
                               m_read_message_type)) {
-        LOG(Error) << "Message type " << m_read_message_type
+        LOG(Error) << "Message type " << print_as_hex(m_read_message_type)
                    << " is unknown. Cannot interpret message.";
         return false;
     }
@@ -95,7 +69,14 @@ bool ReadMessage::is_valid() {
 }
 
 std::vector<unsigned char> ReadMessage::get_data(){
-    return m_data;
+    ByteView data = get_data_view();
+    return std::vector<unsigned char>(data.begin(), data.end());
+}
+
+ByteView ReadMessage::get_data_view() {
+    ByteView view = {m_size > 0 ? get_message_pointer() + READ_HEADER_SIZE : nullptr, 0};
+    if (m_size > READ_HEADER_SIZE + READ_CRC_SIZE) view.size = m_size - READ_HEADER_SIZE - READ_CRC_SIZE;
+    return view;
 }
 
 }  // namespace fes
@@ -15,42 +15,31 @@
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
 #include <Mahi/Fes/Core/Scheduler.hpp>
-#include <Mahi/Fes/Core/WriteMessage.hpp>
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
 #include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 using namespace mahi::util;
 
 namespace mahi {
 namespace fes {
 
-Scheduler::Scheduler() : m_id(0x01) {}
+const unsigned int Scheduler::EVENT_SPACING;
+const unsigned int Scheduler::MAX_PERIOD;
+
+Scheduler::Scheduler() : m_id(0x01), m_store(&m_own_store), m_enabled(false), m_transport(nullptr), m_byte_budget(SIZE_MAX) {}
 
 Scheduler::~Scheduler() { disable(); }
 
-bool Scheduler::create_scheduler(HANDLE& hComm_, const unsigned char sync_char_, unsigned int duration,
+bool Scheduler::create_scheduler(Transport* transport_, const unsigned char sync_char_, unsigned int duration,
                                  Time setup_time) {
-    m_sync_char = sync_char_;
-
-    m_hComm = hComm_;
-
-    DWORD dwBytesWritten = 0;  // Captures how many bits were written
-
-    // convert the input duration (int) into two bytes that we can send over a message
-    std::vector<unsigned char> duration_chars = int_to_twobytes(duration);
+    CreateScheduleFrame crt_sched;
+    encode_create(crt_sched, transport_, sync_char_, duration);
 
-    std::vector<unsigned char> crt_sched = {DEST_ADR,             // Destination
-                                            SRC_ADR,              // Source
-                                            CREATE_SCHEDULE_MSG,  // Msg type
-                                            CREATE_SCHED_LEN,     // Message length
-                                            m_sync_char,          // sync character
-                                            duration_chars[0],    // schedule duration (byte 1)
-                                            duration_chars[1],    // schedule duration (byte 2)
-                                            0x00};                // checksum placeholder
-
-    WriteMessage crt_sched_message(crt_sched);
-
-    if (crt_sched_message.write(m_hComm, "Creating Scheduler")) {
+    if (crt_sched.write(m_transport, "Creating Scheduler")) {
         m_enabled = true;
         sleep(setup_time);
         return true;
@@ -59,18 +48,51 @@ bool Scheduler::create_scheduler(HANDLE& hComm_, const unsigned char sync_char_,
     }
 }
 
+std::future<CommandResult> Scheduler::create_scheduler(CommandQueue& commands, Transport* transport_,
+                                                       const unsigned char sync_char_, unsigned int duration) {
+    CreateScheduleFrame crt_sched;
+    encode_create(crt_sched, transport_, sync_char_, duration);
+
+    // a resent create could make a second schedule if only the reply was lost, so it is sent once.
+    // Events carry the schedule id, so the scheduler only takes them once the reply has brought it
+    return commands.submit_once(crt_sched, ReplyMatch(CREATE_SCHEDULE_REPLY_MSG), [this](const CommandResult& result) {
+        if (result.success && !result.reply.get_data().empty()) {
+            set_id(result.reply.get_data()[0]);
+            m_enabled = true;
+        }
+    });
+}
+
+void Scheduler::encode_create(CreateScheduleFrame& frame, Transport* transport_, const unsigned char sync_char_,
+                              unsigned int duration) {
+    m_sync_char = sync_char_;
+
+    m_transport = transport_;
+
+    frame.data()[0] = m_sync_char;         // sync character
+    frame.data()[1] = hi_byte(duration);   // schedule duration (byte 1)
+    frame.data()[2] = lo_byte(duration);   // schedule duration (byte 2)
+
+    m_duration = duration;
+    size_byte_budget(duration);
+}
+
+void Scheduler::size_byte_budget(unsigned int duration) {
+    // the number of bytes that can go out over the wire in one schedule period (8N1 serial sends 10 bits per
+    // byte). Keeping each update within this means it is on the wire before the next update is due
+    m_byte_budget = (size_t)(m_transport->get_baud_rate() / 10 * duration / 1000);
+    if (m_byte_budget < ChangeEventParamsFrame::SIZE) {
+        LOG(Warning) << "Schedule period of " << duration << " ms only fits " << m_byte_budget
+                     << " bytes per update. Only one event will be updated per period.";
+    }
+}
+
 bool Scheduler::halt_scheduler() {
     if (is_enabled()) {
-        std::vector<unsigned char> halt = {DEST_ADR,  // Destination
-                                           SRC_ADR,   // Source
-                                           HALT_MSG,  // Msg type
-                                           HALT_LEN,  // Msg len
-                                           m_id,      // Schedule ID
-                                           0x00};     // Checksum placeholder
+        HaltFrame halt;
+        halt.data()[0] = m_id;  // Schedule ID
 
-        WriteMessage halt_message(halt);
-
-        return halt_message.write(m_hComm, "Schedule Closing");
+        return halt.write(m_transport, "Schedule Closing");
     } else {
         LOG(Error) << "Scheduler was not enabled. Nothing to disable";
         return false;
@@ -78,43 +100,122 @@ bool Scheduler::halt_scheduler() {
 }
 
 bool Scheduler::add_event(Channel channel_, Time sleep_time, bool is_virtual_, unsigned char event_type) {
-    unsigned int num_events = (unsigned int)m_events.size();
+    return add_event(channel_, EVENT_SPACING * (unsigned int)m_events.size(), sleep_time, is_virtual_, event_type);
+}
 
-    if (m_enabled) {
-        for (unsigned int i = 0; i < num_events; i++) {
-            if (m_events[i].get_channel_num() == channel_.get_channel_num()) {
-                LOG(Error) << "Did not add event because an event already existed with that channel.";
+bool Scheduler::add_event(Channel channel_, unsigned int delay, Time sleep_time, bool is_virtual_,
+                          unsigned char event_type) {
+    if (!can_add_event(channel_)) return false;
+
+    Event event = make_event(channel_, 0, delay, is_virtual_);
+    if (!event.create_event()) {
+        LOG(Error) << "Did not add event because the UECU did not create it.";
+        return false;
+    }
+    insert_event(event);
+
+    // a real UECU acknowledges the event before it is created, but a virtual one needs time to catch up
+    if (is_virtual_) sleep(sleep_time);
+
+    return true;
+}
+
+bool Scheduler::add_events(CommandQueue& commands, const std::vector<Channel>& channels_, unsigned char event_type) {
+    std::vector<unsigned int> delays;
+    for (size_t i = 0; i < channels_.size(); i++) {
+        delays.push_back(EVENT_SPACING * (unsigned int)(m_events.size() + i));
+    }
+    return add_events(commands, channels_, delays, event_type);
+}
+
+bool Scheduler::add_events(CommandQueue& commands, const std::vector<Channel>& channels_,
+                           const std::vector<unsigned int>& delays, unsigned char event_type) {
+    if (delays.size() != channels_.size()) {
+        LOG(Error) << "Did not add events because " << channels_.size() << " channels were given " << delays.size()
+                   << " delays.";
+        return false;
+    }
+    // every channel is checked before any event touches the channel store
+    for (size_t i = 0; i < channels_.size(); i++) {
+        if (!can_add_event(channels_[i])) return false;
+        for (size_t j = 0; j < i; j++) {
+            if (channels_[j].get_channel_num() == channels_[i].get_channel_num()) {
+                LOG(Error) << "Did not add events because channel " << channels_[i].get_channel_name()
+                           << " was given twice.";
                 return false;
             }
         }
+    }
+    // every create message goes out in one burst, and each event is kept once its reply comes back
+    std::vector<Event>                      events;
+    std::vector<std::future<CommandResult>> replies;
+    for (size_t i = 0; i < channels_.size(); i++) {
+        events.push_back(make_event(channels_[i], events.size(), delays[i], false));
+
+        CreateEventFrame create_event;
+        events.back().encode_create(create_event);
+        replies.push_back(commands.submit_once(create_event, events.back().get_create_reply()));
+    }
+    commands.wait_all();
 
-        // add 5 us delay so that they don't all occur at the exact same time
-        auto delay_time = 5 * num_events;  // ms
-
-        // add event to list of events
-        m_events.push_back(Event(m_hComm, m_id, delay_time, channel_, (unsigned char)(num_events + 1),is_virtual_));
-
-        sleep(sleep_time);
+    bool success = true;
+    for (size_t i = 0; i < events.size(); i++) {
+        if (events[i].handle_create_reply(replies[i].get())) {
+            insert_event(events[i]);
+        } else {
+            LOG(Error) << "Did not add event on channel " << events[i].get_channel_name()
+                       << " because the UECU did not create it.";
+            success = false;
+        }
+    }
+    return success;
+}
 
-        return true;
-    } else {
+bool Scheduler::can_add_event(const Channel& channel_) const {
+    if (!m_enabled) {
         LOG(Error) << "Scheduler is not yet enabled. ";
         return false;
     }
+    if (get_event(channel_.get_channel_num())) {
+        LOG(Error) << "Did not add event because an event already existed with that channel.";
+        return false;
+    }
+    if (channel_.get_channel_num() >= ChannelStore::CAPACITY) {
+        LOG(Error) << "Did not add event because channel " << channel_.get_channel_name()
+                   << " has a channel number outside of the channel store.";
+        return false;
+    }
+    return true;
+}
+
+Event Scheduler::make_event(const Channel& channel_, size_t num_pending, unsigned int delay, bool is_virtual_) {
+    unsigned int num_events = (unsigned int)(m_events.size() + num_pending);
+    return Event(m_transport, m_store, m_id, delay, channel_, (unsigned char)(num_events + 1), is_virtual_);
+}
+
+void Scheduler::insert_event(const Event& event) {
+    unsigned char channel_num = event.get_channel_num();
+
+    // add event to list of events
+    m_events.push_back(event);
+
+    // index the event by channel number so lookups do not have to search the events
+    if (m_event_index.size() <= channel_num) {
+        m_event_index.resize(channel_num + 1, -1);
+    }
+    m_event_index[channel_num] = (int)(m_events.size() - 1);
+    m_channel_mask |= uint32_t(1) << channel_num;
+
+    // make room for every event to be updated at once so update never has to allocate
+    m_update_buffer.resize(m_events.size() * ChangeEventParamsFrame::SIZE);
 }
 
 bool Scheduler::send_sync_msg() {
     if (m_enabled) {
-        std::vector<unsigned char> sync = {DEST_ADR,      // Destination
-                                           SRC_ADR,       // Source
-                                           SYNC_MSG,      // Msg type
-                                           SYNC_MSG_LEN,  // Message length
-                                           m_sync_char,   // sync character
-                                           0x00};         // Checksum placeholder
-
-        WriteMessage sync_message(sync);
+        SyncFrame sync;
+        encode_sync(sync);
 
-        if (sync_message.write(m_hComm, "Sending Sync Message")) {
+        if (sync.write(m_transport, "Sending Sync Message")) {
             return true;
         } else {
             disable();
@@ -126,7 +227,17 @@ bool Scheduler::send_sync_msg() {
     }
 }
 
+void Scheduler::encode_sync(SyncFrame& frame) const {
+    frame.data()[0] = m_sync_char;  // sync character
+    frame.finalize();
+}
+
+Transport* Scheduler::get_transport() const { return m_transport; }
+
 void Scheduler::disable() {
+    // the destructor disables again after the stimulator has closed the transport
+    if (!m_enabled) return;
+
     halt_scheduler();
 
     m_enabled = false;
@@ -135,94 +246,252 @@ void Scheduler::disable() {
         event->delete_event();
     }
 
-    std::vector<unsigned char> del_sched = {DEST_ADR,             // Destination
-                                            SRC_ADR,              // Source
-                                            DELETE_SCHEDULE_MSG,  // Msg type
-                                            DEL_SCHED_LEN,        // Message length
-                                            m_id,                 // Schedule ID
-                                            0x00};                // Checksum placeholder
-
-    WriteMessage del_sched_message(del_sched);
+    DeleteScheduleFrame del_sched;
+    del_sched.data()[0] = m_id;  // Schedule ID
 
-    del_sched_message.write(m_hComm, "Closing Schedule");
+    del_sched.write(m_transport, "Closing Schedule");
 }
 
-void Scheduler::set_amp(Channel channel_, unsigned int amplitude_) {
-    // loop over available events in the scheduler
-    for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // if the event is for the correct channel we are looking for, write the amplitude and exit
-        // the function
-        if (event->get_channel_num() == channel_.get_channel_num()) {
-            event->set_amplitude(amplitude_);
-            return;
-        }
+bool Scheduler::set_amp(const Channel& channel_, unsigned int amplitude_) {
+    Event* event = get_event(channel_.get_channel_num());
+    if (event) {
+        event->set_amplitude(amplitude_);
+        return true;
+    } else {
+        LOG_LIMITED(Error, log_key(LogTopic::MissingEvent, channel_.get_channel_num()))
+            << "Did not find the correct event to update on channel " << channel_.get_channel_name() << ". Nothing has changed.";
+        return false;
     }
-    // if we didnt find the event, something is messed up, so return false
-    LOG(Error) << "Did not find the correct event to update on channel " << channel_.get_channel_name() <<  ". Nothing has changed.";
 }
 
-unsigned int Scheduler::get_amp(Channel channel_) {
-    // loop over available events in the scheduler
-    for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // if the event is for the correct channel we are looking for, wrevente the ampleventude and
-        // exevent the function
-        if (event->get_channel_num() == channel_.get_channel_num()) {
-            return event->get_amplitude();
-        }
-    }
+unsigned int Scheduler::get_amp(const Channel& channel_) const {
+    const Event* event = get_event(channel_.get_channel_num());
+    if (event) return event->get_amplitude();
     // if we didnt find the event, something is messed up, so return 0
-    LOG(Error) << "Did not find the correct event to pull from on channel " << channel_.get_channel_name() << ". Returning 0.";
+    LOG_LIMITED(Error, log_key(LogTopic::MissingEvent, channel_.get_channel_num()))
+        << "Did not find the correct event to pull from on channel " << channel_.get_channel_name() << ". Returning 0.";
     return 0;
 }
 
-void Scheduler::write_pw(Channel channel_, unsigned int pw_) {
-    // loop over available events in the scheduler
-    for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // if the event is for the correct channel we are looking for, wrevente the ampleventude and
-        // exevent the function
-        if (event->get_channel_num() == channel_.get_channel_num()) {
-            event->set_pulsewidth(pw_);
-            return;
-        }
+bool Scheduler::write_pw(const Channel& channel_, unsigned int pw_) {
+    Event* event = get_event(channel_.get_channel_num());
+    if (event) {
+        event->set_pulsewidth(pw_);
+        return true;
+    } else {
+        LOG_LIMITED(Error, log_key(LogTopic::MissingEvent, channel_.get_channel_num()))
+            << "Did not find the correct event to update on channel " << channel_.get_channel_name() << ". Nothing has changed.";
+        return false;
     }
-    // if we didnt find the event, something is messed up, so return false
-    LOG(Error) << "Did not find the correct event to update on channel " << channel_.get_channel_name() <<  ". Nothing has changed.";
 }
 
-unsigned int Scheduler::get_pw(Channel channel_) {
-    // loop over available events in the scheduler
-    for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // if the event is for the correct channel we are looking for, wrevente the ampleventude and
-        // exevent the function
-        if (event->get_channel_num() == channel_.get_channel_num()) {
-            return event->get_pulsewidth();
-        }
-    }
+unsigned int Scheduler::get_pw(const Channel& channel_) const {
+    const Event* event = get_event(channel_.get_channel_num());
+    if (event) return event->get_pulsewidth();
     // if we didnt find the event, something is messed up, so return 0
-    LOG(Error) << "Did not find the correct event to pull from on channel " << channel_.get_channel_name() << ". Returning 0.";
+    LOG_LIMITED(Error, log_key(LogTopic::MissingEvent, channel_.get_channel_num()))
+        << "Did not find the correct event to pull from on channel " << channel_.get_channel_name() << ". Returning 0.";
     return 0;
 }
 
 bool Scheduler::update() {
-    // loop over available events in the scheduler
-    for (auto event = m_events.begin(); event != m_events.end(); event++) {
-        // If any channel fails to update, return false after throwing an error
-        if (!event->update()) {
-            LOG(Error) << "Channel " << event->get_channel_name() << " failed to update";
-            return false;
+    // one compare over every channel in the store finds the events that changed
+    uint32_t dirty = m_store->get_dirty_mask() & m_channel_mask;
+    if (dirty == 0) return true;
+
+    // channels at or after m_next_update get first claim on the budget, since they were left out last time
+    uint32_t first     = dirty & ~((uint32_t(1) << m_next_update) - 1);
+    uint32_t passes[2] = {first, dirty & ~first};
+    uint32_t sent      = 0;
+    size_t   size      = 0;
+    int64_t  start     = m_latency ? LatencyHistogram::now() : 0;
+    for (int p = 0; p < 2; p++) {
+        for (uint32_t bits = passes[p]; bits != 0; bits &= bits - 1) {
+            unsigned int channel_num = lowest_set_bit(bits);
+            // stop once the next frame would overrun the budget, but always send at least one
+            if (size + ChangeEventParamsFrame::SIZE > m_byte_budget && size != 0) {
+                m_next_update = channel_num;
+                p             = 2;
+                break;
+            }
+            size += m_events[m_event_index[channel_num]].encode_update(&m_update_buffer[size]);
+            sent |= uint32_t(1) << channel_num;
         }
     }
+
+    // once every changed channel fits, nobody is owed first claim, so the next pass starts from the bottom again
+    if (sent == dirty) m_next_update = 0;
+
+    int64_t encoded = m_latency ? LatencyHistogram::now() : 0;
+
+    // If the frames fail to write, return false after throwing an error
+    bool written = m_transport->write(&m_update_buffer[0], size);
+    if (m_latency) {
+        m_latency->record(LatencyStage::Encode, encoded - start);
+        m_latency->record(LatencyStage::Write, LatencyHistogram::now() - encoded);
+    }
+    if (!written) {
+        LOG(Error) << "Failed to write updates for " << size / ChangeEventParamsFrame::SIZE << " channels";
+        return false;
+    }
+    for (uint32_t bits = sent; bits != 0; bits &= bits - 1) {
+        m_events[m_event_index[lowest_set_bit(bits)]].mark_updated();
+    }
     return true;
 }
 
+void Scheduler::set_byte_budget(size_t byte_budget_) { m_byte_budget = byte_budget_; }
+
+size_t Scheduler::get_byte_budget() { return m_byte_budget; }
+
+void Scheduler::set_latency_recorder(LatencyRecorder* latency_) { m_latency = latency_; }
+
+void Scheduler::set_store(ChannelStore* store_) {
+    if (!m_events.empty()) {
+        LOG(Error) << "Cannot change the channel store once events have been added.";
+        return;
+    }
+    m_store = store_;
+}
+
+const ChannelStore& Scheduler::get_store() const { return *m_store; }
+
 size_t Scheduler::get_num_events() { return m_events.size(); }
 
-std::vector<Event> Scheduler::get_events() { return m_events; }
+const std::vector<Event>& Scheduler::get_events() const { return m_events; }
+
+Event* Scheduler::get_event(unsigned char channel_num) {
+    if (channel_num >= m_event_index.size() || m_event_index[channel_num] < 0) return nullptr;
+    return &m_events[m_event_index[channel_num]];
+}
+
+const Event* Scheduler::get_event(unsigned char channel_num) const {
+    if (channel_num >= m_event_index.size() || m_event_index[channel_num] < 0) return nullptr;
+    return &m_events[m_event_index[channel_num]];
+}
+
+void Scheduler::get_states(std::vector<ChannelState>& states) const {
+    for (auto event = m_events.begin(); event != m_events.end(); event++) {
+        states.push_back(event->get_state());
+    }
+}
 
 unsigned char Scheduler::get_id() { return m_id; }
 
 void Scheduler::set_id(unsigned char sched_id_) { m_id = sched_id_; }
 
 bool Scheduler::is_enabled() { return m_enabled; }
+
+unsigned int Scheduler::get_period() const { return m_duration; }
+
+bool Scheduler::check_spacing(const Event* moved, unsigned int moved_delay, const unsigned int* planned,
+                              unsigned int duration) const {
+    // at most one event per channel, so the delays fit on the stack
+    std::array<unsigned int, ChannelStore::CAPACITY> delays;
+    size_t                                           count = 0;
+    for (auto event = m_events.begin(); event != m_events.end() && count < delays.size(); event++) {
+        if (&(*event) == moved)
+            delays[count++] = moved_delay;
+        else
+            delays[count++] = planned ? planned[event->get_channel_num()] : event->get_delay();
+    }
+    std::sort(delays.begin(), delays.begin() + count);
+
+    for (size_t i = 0; i < count; i++) {
+        if (delays[i] >= duration) {
+            LOG(Error) << "An event delay of " << delays[i] << " ms does not fit in a schedule period of " << duration << " ms.";
+            return false;
+        }
+        if (i > 0 && delays[i] - delays[i - 1] < EVENT_SPACING) {
+            LOG(Error) << "Events at " << delays[i - 1] << " ms and " << delays[i] << " ms are closer than "
+                       << EVENT_SPACING << " ms.";
+            return false;
+        }
+    }
+    // the last event of one period also has to be clear of the first event of the next
+    if (count > 1 && duration - delays[count - 1] + delays[0] < EVENT_SPACING) {
+        LOG(Error) << "A schedule period of " << duration << " ms leaves less than " << EVENT_SPACING
+                   << " ms between the last event and the first event of the next period.";
+        return false;
+    }
+    return true;
+}
+
+bool Scheduler::can_change_period(unsigned int duration) const {
+    if (duration == 0 || duration > MAX_PERIOD) {
+        LOG(Error) << "Schedule period of " << duration << " ms is not between 1 and " << MAX_PERIOD << " ms.";
+        return false;
+    }
+    return check_spacing(nullptr, 0, nullptr, duration);
+}
+
+bool Scheduler::change_period(unsigned int duration) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled";
+        return false;
+    }
+    if (!can_change_period(duration)) return false;
+    return change_period_unchecked(duration);
+}
+
+bool Scheduler::change_period_unchecked(unsigned int duration) {
+    ChangeScheduleFrame change_schedule;
+    change_schedule.data()[0] = m_id;               // Schedule ID
+    change_schedule.data()[1] = m_sync_char;        // sync character
+    change_schedule.data()[2] = hi_byte(duration);  // schedule duration (byte 1)
+    change_schedule.data()[3] = lo_byte(duration);  // schedule duration (byte 2)
+    if (!change_schedule.write(m_transport)) {
+        LOG(Error) << "Error changing the schedule period to " << duration << " ms.";
+        return false;
+    }
+    m_duration = duration;
+    size_byte_budget(duration);
+    return true;
+}
+
+bool Scheduler::can_change_event_delay(const Channel& channel_, unsigned int delay) const {
+    const Event* event = get_event(channel_.get_channel_num());
+    if (!event) {
+        LOG(Error) << "Channel " << channel_.get_channel_name() << " does not have an event on this scheduler.";
+        return false;
+    }
+    return check_spacing(event, delay, nullptr, m_duration);
+}
+
+bool Scheduler::change_event_delay(const Channel& channel_, unsigned int delay) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled";
+        return false;
+    }
+    if (!can_change_event_delay(channel_, delay)) return false;
+    return get_event(channel_.get_channel_num())->change_delay(delay);
+}
+
+bool Scheduler::can_change_schedule(unsigned int duration, const unsigned int* delays) const {
+    if (duration == 0 || duration > MAX_PERIOD) {
+        LOG(Error) << "Schedule period of " << duration << " ms is not between 1 and " << MAX_PERIOD << " ms.";
+        return false;
+    }
+    return check_spacing(nullptr, 0, delays, duration);
+}
+
+bool Scheduler::change_schedule(unsigned int duration, const unsigned int* delays) {
+    if (!m_enabled) {
+        LOG(Error) << "Scheduler is not yet enabled";
+        return false;
+    }
+    if (!can_change_schedule(duration, delays)) return false;
+
+    // the events are only checked where they end up, since on the way they may pass each other
+    bool shorter = duration < m_duration;
+    if (!shorter && duration != m_duration && !change_period_unchecked(duration)) return false;
+    bool success = true;
+    for (auto event = m_events.begin(); event != m_events.end(); event++) {
+        unsigned int delay = delays[event->get_channel_num()];
+        if (delay != event->get_delay() && !event->change_delay(delay)) success = false;
+    }
+    if (shorter && !change_period_unchecked(duration)) return false;
+    return success;
+}
 }  // namespace fes
 }  // namespace mahi
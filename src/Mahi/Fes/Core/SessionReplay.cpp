@@ -0,0 +1,281 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/SessionReplay.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <sstream>
+#include <thread>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+bool SessionDecoder::open(const std::string& filename_) {
+    if (!m_reader.open(filename_)) return false;
+    return rewind();
+}
+
+bool SessionDecoder::rewind() {
+    m_num_queued  = 0;
+    m_next_queued = 0;
+    for (size_t p = 0; p < MAX_PORTS; p++) {
+        m_event_channels[p].fill(-1);
+        m_created[p] = 0;
+    }
+    return m_reader.rewind();
+}
+
+bool SessionDecoder::next(ReplayCommand& command) {
+    while (m_next_queued == m_num_queued) {
+        m_num_queued  = 0;
+        m_next_queued = 0;
+        SessionRecord record;
+        if (!m_reader.next(record)) return false;
+        decode(record);
+    }
+    command = m_queued[m_next_queued++];
+    return true;
+}
+
+void SessionDecoder::queue(const ReplayCommand& command) {
+    if (m_num_queued < MAX_QUEUED) m_queued[m_num_queued++] = command;
+}
+
+int SessionDecoder::get_channel(unsigned char port, unsigned char event_id) const {
+    int board_channel = m_event_channels[port][event_id];
+    return board_channel < 0 ? -1 : port * 4 + board_channel;
+}
+
+void SessionDecoder::decode(const SessionRecord& record) {
+    if (record.port >= MAX_PORTS) return;
+    const unsigned char* bytes = record.bytes;
+
+    // a reply is one frame. The only ones of interest give the id the board picked for an event
+    if (record.direction == FrameDirection::RxRaw) return;
+    if (record.direction == FrameDirection::Rx) {
+        if (record.size > READ_HEADER_SIZE + 3 && bytes[6] == CREATE_EVENT_REPLY_MSG) {
+            m_event_channels[record.port][bytes[READ_HEADER_SIZE]] = bytes[READ_HEADER_SIZE + 3] & 0x03;
+        }
+        return;
+    }
+
+    // one write can hold several frames
+    size_t pos = 0;
+    while (pos + WRITE_HEADER_SIZE <= record.size && bytes[pos] == DEST_ADR && bytes[pos + 1] == SRC_ADR) {
+        unsigned char        type = bytes[pos + 2];
+        size_t               len  = bytes[pos + 3];
+        const unsigned char* data = bytes + pos + WRITE_HEADER_SIZE;
+        if (pos + WRITE_HEADER_SIZE + len + 1 > record.size) break;
+        pos += WRITE_HEADER_SIZE + len + 1;
+
+        ReplayCommand command;
+        command.time_ns = record.time_ns;
+        command.setup   = type == CREATE_SCHEDULE_MSG || type == CREATE_EVENT_MSG;
+        switch (type) {
+            case CREATE_SCHEDULE_MSG:
+                if (len < CREATE_SCHED_LEN) break;
+                command.type  = ReplayCommand::Period;
+                command.value = data[1] * 256 + data[2];
+                queue(command);
+                break;
+            case CHANGE_SCHEDULE_MSG:
+                if (len < CHANGE_SCHED_LEN) break;
+                command.type  = ReplayCommand::Period;
+                command.value = data[2] * 256 + data[3];
+                queue(command);
+                break;
+            case CREATE_EVENT_MSG: {
+                if (len < CR_EVT_LEN) break;
+                // ids are handed out in the order events are created until a reply says otherwise
+                unsigned char event_id = ++m_created[record.port];
+                if (m_event_channels[record.port][event_id] < 0) m_event_channels[record.port][event_id] = data[5] & 0x03;
+                command.channel_num = (unsigned char)(record.port * 4 + (data[5] & 0x03));
+                command.type        = ReplayCommand::Delay;
+                command.value       = data[1] * 256 + data[2];
+                queue(command);
+                command.type       = ReplayCommand::Stimulation;
+                command.pulsewidth = data[6];
+                command.amplitude  = data[7];
+                queue(command);
+                break;
+            }
+            case CHANGE_EVENT_SCHED_MSG: {
+                int channel = len < CHANGE_EVENT_SCHED_LEN ? -1 : get_channel(record.port, data[0]);
+                if (channel < 0) break;
+                command.type        = ReplayCommand::Delay;
+                command.channel_num = (unsigned char)channel;
+                command.value       = data[2] * 256 + data[3];
+                queue(command);
+                break;
+            }
+            case CHANGE_EVENT_PARAMS_MSG: {
+                int channel = len < CHANGE_EVENT_PARAMS_LEN ? -1 : get_channel(record.port, data[0]);
+                if (channel < 0) break;
+                command.type        = ReplayCommand::Stimulation;
+                command.channel_num = (unsigned char)channel;
+                command.pulsewidth  = data[1];
+                command.amplitude   = data[2];
+                queue(command);
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+bool CommandFile::open(const std::string& filename_) {
+    m_file.close();
+    m_file.clear();
+    m_file.open(filename_);
+    if (!m_file.is_open()) {
+        LOG(Error) << "Could not open command file " << filename_;
+        return false;
+    }
+    m_line_num = 0;
+    return true;
+}
+
+bool CommandFile::rewind() {
+    if (!m_file.is_open()) return false;
+    m_file.clear();
+    m_file.seekg(0);
+    m_line_num = 0;
+    return true;
+}
+
+bool CommandFile::next(ReplayCommand& command) {
+    while (std::getline(m_file, m_line)) {
+        m_line_num++;
+        size_t start = m_line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || m_line[start] == '#') continue;
+        for (size_t i = start; i < m_line.size(); i++) {
+            if (m_line[i] == ',') m_line[i] = ' ';
+        }
+        std::istringstream line(m_line);
+        double             time_s;
+        unsigned int       channel_num, amplitude, pulsewidth;
+        if (!(line >> time_s >> channel_num >> amplitude >> pulsewidth) || channel_num > 255 || amplitude > 255 ||
+            pulsewidth > 255) {
+            LOG(Warning) << "Skipping line " << m_line_num << " of the command file: " << m_line;
+            continue;
+        }
+        command.time_ns     = (int64_t)(time_s * 1e9);
+        command.type        = ReplayCommand::Stimulation;
+        command.channel_num = (unsigned char)channel_num;
+        command.amplitude   = (unsigned char)amplitude;
+        command.pulsewidth  = (unsigned char)pulsewidth;
+        command.value       = 0;
+        command.setup       = false;
+        return true;
+    }
+    return false;
+}
+
+SessionReplay::SessionReplay(Stimulator& stimulator_) : m_stimulator(stimulator_) {}
+
+void SessionReplay::set_speed(double speed_) { m_speed = speed_ > 0 ? speed_ : 0; }
+
+void SessionReplay::set_schedule_changes(bool enabled_) { m_schedule = enabled_; }
+
+void SessionReplay::stop() { m_stop = true; }
+
+SessionReplay::Stats SessionReplay::get_stats() const { return m_stats; }
+
+bool SessionReplay::run(ReplaySource& source_) {
+    m_stop  = false;
+    m_stats = Stats();
+    if (!source_.rewind()) {
+        LOG(Error) << "Could not rewind the replay source";
+        return false;
+    }
+
+    m_channels = m_stimulator.get_channels();
+    m_channel_index.assign(256, -1);
+    for (size_t i = 0; i < m_channels.size(); i++) m_channel_index[m_channels[i].get_channel_num()] = (int)i;
+
+    ReplayCommand command;
+    bool          pending = source_.next(command);
+    int64_t       origin_ns = pending ? command.time_ns : 0;
+    Clock::time_point start = Clock::now();
+    int64_t       max_late_ns = 0;
+    bool          success = true;
+
+    while (pending && !m_stop) {
+        // every command with the same time goes out in the same update
+        int64_t time_ns = command.time_ns;
+        if (m_speed > 0) {
+            Clock::time_point deadline = start + std::chrono::nanoseconds((int64_t)((time_ns - origin_ns) / m_speed));
+            wait_until(deadline);
+            if (m_stop) break;
+            int64_t late_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - deadline).count();
+            if (late_ns > max_late_ns) max_late_ns = late_ns;
+        }
+        do {
+            apply(command);
+            pending = source_.next(command);
+        } while (pending && command.time_ns == time_ns);
+
+        if (!m_stimulator.update()) {
+            LOG(Error) << "Stimulator update failed. Stopping the replay";
+            success = false;
+            break;
+        }
+    }
+
+    m_stats.max_lateness = microseconds(max_late_ns / 1000);
+    m_stats.elapsed      = microseconds(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    return success;
+}
+
+void SessionReplay::apply(const ReplayCommand& command) {
+    if (command.type != ReplayCommand::Stimulation && !m_schedule) return;
+    m_stats.commands++;
+
+    if (command.type == ReplayCommand::Period) {
+        if (command.value == 0) return;
+        if (command.setup && m_stimulator.get_period().as_microseconds() == (int64_t)command.value * 1000) return;
+        // set_frequency truncates the period to whole ms, so aim a little past it
+        if (!m_stimulator.set_frequency(1000.0 / (command.value + 0.25))) m_stats.rejected++;
+        return;
+    }
+
+    int index = m_channel_index[command.channel_num];
+    if (index < 0) {
+        m_stats.unknown++;
+        return;
+    }
+    const Channel& channel = m_channels[index];
+    if (command.type == ReplayCommand::Delay) {
+        if (command.setup && m_stimulator.get_event_delay(channel) == command.value) return;
+        if (!m_stimulator.set_event_delay(channel, command.value)) m_stats.rejected++;
+    } else {
+        m_stimulator.set_amp(channel, command.amplitude);
+        m_stimulator.write_pw(channel, command.pulsewidth);
+    }
+}
+
+void SessionReplay::wait_until(Clock::time_point deadline) const {
+    // sleeping is only accurate to about a ms, so the last stretch is spun
+    const std::chrono::microseconds spin(1500);
+    Clock::time_point               now = Clock::now();
+    if (deadline - now > spin) std::this_thread::sleep_until(deadline - spin);
+    while (Clock::now() < deadline && !m_stop) {
+    }
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/SlotAllocator.hpp>
+#include <Mahi/Util.hpp>
+#include <algorithm>
+
+namespace mahi {
+namespace fes {
+
+SlotAllocator::SlotAllocator(SlotPolicy policy_, unsigned int min_spacing_) :
+    m_policy(policy_),
+    m_min_spacing(min_spacing_) {}
+
+void SlotAllocator::set_policy(SlotPolicy policy_) { m_policy = policy_; }
+
+SlotPolicy SlotAllocator::get_policy() const { return m_policy; }
+
+void SlotAllocator::set_min_spacing(unsigned int min_spacing_) { m_min_spacing = min_spacing_; }
+
+unsigned int SlotAllocator::get_slot_width(const Channel& channel_) const {
+    unsigned int width = (channel_.get_pulse_duration() + 999) / 1000;
+    return width > m_min_spacing ? width : m_min_spacing;
+}
+
+bool SlotAllocator::allocate(const std::vector<Channel>& channels_, unsigned int duration,
+                             std::vector<unsigned int>& delays) const {
+    delays.assign(channels_.size(), 0);
+
+    std::vector<std::vector<size_t>> boards;
+    for (size_t i = 0; i < channels_.size(); i++) {
+        size_t board = channels_[i].get_board_num();
+        if (boards.size() <= board) boards.resize(board + 1);
+        boards[board].push_back(i);
+    }
+
+    // every board runs its own schedule, so each only has to fit its own events in the period
+    bool   success = true;
+    size_t busiest = 0;
+    for (size_t b = 0; b < boards.size(); b++) {
+        if (boards[b].empty()) continue;
+        if (!place(channels_, boards[b], duration, m_policy != SlotPolicy::Packed, delays)) success = false;
+        if (boards[b].size() > busiest) busiest = boards[b].size();
+    }
+    if (!success || m_policy != SlotPolicy::Interleaved || boards.size() < 2) return success;
+
+    // stagger the boards by a fraction of the gap between events, so board b pulses b/num_boards of the
+    // way between the pulses of the first board. Moving all of a board's events keeps their spacing
+    unsigned int step = duration / (unsigned int)busiest;
+    for (size_t b = 1; b < boards.size(); b++) {
+        if (boards[b].empty()) continue;
+        unsigned int last = 0;
+        for (size_t k = 0; k < boards[b].size(); k++) last = std::max(last, delays[boards[b][k]]);
+        unsigned int shift = std::min((unsigned int)(step * b / boards.size()), duration - 1 - last);
+        for (size_t k = 0; k < boards[b].size(); k++) delays[boards[b][k]] += shift;
+    }
+    return true;
+}
+
+bool SlotAllocator::place(const std::vector<Channel>& channels_, const std::vector<size_t>& indices,
+                          unsigned int duration, bool spread, std::vector<unsigned int>& delays) const {
+    unsigned int total = 0;
+    for (size_t k = 0; k < indices.size(); k++) {
+        total += get_slot_width(channels_[indices[k]]);
+    }
+    // the last slot has to end before the first slot of the next period starts
+    if (total > duration) {
+        LOG(Error) << indices.size() << " events need " << total << " ms but the schedule period is only "
+                   << duration << " ms.";
+        return false;
+    }
+
+    unsigned int slack = spread ? duration - total : 0;
+    unsigned int start = 0;
+    for (size_t k = 0; k < indices.size(); k++) {
+        delays[indices[k]] = start + (unsigned int)(slack * k / indices.size());
+        start += get_slot_width(channels_[indices[k]]);
+    }
+    return true;
+}
+
+}  // namespace fes
+}  // namespace mahi
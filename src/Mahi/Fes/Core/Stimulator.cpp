@@ -14,15 +14,15 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
-#include <Windows.h>
-#include <tchar.h>
-
 #include <Mahi/Fes/Core/Event.hpp>
 #include <Mahi/Fes/Core/Stimulator.hpp>
+#include <Mahi/Fes/Core/StimulatorGroup.hpp>
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
+#include <Mahi/Fes/Utility/SerialTransport.hpp>
 #include <Mahi/Util.hpp>
-#include <codecvt>
-#include <locale>
+#include <array>
+#include <fstream>
 #include <mutex>
 #include <string>
 
@@ -32,47 +32,72 @@ namespace mahi {
 namespace fes {
 
 Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_,  const std::string& com_port_1_, const std::string& com_port_2_, bool is_virtual_) :
+    Stimulator(name_, channels_, std::vector<std::string>({com_port_1_, com_port_2_}), is_virtual_) {}
+
+Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_, const std::vector<std::string>& com_ports_, bool is_virtual_) :
+    Stimulator(name_, channels_, make_serial_transports(com_ports_), is_virtual_) {}
+
+Stimulator::Stimulator(const std::string& name_, std::vector<Channel>& channels_, std::vector<std::shared_ptr<Transport>> transports_, bool is_virtual_) :
+    m_transports(transports_),
     m_name(name_),
-    m_com_port_1(com_port_1_),
-    m_com_port_2(com_port_2_),
-    m_com_ports({m_com_port_1, m_com_port_2}),
-    m_hComms({&m_hComm_1, &m_hComm_2}),
     m_enabled(false),
     m_is_virtual(is_virtual_),
     m_channels(channels_),
-    m_scheduler_1(),
-    m_scheduler_2(),
-    m_schedulers({&m_scheduler_1, &m_scheduler_2}),
-    num_events(channels_.size()),
-    amplitudes(num_events, 0),
-    pulsewidths(num_events, 0),
-    max_amplitudes(num_events, 0),
-    max_pulsewidths(num_events, 0) {
+    num_events(channels_.size()) {
     for (auto i = 0; i < num_events; i++) {
-        max_amplitudes[i]  = m_channels[i].get_max_amplitude();
-        max_pulsewidths[i] = m_channels[i].get_max_pulse_width();
         channel_names.push_back(m_channels[i].get_channel_name());
+        // index the channels by channel number so lookups do not have to search by name
+        unsigned char channel_num = m_channels[i].get_channel_num();
+        if (m_channel_index.size() <= channel_num) m_channel_index.resize(channel_num + 1, -1);
+        m_channel_index[channel_num] = (int)i;
+        // a channel the store cannot hold has nowhere to keep its values (and no place in the per-channel
+        // tables sized by the store), so the stimulator is never enabled with it
+        if (!m_store.add_channel(channel_num, m_channels[i].get_max_amplitude(), m_channels[i].get_max_pulse_width())) {
+            m_channels_fit = false;
+        }
     }
-    if (m_com_port_2.compare("NONE") != 0){
-        m_num_ports = 2;
+    // one board (and scheduler) per transport: the first handles channels 1-4, the next 5-8, and so on
+    m_num_ports = m_transports.size();
+    for (size_t i = 0; i < m_num_ports; i++){
+        m_com_ports.push_back(m_transports[i]->get_port_name());
+        m_transport_ptrs.push_back(m_transports[i].get());
+        m_schedulers.push_back(std::unique_ptr<Scheduler>(new Scheduler()));
+        // every scheduler keeps its event values in the stimulator's store so there is only one copy
+        m_schedulers[i]->set_store(&m_store);
+        // replies to setup commands are read through the port's own parser, which it uses afterwards too
+        m_commands.push_back(std::unique_ptr<CommandQueue>(new CommandQueue(m_transport_ptrs[i])));
+        m_sync.add(m_schedulers[i].get());
+        m_latency.push_back(std::unique_ptr<LatencyRecorder>(new LatencyRecorder()));
     }
-    
+    m_port_ns.resize(m_num_ports, 0);
+
     enable();
 }
 
+std::vector<std::shared_ptr<Transport>> Stimulator::make_serial_transports(const std::vector<std::string>& com_ports_) {
+    std::vector<std::shared_ptr<Transport>> transports;
+    for (size_t i = 0; i < com_ports_.size(); i++) {
+        if (com_ports_[i].compare("NONE") == 0) continue;
+        transports.push_back(std::make_shared<SerialTransport>(com_ports_[i]));
+    }
+    return transports;
+}
+
 Stimulator::~Stimulator() { disable(); }
 
 // Open and configure serial port, and initialize the channels on the board.
 bool Stimulator::enable() {
+    if (!m_channels_fit) {
+        LOG(Error) << "The channels of " << m_name << " must have channel numbers below " << ChannelStore::CAPACITY
+                   << ". Not enabling the stimulator";
+        return false;
+    }
+    m_bring_up_clock.restart();
     // open the comport with read/write permissions
     for (size_t i = 0; i < m_num_ports; i++)
     {
-        if (!open_port(m_hComms[i], m_com_ports[i])) {
-            disable();
-            return m_enabled;
-        }
-        // Configure the parameters for serial port ttyUSB0
-        if (!configure_port(m_hComms[i])) {
+        // opening the transport also configures it (baud rate, parity, timeouts)
+        if (!m_transports[i]->open()) {
             disable();
             return m_enabled;
         }
@@ -87,6 +112,8 @@ bool Stimulator::enable() {
 }
 
 void Stimulator::disable() {
+    // the I/O thread must hand back the transports before the schedulers can use them
+    stop_io_thread();
     if (is_enabled()) {
         for (size_t i = 0; i < m_num_ports; i++){
             m_schedulers[i]->disable();
@@ -99,106 +126,46 @@ void Stimulator::disable() {
     m_enabled = false;
 }
 
-bool Stimulator::open_port(HANDLE* hComm, std::string com_port) {
-    // the comport must be formatted as an LPCWSTR, so we need to get it into that form from a
-    // std::string
-    std::wstring com_prefix = L"\\\\.\\";
-    std::wstring com_suffix =
-        std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(com_port);
-    std::wstring comID = com_prefix + com_suffix;
-
-    // std::wstring stemp = std::wstring(com_port_formatted.begin(), com_port_formatted.end());
-    // LPCWSTR com_port_lpcwstr = stemp.c_str();
-
-    *hComm = CreateFileW(comID.c_str(),                 // port name
-                        GENERIC_READ | GENERIC_WRITE,  // Read/Write
-                        0,                             // No Sharing
-                        NULL,                          // No Security
-                        OPEN_EXISTING,                 // Open existing port only
-                        0,                             // Non Overlapped I/O
-                        NULL);                         // Null for Comm Devices
-
-    // Check if creating the comport was successful or not and log it
-    if (*hComm == INVALID_HANDLE_VALUE) {
-        LOG(Error) << "Failed to open port " << com_port;
-        return false;
-    } else {
-        LOG(Info) << "Successfully opened port " << com_port;
-    }
-
-    return true;
-}
-
-bool Stimulator::configure_port(HANDLE* hComm) {  // configure_port establishes the settings for each serial port
-
-    // http://bd.eduweb.hhs.nl/micprg/pdf/serial-win.pdf
-
-    m_dcbSerialParams.DCBlength = sizeof(DCB);
-
-    if (!GetCommState(*hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error getting serial port state";
-        return false;
+bool Stimulator::initialize_board() {
+    for (size_t i = 0; i < m_channels.size(); i++) {
+        if (m_channels[i].get_board_num() >= m_num_ports) {
+            LOG(Error) << "Channel " << m_channels[i].get_channel_name() << " is on a board without a comport.";
+            return false;
+        }
     }
 
-    // set parameters to use for serial communication
-
-    // set the baud rate that we will communicate at to 9600
-    m_dcbSerialParams.BaudRate = CBR_9600;
-
-    // 8 bits in the bytes transmitted and received.
-    m_dcbSerialParams.ByteSize = 8;
-
-    // Specify that we are using one stop bit
-    m_dcbSerialParams.StopBits = ONESTOPBIT;
+    // the UECU does not acknowledge channel setup, so each channel is still given m_delay_time to be
+    // processed, but the boards are set up at the same time
+    bool success = for_each_port([this](size_t port) {
+        for (size_t i = 0; i < m_channels.size(); i++) {
+            if (m_channels[i].get_board_num() != port) continue;
+            if (!m_channels[i].setup_channel(m_transport_ptrs[port], m_delay_time)) return false;
+        }
+        return true;
+    });
 
-    // Specify that we are using no parity
-    m_dcbSerialParams.Parity = NOPARITY;
+    if (success) LOG(Info) << "Setup Completed successfully.";
 
-    // Disable all parameters dealing with flow control
-    m_dcbSerialParams.fOutX       = FALSE;
-    m_dcbSerialParams.fInX        = FALSE;
-    m_dcbSerialParams.fRtsControl = RTS_CONTROL_DISABLE;
-    m_dcbSerialParams.fDtrControl = DTR_CONTROL_DISABLE;
-    // dcbSerialParams.fOutxCtsFlow = FALSE;
-    // dcbSerialParams.fOutxDsrFlow = FALSE;
+    return success;
+}
 
-    // Set communication parameters for the serial port
-    if (!SetCommState(*hComm, &m_dcbSerialParams)) {
-        LOG(Error) << "Error setting serial port state";
-        return false;
+bool Stimulator::for_each_port(const std::function<bool(size_t)>& work) {
+    // each port has its own transport and scheduler, so the ports can be driven from separate threads
+    std::vector<char>        results(m_num_ports, 0);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < m_num_ports; i++) {
+        threads.push_back(std::thread([&results, &work, i]() { results[i] = work(i); }));
     }
-
-    COMMTIMEOUTS timeouts                = {0};
-    timeouts.ReadIntervalTimeout         = 10;
-    timeouts.ReadTotalTimeoutConstant    = 10;
-    timeouts.ReadTotalTimeoutMultiplier  = 10;
-    timeouts.WriteTotalTimeoutConstant   = 50;
-    timeouts.WriteTotalTimeoutMultiplier = 10;
-    if (!SetCommTimeouts(*hComm, &timeouts)) {
-        LOG(Error) << "Error setting serial port timeouts";
-        return false;
+    if (m_num_ports > 0) results[0] = work(0);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
     }
 
-    PurgeComm(*hComm,PURGE_TXABORT);
-    PurgeComm(*hComm,PURGE_RXABORT);
-    PurgeComm(*hComm,PURGE_RXCLEAR);
-	PurgeComm(*hComm,PURGE_TXCLEAR);
-
-    return true;
-}
-
-bool Stimulator::initialize_board() {
-    // delay time after sending setup messages of serial comm
-
-    for (auto i = 0; i < m_channels.size(); i++) {
-        if (!m_channels[i].setup_channel(*m_hComms[m_channels[i].get_board_num()], m_delay_time)) {
-            return false;
-        };
+    bool success = true;
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (!results[i]) success = false;
     }
-
-    LOG(Info) << "Setup Completed successfully.";
-
-    return true;
+    return success;
 }
 
 bool Stimulator::halt_scheduler() { 
@@ -214,7 +181,7 @@ bool Stimulator::halt_scheduler() {
 
 void Stimulator::close_stimulator() {
     for (size_t i = 0; i < m_num_ports; i++){
-        CloseHandle(*m_hComms[i]);
+        m_transports[i]->close();
     }
     
     m_enabled = false;
@@ -223,13 +190,8 @@ void Stimulator::close_stimulator() {
 bool Stimulator::begin() {
     if (is_enabled()) {
         m_enabled = true;
-        bool success = true;
-        for (size_t i = 0; i < m_num_ports; i++)
-        {
-            if(!m_schedulers[i]->send_sync_msg()){
-                success = false;
-            }
-        }
+        bool success = m_sync.release();
+        finish_bring_up(m_sync.get_last_skew());
         return success;
     } else {
         LOG(Error) << "Stimulator has not yet been opened. Not starting the stimulator";
@@ -237,89 +199,248 @@ bool Stimulator::begin() {
     }
 }
 
-void Stimulator::set_amp(Channel channel_, unsigned int amp_) {
-    if (is_enabled()) {
-        m_schedulers[channel_.get_board_num()]->set_amp(channel_, amp_);
+void Stimulator::finish_bring_up(Time skew) {
+    m_bring_up_time = m_bring_up_clock.get_elapsed_time();
+    LOG(Info) << "Bring-up of " << m_name << " took " << m_bring_up_time.as_milliseconds() << " ms. Boards started "
+              << skew.as_microseconds() << " us apart.";
+}
+
+void Stimulator::set_max_sync_skew(Time max_skew_, int max_attempts_) { m_sync.set_max_skew(max_skew_, max_attempts_); }
+
+void Stimulator::set_resync_interval(Time interval_) { m_sync.set_resync_interval(interval_); }
+
+Time Stimulator::get_sync_skew() const { return m_sync.get_last_skew(); }
+
+Time Stimulator::get_max_sync_skew() const { return m_sync.get_worst_skew(); }
+
+size_t Stimulator::get_sync_count() const { return m_sync.get_release_count(); }
+
+std::chrono::steady_clock::time_point Stimulator::get_sync_time() const { return m_sync.get_release_time(); }
+
+bool Stimulator::set_amp(const Channel& channel_, unsigned int amp_) {
+    if (m_io_running) {
+        if (m_mailbox.post_amplitude(channel_.get_channel_num(), amp_)) return true;
+        LOG_LIMITED(Error, log_key(LogTopic::MissingChannel, channel_.get_channel_num()))
+            << "Channel " << channel_.get_channel_name() << " has no slot in the mailbox of " << m_name;
+        return false;
+    } else if (is_enabled()) {
+        Scheduler* scheduler = get_scheduler(channel_);
+        return scheduler && scheduler->set_amp(channel_, amp_);
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not writing amplitude";
+        return false;
     }
 }
 
-void Stimulator::set_amps(std::vector<Channel> channels_, std::vector<unsigned int> amplitudes_) {
+bool Stimulator::set_amps(std::vector<Channel> channels_, std::vector<unsigned int> amplitudes_) {
+    bool success = true;
     for (size_t i = 0; i < channels_.size(); i++) {
-        set_amp(channels_[i], amplitudes_[i]);
+        if (!set_amp(channels_[i], amplitudes_[i])) success = false;
     }
+    return success;
 }
 
-void Stimulator::write_pws(std::vector<Channel> channels_, std::vector<unsigned int> pulsewidths_) {
+bool Stimulator::write_pws(std::vector<Channel> channels_, std::vector<unsigned int> pulsewidths_) {
+    bool success = true;
     for (size_t i = 0; i < channels_.size(); i++) {
-        write_pw(channels_[i], pulsewidths_[i]);
+        if (!write_pw(channels_[i], pulsewidths_[i])) success = false;
     }
+    return success;
 }
 
-void Stimulator::write_pw(Channel channel_, unsigned int pw_) {
-    if (is_enabled()) {
-        m_schedulers[channel_.get_board_num()]->write_pw(channel_, pw_);
+bool Stimulator::write_pws(const unsigned char* channel_nums_, const unsigned int* pulsewidths_, size_t count_) {
+    if (m_io_running) {
+        bool success = true;
+        for (size_t i = 0; i < count_; i++) {
+            if (!m_mailbox.post_pulsewidth(channel_nums_[i], pulsewidths_[i])) success = false;
+        }
+        if (!success) {
+            LOG_LIMITED(Error, log_key(LogTopic::MissingChannel, 0))
+                << "Some of the channels written to have no slot in the mailbox of " << m_name;
+        }
+        return success;
+    } else if (is_enabled()) {
+        // one change to the store for all of them, rather than one per channel
+        if (!m_store.set_pulsewidths(channel_nums_, pulsewidths_, count_)) {
+            LOG_LIMITED(Error, log_key(LogTopic::MissingChannel, 0)) << "Some of the channels written to are not on " << m_name;
+            return false;
+        }
+        return true;
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not writing pulsewidth";
+        return false;
     }
 }
 
-void Stimulator::update_max_amp(Channel channel_, unsigned int max_amp_) {
-    for (auto channel = m_channels.begin(); channel != m_channels.end(); channel++) {
-        // if the channel is the correct channel we are looking for, set the max amplitude of the
-        // channel
-        if (channel->get_channel_name() == channel_.get_channel_name()) {
-            channel->set_max_amplitude(max_amp_);
-            return;
-        }
+bool Stimulator::write_pw(const Channel& channel_, unsigned int pw_) {
+    if (m_io_running) {
+        if (m_mailbox.post_pulsewidth(channel_.get_channel_num(), pw_)) return true;
+        LOG_LIMITED(Error, log_key(LogTopic::MissingChannel, channel_.get_channel_num()))
+            << "Channel " << channel_.get_channel_name() << " has no slot in the mailbox of " << m_name;
+        return false;
+    } else if (is_enabled()) {
+        Scheduler* scheduler = get_scheduler(channel_);
+        return scheduler && scheduler->write_pw(channel_, pw_);
+    } else {
+        LOG(Error) << "Stimulator has not yet been enabled. Not writing pulsewidth";
+        return false;
+    }
+}
+
+void Stimulator::update_max_amp(const Channel& channel_, unsigned int max_amp_) {
+    int i = get_channel_index(channel_.get_channel_num());
+    if (i >= 0) {
+        m_channels[i].set_max_amplitude(max_amp_);
+        m_store.set_max_amplitude(channel_.get_channel_num(), max_amp_);
+    } else {
+        LOG(Error) << "Did not find the correct channel to update";
+    }
+}
+
+void Stimulator::update_max_pw(const Channel& channel_, unsigned int max_pw_) {
+    int i = get_channel_index(channel_.get_channel_num());
+    if (i >= 0) {
+        m_channels[i].set_max_pulse_width(max_pw_);
+        m_store.set_max_pulse_width(channel_.get_channel_num(), max_pw_);
+    } else {
+        LOG(Error) << "Did not find the correct channel to update";
+    }
+}
+
+bool Stimulator::set_slot_policy(SlotPolicy policy_) {
+    // the I/O thread places the events again whenever the period changes, so the policy it reads
+    // cannot change under it
+    if (m_io_running) {
+        LOG(Error) << "Cannot change the slot policy of " << m_name << " while the I/O thread is running";
+        return false;
     }
-    LOG(Error) << "Did not find the correct channel to update";
+    m_slots.set_policy(policy_);
+    return true;
 }
 
-void Stimulator::update_max_pw(Channel channel_, unsigned int max_pw_) {
-    for (auto channel = m_channels.begin(); channel != m_channels.end(); channel++) {
-        // if the channel is the correct channel we are looking for, set the max pulsewidth of the
-        // channel
-        if (channel->get_channel_name() == channel_.get_channel_name()) {
-            channel->set_max_pulse_width(max_pw_);
-            return;
+unsigned int Stimulator::get_event_delay(const Channel& channel_) {
+    Scheduler* scheduler = get_scheduler(channel_);
+    const Event* event   = scheduler ? scheduler->get_event(channel_.get_channel_num()) : nullptr;
+    return event ? event->get_delay() : 0;
+}
+
+bool Stimulator::get_slot_delay(const Channel& channel_, unsigned int& delay) const {
+    int i = get_channel_index(channel_.get_channel_num());
+    if (i < 0 || (size_t)i >= m_slot_delays.size()) return false;
+    delay = m_slot_delays[i];
+    return true;
+}
+
+bool Stimulator::set_frequency(double frequency_) {
+    unsigned int duration = frequency_ > 0 ? (unsigned int)(1.0 / frequency_ * 1000) : 0;
+    if (duration == 0 || duration > Scheduler::MAX_PERIOD) {
+        LOG(Error) << "Cannot stimulate at " << frequency_ << " Hz.";
+        return false;
+    }
+    if (m_io_running) {
+        // the channels never change, so whether the events can be placed in the new period is known
+        // here, and once they can, the I/O thread can always make the change
+        std::vector<unsigned int> delays;
+        if (!m_slots.allocate(m_channels, duration, delays)) {
+            LOG(Error) << "The channels of " << m_name << " do not fit in a " << duration
+                       << " ms schedule period. Not changing the frequency";
+            return false;
         }
+        m_mailbox.post_period(duration);
+        return true;
+    } else if (is_enabled()) {
+        return apply_period(duration);
+    } else {
+        LOG(Error) << "Stimulator has not yet been enabled. Not changing the frequency";
+        return false;
     }
-    LOG(Error) << "Did not find the correct channel to update";
+}
+
+double Stimulator::get_frequency() { return 1.0 / get_period().as_seconds(); }
+
+Time Stimulator::get_period() { return microseconds(m_period_us); }
+
+bool Stimulator::apply_period(unsigned int duration) {
+    // the events are placed again for the new period, since the delays that suited the old one can
+    // crowd the end of a shorter one (and leave a longer one unevenly filled)
+    if (!m_slots.allocate(m_channels, duration, m_next_delays)) {
+        LOG(Error) << "The channels of " << m_name << " do not fit in a " << duration
+                   << " ms schedule period. Not changing the frequency";
+        return false;
+    }
+    std::array<unsigned int, ChannelStore::CAPACITY> delays;
+    delays.fill(0);
+    for (size_t i = 0; i < m_channels.size(); i++) delays[m_channels[i].get_channel_num()] = m_next_delays[i];
+
+    // the boards must never end up at different frequencies, so none change unless all of them can
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (!m_schedulers[i]->can_change_schedule(duration, delays.data())) return false;
+    }
+    bool success = true;
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (!m_schedulers[i]->change_schedule(duration, delays.data())) success = false;
+    }
+    if (success) {
+        m_period_us = milliseconds(duration).as_microseconds();
+        m_slot_delays.swap(m_next_delays);
+    }
+    return success;
+}
+
+bool Stimulator::set_event_delay(const Channel& channel_, unsigned int delay_) {
+    if (m_io_running) {
+        return m_mailbox.post_delay(channel_.get_channel_num(), delay_);
+    } else if (is_enabled()) {
+        Scheduler* scheduler = get_scheduler(channel_);
+        return scheduler && scheduler->change_event_delay(channel_, delay_);
+    } else {
+        LOG(Error) << "Stimulator has not yet been enabled. Not changing the event delay";
+        return false;
+    }
+}
+
+void Stimulator::get_snapshot(std::vector<ChannelState>& snapshot) const {
+    ChannelStore::Snapshot store_snapshot;
+    m_store.get_snapshot(store_snapshot);
+    snapshot.resize(m_channels.size());
+    for (size_t i = 0; i < m_channels.size(); i++) {
+        unsigned char channel_num   = m_channels[i].get_channel_num();
+        snapshot[i].channel_num     = channel_num;
+        snapshot[i].amplitude       = store_snapshot.amplitude[channel_num];
+        snapshot[i].pulsewidth      = store_snapshot.pulsewidth[channel_num];
+        snapshot[i].max_amplitude   = store_snapshot.max_amplitude[channel_num];
+        snapshot[i].max_pulse_width = store_snapshot.max_pulse_width[channel_num];
+    }
+}
+
+void Stimulator::get_snapshot(ChannelStore::Snapshot& snapshot) const { m_store.get_snapshot(snapshot); }
+
+Scheduler* Stimulator::get_scheduler(const Channel& channel_) {
+    if (channel_.get_board_num() >= m_num_ports) {
+        LOG_LIMITED(Error, log_key(LogTopic::MissingChannel, channel_.get_channel_num()))
+            << "Channel " << channel_.get_channel_name() << " is on a board without a comport.";
+        return nullptr;
+    }
+    return m_schedulers[channel_.get_board_num()].get();
+}
+
+int Stimulator::get_channel_index(unsigned char channel_num) const {
+    return channel_num < m_channel_index.size() ? m_channel_index[channel_num] : -1;
 }
 
 bool Stimulator::update() {
-    if (is_enabled()) {
-        {
-            std::lock_guard<std::mutex> lock(m_mtx);
-            for (size_t j = 0; j < m_num_ports; j++)
-            {
-                for (size_t i = 0; i < m_schedulers[j]->get_num_events(); i++) {
-                    Channel channel_ = m_schedulers[j]->get_events()[i].get_channel();
-                    
-                    amplitudes[channel_.get_channel_num()]      = m_schedulers[j]->get_amp(channel_);
-                    pulsewidths[channel_.get_channel_num()]     = m_schedulers[j]->get_pw(channel_);
-                    max_amplitudes[channel_.get_channel_num()]  = channel_.get_max_amplitude();
-                    max_pulsewidths[channel_.get_channel_num()] = channel_.get_max_pulse_width();
-                }
-            }
-        }
-        bool success = true;
-        for (size_t i = 0; i < m_num_ports; i++)
-        {
-            if(!m_schedulers[i]->update()){
-                success = false;
-            }
-        }
-        std::vector<ReadMessage> incoming_messages = get_all_messages(m_hComms,m_num_ports);
-        for (size_t i = 0; i < incoming_messages.size(); i++){
-            if (!incoming_messages[i].is_valid()){
-                LOG(Error) << "Return message (below) either invalid or an error. Disabling stimulator.";
-                print_message(incoming_messages[i].get_message());
-                success = false;
-            }
+    if (m_io_running) {
+        // the I/O thread does the work; just report if it has stopped because of a failure
+        if (m_io_failed) {
+            LOG(Error) << "I/O thread failed. Disabling stimulator.";
+            disable();
+            return false;
         }
+        return true;
+    } else if (is_enabled()) {
+        // nothing pops replies without the I/O thread, so they are only checked
+        bool success = update_ports(false);
+        if (!m_sync.resync_if_due()) success = false;
         if (!success) disable();
         return success;
     } else {
@@ -337,21 +458,30 @@ bool Stimulator::create_scheduler(const unsigned char sync_msg, double frequency
     }
 
     if (is_enabled()) {
-        bool success = false;
-        for (size_t i = 0; i < m_num_ports; i++){
-            bool success = m_schedulers[i]->create_scheduler(*m_hComms[i], sync_msg, duration, m_delay_time);
-            if (!m_is_virtual){
-                ReadMessage scheduler_created_msg(read_message(*m_hComms[i], true));
-                if (scheduler_created_msg.is_valid()){
-                    m_schedulers[i]->set_id(scheduler_created_msg.get_data()[0]);
-                }
-                else{
-                    LOG(Error) << "Scheduler created return message (below) was either invalid or an error. Disabling stimulator.";
-                    print_message(scheduler_created_msg.get_message());
-                    disable();
-                    return false;
-                }
+        // place every event before anything is sent, so that channels which cannot fit are caught up front
+        if (!m_slots.allocate(m_channels, duration, m_slot_delays)) {
+            LOG(Error) << "The channels of " << m_name << " do not fit in a " << duration
+                       << " ms schedule period. Not creating scheduler";
+            return false;
+        }
+        m_period_us = milliseconds(duration).as_microseconds();
+
+        bool success = for_each_port([this, sync_msg, duration](size_t port) {
+            // a virtual UECU does not reply, so it is given time to set up instead
+            if (m_is_virtual) {
+                return m_schedulers[port]->create_scheduler(m_transport_ptrs[port], sync_msg, duration, m_delay_time);
             }
+
+            std::future<CommandResult> created =
+                m_schedulers[port]->create_scheduler(*m_commands[port], m_transport_ptrs[port], sync_msg, duration);
+            m_commands[port]->wait_all();
+            if (created.get().success) return true;
+            LOG(Error) << "Did not receive a valid scheduler created reply on " << m_com_ports[port] << ".";
+            return false;
+        });
+        if (!success) {
+            LOG(Error) << "Failed to create the scheduler. Disabling stimulator.";
+            disable();
         }
         return success;
     } else {
@@ -362,8 +492,11 @@ bool Stimulator::create_scheduler(const unsigned char sync_msg, double frequency
 
 bool Stimulator::add_event(Channel channel_, unsigned char event_type) {
     if (is_enabled()) {
-        bool success = m_schedulers[channel_.get_board_num()]->add_event(channel_, m_delay_time, event_type);
-        return success;
+        Scheduler*   scheduler = get_scheduler(channel_);
+        unsigned int delay;
+        if (!scheduler) return false;
+        if (get_slot_delay(channel_, delay)) return scheduler->add_event(channel_, delay, m_delay_time, m_is_virtual, event_type);
+        return scheduler->add_event(channel_, m_delay_time, m_is_virtual, event_type);
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not adding event to scheduler";
         return false;
@@ -373,18 +506,250 @@ bool Stimulator::add_event(Channel channel_, unsigned char event_type) {
 bool Stimulator::add_events(std::vector<Channel> channels_, unsigned char event_type) {
     if (is_enabled()) {
         for (size_t i = 0; i < channels_.size(); i++) {
-            // If any channel fails to add, return false after throwing an error
-            if (!add_event(channels_[i], event_type)) {
+            if (channels_[i].get_board_num() >= m_num_ports) {
+                LOG(Error) << "Channel " << channels_[i].get_channel_name() << " is on a board without a comport.";
                 return false;
-            };
+            }
         }
-        return true;
+        // each board creates its own events, so both boards are set up at the same time
+        return for_each_port([this, &channels_, event_type](size_t port) {
+            std::vector<Channel>      port_channels;
+            std::vector<unsigned int> port_delays;
+            bool                      planned = true;
+            for (size_t i = 0; i < channels_.size(); i++) {
+                if (channels_[i].get_board_num() != port) continue;
+                unsigned int delay = 0;
+                planned = get_slot_delay(channels_[i], delay) && planned;
+                port_channels.push_back(channels_[i]);
+                port_delays.push_back(delay);
+            }
+            // a real UECU gets every create message for the board at once and answers each in turn
+            if (!m_is_virtual && planned) return m_schedulers[port]->add_events(*m_commands[port], port_channels, port_delays, event_type);
+            if (!m_is_virtual) return m_schedulers[port]->add_events(*m_commands[port], port_channels, event_type);
+
+            for (size_t i = 0; i < port_channels.size(); i++) {
+                // If any channel fails to add, return false after throwing an error
+                if (!add_event(port_channels[i], event_type)) {
+                    return false;
+                }
+            }
+            return true;
+        });
     } else {
         LOG(Error) << "Stimulator has not yet been enabled. Not adding event to scheduler";
         return false;
     }
 }
 
+bool Stimulator::start_io_thread(ThreadSettings settings_) {
+    if (m_io_running) {
+        LOG(Warning) << "I/O thread is already running";
+        return true;
+    }
+    if (!begin_io()) return false;
+    m_io_stop   = false;
+    m_io_thread = std::thread(&Stimulator::io_loop, this, settings_);
+    return true;
+}
+
+void Stimulator::stop_io_thread() {
+    if (!m_io_running) return;
+    // a group drives the I/O of all of its stimulators from one thread, so that thread has to stop
+    if (m_group) {
+        m_group->stop_io_thread();
+        return;
+    }
+    m_io_stop = true;
+    if (m_io_thread.joinable()) m_io_thread.join();
+    end_io();
+}
+
+bool Stimulator::begin_io() {
+    if (!is_enabled()) {
+        LOG(Error) << "Stimulator has not yet been enabled. Not starting I/O thread";
+        return false;
+    }
+    // seed the mailbox with the current values so that untouched channels are not zeroed
+    for (size_t j = 0; j < m_num_ports; j++) {
+        const std::vector<Event>& events = m_schedulers[j]->get_events();
+        for (auto event = events.begin(); event != events.end(); event++) {
+            m_mailbox.post_amplitude(event->get_channel_num(), event->get_amplitude());
+            m_mailbox.post_pulsewidth(event->get_channel_num(), event->get_pulsewidth());
+        }
+    }
+    m_io_failed  = false;
+    m_io_running = true;
+    return true;
+}
+
+void Stimulator::end_io() {
+    // send anything posted after the thread's last cycle, then leave the values on the events
+    m_io_running = false;
+    m_group      = nullptr;
+    if (!m_io_failed && is_enabled()) service_io();
+}
+
+Time Stimulator::get_bring_up_time() { return m_bring_up_time; }
+
+bool Stimulator::is_io_thread_running() { return m_io_running; }
+
+bool Stimulator::pop_reply(ReadFrame& frame_) { return m_replies.pop(frame_); }
+
+size_t Stimulator::get_dropped_reply_count() { return m_dropped_replies; }
+
+void Stimulator::io_loop(ThreadSettings settings_) {
+    apply_current_thread_settings(settings_);
+    while (!m_io_stop) {
+        // the timer is restarted whenever set_frequency changes the period
+        Time  period = get_period();
+        Timer timer(period, Timer::WaitMode::Hybrid);
+        while (!m_io_stop && get_period() == period) {
+            if (!service_io() || !m_sync.resync_if_due()) {
+                m_io_failed = true;
+                return;
+            }
+            timer.wait();
+        }
+    }
+}
+
+bool Stimulator::service_io() {
+    // apply the latest posted commands to the events
+    uint32_t amp_pending = m_mailbox.take_amplitudes();
+    uint32_t pw_pending  = m_mailbox.take_pulsewidths();
+    uint32_t pending     = amp_pending | pw_pending;
+    for (unsigned char channel_num = 0; pending != 0; channel_num++, pending >>= 1) {
+        if (!(pending & 1)) continue;
+        uint32_t bit = uint32_t(1) << channel_num;
+        for (size_t j = 0; j < m_num_ports; j++) {
+            Event* event = m_schedulers[j]->get_event(channel_num);
+            if (!event) continue;
+            if (amp_pending & bit) event->set_amplitude(m_mailbox.get_amplitude(channel_num));
+            if (pw_pending & bit) event->set_pulsewidth(m_mailbox.get_pulsewidth(channel_num));
+            break;
+        }
+    }
+
+    // schedule changes are rare, and one the schedulers reject is logged and left out rather than
+    // stopping the thread. A new period places every event again, and delays posted with it are then
+    // applied on top of that
+    unsigned int period = m_mailbox.take_period();
+    if (period != 0) apply_period(period);
+    for (uint32_t delays = m_mailbox.take_delays(); delays != 0; delays &= delays - 1) {
+        unsigned char channel_num = (unsigned char)lowest_set_bit(delays);
+        for (size_t j = 0; j < m_num_ports; j++) {
+            Event* event = m_schedulers[j]->get_event(channel_num);
+            if (!event) continue;
+            m_schedulers[j]->change_event_delay(event->get_channel(), m_mailbox.get_delay(channel_num));
+            break;
+        }
+    }
+
+    return update_ports(true);
+}
+
+bool Stimulator::update_ports(bool queue_replies) {
+    // every board is written before any replies are read, so that the boards get their updates together
+    bool success = true;
+    for (size_t i = 0; i < m_num_ports; i++) {
+        int64_t start = m_latency_tracking ? LatencyHistogram::now() : 0;
+        if (!m_schedulers[i]->update()) success = false;
+        if (m_latency_tracking) m_port_ns[i] = LatencyHistogram::now() - start;
+    }
+
+    for (size_t i = 0; i < m_num_ports; i++) {
+        int64_t start = m_latency_tracking ? LatencyHistogram::now() : 0;
+        if (!receive_replies(i, queue_replies)) success = false;
+        if (m_latency_tracking) m_latency[i]->record(LatencyStage::Port, m_port_ns[i] + LatencyHistogram::now() - start);
+    }
+    return success;
+}
+
+bool Stimulator::receive_replies(size_t port, bool queue) {
+    // check every reply that has already arrived without waiting for more. A reply that is only
+    // partly in stays with the parser until the next cycle
+    bool      success = true;
+    ReadFrame frame;
+    while (m_transport_ptrs[port]->get_parser().poll(m_transport_ptrs[port], frame)) {
+        int64_t start = m_latency_tracking ? LatencyHistogram::now() : 0;
+        if (!frame.is_valid()) {
+            // the bytes go to the log as they are, and are only formatted (or dumped) off this thread
+            if (AsyncLog::get().allow(log_key(LogTopic::InvalidReply, (unsigned int)port))) {
+                AsyncLogLine(Error, log_key(LogTopic::InvalidReply, (unsigned int)port))
+                    << "Return message (below) either invalid or an error on " << m_com_ports[port] << ".";
+                AsyncLog::get().post_frame(Error, "Message", frame.get_bytes(), frame.get_size());
+            }
+            success = false;
+        } else if (queue && !m_replies.push(frame)) {
+            m_dropped_replies++;
+        }
+        if (m_latency_tracking) m_latency[port]->record(LatencyStage::Validate, LatencyHistogram::now() - start);
+    }
+    return success;
+}
+
+bool Stimulator::set_latency_tracking(bool enabled_) {
+    // the schedulers and parsers belong to the I/O thread while it runs
+    if (m_io_running) {
+        LOG(Error) << "Cannot change latency tracking of " << m_name << " while the I/O thread is running";
+        return false;
+    }
+    for (size_t i = 0; i < m_num_ports; i++) {
+        m_schedulers[i]->set_latency_recorder(enabled_ ? m_latency[i].get() : nullptr);
+        m_transport_ptrs[i]->get_parser().set_latency_recorder(enabled_ ? m_latency[i].get() : nullptr);
+    }
+    m_latency_tracking = enabled_;
+    return true;
+}
+
+bool Stimulator::is_latency_tracking() const { return m_latency_tracking; }
+
+bool Stimulator::get_latency_snapshot(size_t port_, LatencyRecorder::Snapshot& snapshot_, bool reset_) {
+    if (port_ >= m_num_ports) {
+        LOG(Error) << m_name << " does not have a port " << port_;
+        return false;
+    }
+    m_latency[port_]->take_snapshot(snapshot_, reset_);
+    return true;
+}
+
+void Stimulator::take_latency_snapshots(std::vector<LatencyRecorder::Snapshot>& snapshots, bool reset) {
+    snapshots.resize(m_num_ports);
+    for (size_t i = 0; i < m_num_ports; i++) m_latency[i]->take_snapshot(snapshots[i], reset);
+}
+
+bool Stimulator::write_latency_csv(const std::string& filename_, bool reset_) {
+    std::ofstream file(filename_);
+    if (!file) {
+        LOG(Error) << "Could not open " << filename_ << " to write latencies";
+        return false;
+    }
+    std::vector<LatencyRecorder::Snapshot> snapshots;
+    take_latency_snapshots(snapshots, reset_);
+    LatencyRecorder::write_csv_header(file);
+    for (size_t i = 0; i < m_num_ports; i++) LatencyRecorder::write_csv(file, m_com_ports[i], snapshots[i]);
+    return file.good();
+}
+
+bool Stimulator::write_latency_json(const std::string& filename_, bool reset_) {
+    std::ofstream file(filename_);
+    if (!file) {
+        LOG(Error) << "Could not open " << filename_ << " to write latencies";
+        return false;
+    }
+    std::vector<LatencyRecorder::Snapshot> snapshots;
+    take_latency_snapshots(snapshots, reset_);
+    file << "{\"name\":\"" << m_name << "\",\"ports\":[";
+    for (size_t i = 0; i < m_num_ports; i++) {
+        if (i > 0) file << ',';
+        file << "{\"port\":\"" << m_com_ports[i] << "\",\"stages\":";
+        LatencyRecorder::write_json(file, snapshots[i]);
+        file << '}';
+    }
+    file << "]}\n";
+    return file.good();
+}
+
 std::vector<Channel> Stimulator::get_channels() { return m_channels; }
 
 bool Stimulator::is_enabled() { return m_enabled; }
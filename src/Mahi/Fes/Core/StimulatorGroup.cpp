@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/StimulatorGroup.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+StimulatorGroup::StimulatorGroup(const std::string& name_) :
+    m_name(name_),
+    m_period(Time::Zero),
+    m_io_stop(false),
+    m_io_running(false),
+    m_io_failed(false) {}
+
+StimulatorGroup::~StimulatorGroup() { stop_io_thread(); }
+
+bool StimulatorGroup::add(Stimulator* stimulator_) {
+    if (m_io_running) {
+        LOG(Error) << "Cannot add a stimulator to " << m_name << " while its I/O thread is running.";
+        return false;
+    }
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        if (m_stimulators[i] == stimulator_) {
+            LOG(Warning) << stimulator_->get_name() << " is already in " << m_name << ".";
+            return true;
+        }
+    }
+    m_stimulators.push_back(stimulator_);
+    return true;
+}
+
+size_t StimulatorGroup::size() const { return m_stimulators.size(); }
+
+Stimulator* StimulatorGroup::get(size_t i) const { return m_stimulators[i]; }
+
+bool StimulatorGroup::create_scheduler(const unsigned char sync_msg, double frequency_) {
+    bool success = true;
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        if (!m_stimulators[i]->create_scheduler(sync_msg, frequency_)) success = false;
+    }
+    return success;
+}
+
+bool StimulatorGroup::begin() {
+    m_sync.clear();
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        Stimulator* stim = m_stimulators[i];
+        if (!stim->is_enabled()) {
+            LOG(Error) << stim->get_name() << " has not yet been opened. Not starting " << m_name;
+            return false;
+        }
+        for (size_t port = 0; port < stim->m_num_ports; port++) {
+            m_sync.add(stim->m_schedulers[port].get());
+        }
+    }
+    bool success = m_sync.release();
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        m_stimulators[i]->finish_bring_up(m_sync.get_last_skew());
+    }
+    return success;
+}
+
+void StimulatorGroup::set_max_sync_skew(Time max_skew_, int max_attempts_) { m_sync.set_max_skew(max_skew_, max_attempts_); }
+
+void StimulatorGroup::set_resync_interval(Time interval_) { m_sync.set_resync_interval(interval_); }
+
+Time StimulatorGroup::get_sync_skew() const { return m_sync.get_last_skew(); }
+
+Time StimulatorGroup::get_max_sync_skew() const { return m_sync.get_worst_skew(); }
+
+bool StimulatorGroup::update() {
+    if (m_io_running) {
+        if (m_io_failed) {
+            LOG(Error) << "I/O thread of " << m_name << " failed. Disabling every stimulator.";
+            disable();
+            return false;
+        }
+        return true;
+    }
+    bool success = true;
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        if (!m_stimulators[i]->update()) success = false;
+    }
+    if (!m_sync.resync_if_due()) success = false;
+    return success;
+}
+
+bool StimulatorGroup::start_io_thread(ThreadSettings settings_) {
+    if (m_io_running) {
+        LOG(Warning) << "I/O thread of " << m_name << " is already running";
+        return true;
+    }
+    if (m_stimulators.empty()) {
+        LOG(Error) << m_name << " has no stimulators. Not starting its I/O thread";
+        return false;
+    }
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        if (m_stimulators[i]->is_io_thread_running()) {
+            LOG(Error) << m_stimulators[i]->get_name() << " already has an I/O thread. Not starting the I/O thread of " << m_name;
+            return false;
+        }
+    }
+
+    m_poller.clear();
+    m_port_owners.clear();
+    m_port_numbers.clear();
+    m_period = Time::Zero;
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        Stimulator* stim = m_stimulators[i];
+        if (!stim->begin_io()) {
+            for (size_t j = 0; j < i; j++) m_stimulators[j]->end_io();
+            return false;
+        }
+        stim->m_group = this;
+        for (size_t port = 0; port < stim->m_num_ports; port++) {
+            m_poller.add(stim->m_transport_ptrs[port]);
+            m_port_owners.push_back(i);
+            m_port_numbers.push_back(port);
+        }
+        if (m_period == Time::Zero || stim->get_period() < m_period) m_period = stim->get_period();
+    }
+    m_ready.reserve(m_poller.size());
+
+    m_io_stop    = false;
+    m_io_failed  = false;
+    m_io_running = true;
+    m_io_thread  = std::thread(&StimulatorGroup::io_loop, this, settings_);
+    return true;
+}
+
+void StimulatorGroup::stop_io_thread() {
+    if (!m_io_running) return;
+    m_io_stop = true;
+    if (m_io_thread.joinable()) m_io_thread.join();
+    m_io_running = false;
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        m_stimulators[i]->end_io();
+    }
+}
+
+bool StimulatorGroup::is_io_thread_running() const { return m_io_running; }
+
+void StimulatorGroup::disable() {
+    stop_io_thread();
+    for (size_t i = 0; i < m_stimulators.size(); i++) {
+        m_stimulators[i]->disable();
+    }
+}
+
+std::string StimulatorGroup::get_name() const { return m_name; }
+
+void StimulatorGroup::io_loop(ThreadSettings settings_) {
+    apply_current_thread_settings(settings_);
+    Clock clock;
+    Time  next_tick = Time::Zero;
+    while (!m_io_stop) {
+        // every board of every stimulator is updated from the same tick
+        for (size_t i = 0; i < m_stimulators.size(); i++) {
+            if (!m_stimulators[i]->service_io()) {
+                m_stimulators[i]->m_io_failed = true;
+                m_io_failed                   = true;
+                return;
+            }
+        }
+        if (!m_sync.resync_if_due()) {
+            m_io_failed = true;
+            return;
+        }
+
+        // a stimulator may have changed its frequency during the tick
+        m_period = m_stimulators[0]->get_period();
+        for (size_t i = 1; i < m_stimulators.size(); i++) {
+            if (m_stimulators[i]->get_period() < m_period) m_period = m_stimulators[i]->get_period();
+        }
+        next_tick += m_period;
+        // skip the ticks that were missed rather than sending several updates back to back
+        if (clock.get_elapsed_time() > next_tick) next_tick = clock.get_elapsed_time();
+
+        // until the next tick, sleep on all of the ports at once and queue replies as they arrive. The
+        // wait is in whole milliseconds, so the last millisecond is spent checking without blocking
+        while (!m_io_stop) {
+            Time remaining = next_tick - clock.get_elapsed_time();
+            if (remaining <= Time::Zero) break;
+            m_poller.wait(remaining > milliseconds(1) ? remaining - milliseconds(1) : Time::Zero, m_ready);
+            for (size_t i = 0; i < m_ready.size(); i++) {
+                Stimulator* stim = m_stimulators[m_port_owners[m_ready[i]]];
+                if (!stim->receive_replies(m_port_numbers[m_ready[i]])) {
+                    stim->m_io_failed = true;
+                    m_io_failed       = true;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,118 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/SyncCoordinator.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+SyncCoordinator::SyncCoordinator() : m_last_skew_us(0), m_worst_skew_us(0), m_release_count(0), m_release_time_ns(0) {}
+
+void SyncCoordinator::add(Scheduler* scheduler_) {
+    m_schedulers.push_back(scheduler_);
+    m_frames.resize(m_schedulers.size());
+}
+
+void SyncCoordinator::clear() {
+    m_schedulers.clear();
+    m_frames.clear();
+}
+
+size_t SyncCoordinator::size() const { return m_schedulers.size(); }
+
+void SyncCoordinator::set_max_skew(Time max_skew_, int max_attempts_) {
+    m_max_skew     = max_skew_;
+    m_max_attempts = max_attempts_ > 0 ? max_attempts_ : 1;
+}
+
+void SyncCoordinator::set_resync_interval(Time interval_) { m_resync_interval = interval_; }
+
+bool SyncCoordinator::release() {
+    if (m_schedulers.empty()) return false;
+
+    // build every message first so that nothing but the writes happens between the boards starting
+    for (size_t i = 0; i < m_schedulers.size(); i++) {
+        if (!m_schedulers[i]->is_enabled()) {
+            LOG(Error) << "Scheduler is not yet enabled";
+            return false;
+        }
+        m_schedulers[i]->encode_sync(m_frames[i]);
+    }
+
+    Time                                  skew = Time::Zero;
+    std::chrono::steady_clock::time_point released;
+    for (int attempt = 1; attempt <= m_max_attempts; attempt++) {
+        // a write only hands the bytes to the driver, so each port is drained before the next is written
+        // and each board is timed from when its message had actually left. Draining them all after
+        // back to back writes would time every port no earlier than the one before it, whatever order
+        // the bytes really left in
+        Clock clock;
+        Time  first_sent = Time::Zero;
+        Time  last_sent  = Time::Zero;
+        for (size_t i = 0; i < m_schedulers.size(); i++) {
+            Transport* transport = m_schedulers[i]->get_transport();
+            if (!transport->write(m_frames[i].get_bytes(), m_frames[i].get_size())) {
+                LOG(Error) << "Error Sending Sync Message";
+                m_schedulers[i]->disable();
+                return false;
+            }
+            if (!transport->drain()) {
+                LOG(Warning) << "Could not wait for the sync message to leave " << transport->get_port_name()
+                             << ", so the skew may be larger than measured.";
+            }
+            Time sent = clock.get_elapsed_time();
+            if (i == 0) {
+                released   = std::chrono::steady_clock::now();
+                first_sent = sent;
+            }
+            last_sent = sent;
+        }
+        skew = last_sent - first_sent;
+        // sending sync again restarts every schedule, so a late board is brought back in line with the rest
+        if (m_max_skew == Time::Zero || skew <= m_max_skew) break;
+        if (attempt == m_max_attempts) {
+            LOG(Warning) << "Boards started " << skew.as_microseconds() << " us apart, more than the "
+                         << m_max_skew.as_microseconds() << " us allowed.";
+        }
+    }
+
+    m_release_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(released.time_since_epoch()).count();
+    m_last_skew_us    = skew.as_microseconds();
+    if (m_last_skew_us > m_worst_skew_us) m_worst_skew_us = m_last_skew_us.load();
+    m_release_count++;
+    m_resync_clock.restart();
+    return true;
+}
+
+bool SyncCoordinator::resync_if_due() {
+    if (m_resync_interval == Time::Zero || m_resync_clock.get_elapsed_time() < m_resync_interval) return true;
+    return release();
+}
+
+Time SyncCoordinator::get_last_skew() const { return microseconds(m_last_skew_us); }
+
+Time SyncCoordinator::get_worst_skew() const { return microseconds(m_worst_skew_us); }
+
+size_t SyncCoordinator::get_release_count() const { return m_release_count; }
+
+std::chrono::steady_clock::time_point SyncCoordinator::get_release_time() const {
+    return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(m_release_time_ns));
+}
+
+}  // namespace fes
+}  // namespace mahi
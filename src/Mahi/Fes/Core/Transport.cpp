@@ -0,0 +1,57 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Core/FrameParser.hpp>
+#include <Mahi/Fes/Core/Transport.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+Transport::Transport(const std::string& port_name_) : m_port_name(port_name_), m_parser(new FrameParser()) {}
+
+Transport::~Transport() {}
+
+unsigned int Transport::get_baud_rate() { return 9600; }
+
+int Transport::get_poll_fd() { return -1; }
+
+bool Transport::drain() { return true; }
+
+size_t Transport::read_exact(unsigned char* data, size_t size, Time timeout) {
+    size_t bytes_read = 0;
+    Clock  timeout_clock;
+    while (bytes_read < size) {
+        // once the timeout has passed, keep taking bytes that are already buffered but do not
+        // wait for more. This also makes a zero timeout a non-blocking read
+        Time remaining = timeout - timeout_clock.get_elapsed_time();
+        if (remaining < Time::Zero) remaining = Time::Zero;
+        int result = read(data + bytes_read, size - bytes_read, remaining);
+        if (result < 0) break;
+        // a zero-length read means the full timeout elapsed without any new bytes
+        if (result == 0) break;
+        bytes_read += (size_t)result;
+    }
+    return bytes_read;
+}
+
+std::string Transport::get_port_name() { return m_port_name; }
+
+FrameParser& Transport::get_parser() { return *m_parser; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -43,15 +43,12 @@ unsigned char WriteMessage::calc_checksum() {
 
 unsigned char WriteMessage::get_checksum() { return m_checksum; }
 
-bool WriteMessage::write(HANDLE hComm, const std::string& activity) {
+bool WriteMessage::write(Transport* transport, const std::string& activity) {
     // dont log anything if the input string is "NONE"
     bool log_message = (activity.compare("NONE") != 0);
 
-    // Captures how many bits were written
-    DWORD dwBytesWritten = 0;
-
-    // write the file if possible
-    if (!WriteFile(hComm, get_message_pointer(), (DWORD)m_size, &dwBytesWritten, NULL)) {
+    // write the message if possible
+    if (!transport->write(get_message_pointer(), m_size)) {
         // log that the activity was successful or unsuccessful
         if (log_message) {
             LOG(Error) << "Error " << activity;
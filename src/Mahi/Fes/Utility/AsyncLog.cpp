@@ -0,0 +1,247 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+}  // namespace
+
+AsyncLog& AsyncLog::get() {
+    static AsyncLog log;
+    return log;
+}
+
+AsyncLog::AsyncLog() :
+    m_posted(0),
+    m_written(0),
+    m_dropped(0),
+    m_dropped_reported(0),
+    m_rate_limit_ns(1000000000),
+    m_dump(nullptr),
+    m_stop(false) {
+    for (size_t i = 0; i < RATE_KEYS; i++) {
+        m_last_ns[i].store(0, std::memory_order_relaxed);
+        m_suppressed[i].store(0, std::memory_order_relaxed);
+    }
+    m_thread = std::thread(&AsyncLog::drain_loop, this);
+}
+
+AsyncLog::~AsyncLog() {
+    m_stop = true;
+    if (m_thread.joinable()) m_thread.join();
+    set_frame_dump("");
+}
+
+bool AsyncLog::post(const LogRecord& record) {
+    if (!m_ring.push(record)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_posted.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+bool AsyncLog::post_frame(Severity severity, const char* label, const unsigned char* bytes, size_t size) {
+    LogRecord record;
+    record.time_ns   = now_ns();
+    record.severity  = (unsigned char)severity;
+    record.kind      = LogRecord::Frame;
+    record.text_size = (unsigned short)std::min(std::strlen(label), LogRecord::TEXT_SIZE);
+    record.data_size = (unsigned short)std::min(size, LogRecord::DATA_SIZE);
+    std::memcpy(record.text, label, record.text_size);
+    if (record.data_size > 0) std::memcpy(record.data, bytes, record.data_size);
+    return post(record);
+}
+
+bool AsyncLog::allow(size_t key) {
+    if (key >= RATE_KEYS) return true;
+    int64_t now  = now_ns();
+    int64_t last = m_last_ns[key].load(std::memory_order_relaxed);
+    // of several threads racing past the interval only the one that moves the time on goes out
+    if ((last != 0 && now - last < m_rate_limit_ns.load(std::memory_order_relaxed)) ||
+        !m_last_ns[key].compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        m_suppressed[key].fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+uint32_t AsyncLog::take_suppressed(size_t key) {
+    return key < RATE_KEYS ? m_suppressed[key].exchange(0, std::memory_order_relaxed) : 0;
+}
+
+void AsyncLog::set_rate_limit(Time interval_) { m_rate_limit_ns = interval_.as_microseconds() * 1000; }
+
+bool AsyncLog::set_frame_dump(const std::string& filename_) {
+    std::lock_guard<std::mutex> lock(m_dump_mtx);
+    if (m_dump) {
+        std::fclose(m_dump);
+        m_dump = nullptr;
+    }
+    if (filename_.empty()) return true;
+    m_dump = std::fopen(filename_.c_str(), "wb");
+    if (!m_dump) {
+        LOG(Error) << "Could not open " << filename_ << " to dump frames";
+        return false;
+    }
+    return true;
+}
+
+void AsyncLog::flush() {
+    size_t posted = m_posted.load(std::memory_order_acquire);
+    while (m_written.load(std::memory_order_acquire) < posted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+size_t AsyncLog::get_dropped_count() const { return m_dropped.load(std::memory_order_relaxed); }
+
+void AsyncLog::drain_loop() {
+    LogRecord record;
+    while (true) {
+        bool stopping = m_stop.load();
+        bool drained  = false;
+        while (m_ring.pop(record)) {
+            write(record);
+            m_written.fetch_add(1, std::memory_order_release);
+            drained = true;
+        }
+        size_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_dropped_reported.load(std::memory_order_relaxed)) {
+            LOG(Warning) << dropped - m_dropped_reported.load(std::memory_order_relaxed)
+                         << " log messages were dropped because the log was not keeping up.";
+            m_dropped_reported = dropped;
+        }
+        // once asked to stop, exit only after a pass that found the ring empty
+        if (stopping && !drained) return;
+        if (!drained) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void AsyncLog::write(const LogRecord& record) {
+    std::string text(record.text, record.text_size);
+    if (record.kind == LogRecord::Frame) {
+        std::lock_guard<std::mutex> lock(m_dump_mtx);
+        if (m_dump) {
+            unsigned char label_size = (unsigned char)std::min(record.text_size, (unsigned short)255);
+            unsigned char data_size  = (unsigned char)record.data_size;
+            std::fwrite(&record.time_ns, sizeof(record.time_ns), 1, m_dump);
+            std::fwrite(&label_size, 1, 1, m_dump);
+            std::fwrite(record.text, 1, label_size, m_dump);
+            std::fwrite(&data_size, 1, 1, m_dump);
+            std::fwrite(record.data, 1, data_size, m_dump);
+            return;
+        }
+        text += ":";
+        for (size_t i = 0; i < record.data_size; i++) {
+            char hex[] = {' ', '0', 'x', HEX_DIGITS[record.data[i] >> 4], HEX_DIGITS[record.data[i] & 0x0F], ','};
+            text.append(hex, i + 1 < record.data_size ? 6 : 5);
+        }
+    }
+    switch ((Severity)record.severity) {
+        case Fatal: LOG(Fatal) << text; break;
+        case Error: LOG(Error) << text; break;
+        case Warning: LOG(Warning) << text; break;
+        case Info: LOG(Info) << text; break;
+        case Verbose: LOG(Verbose) << text; break;
+        default: LOG(Debug) << text; break;
+    }
+}
+
+AsyncLogLine::AsyncLogLine(Severity severity, size_t key) : m_key(key) {
+    m_record.time_ns   = now_ns();
+    m_record.severity  = (unsigned char)severity;
+    m_record.kind      = LogRecord::Text;
+    m_record.text_size = 0;
+    m_record.data_size = 0;
+}
+
+AsyncLogLine::~AsyncLogLine() {
+    if (m_key != NO_KEY) {
+        uint32_t suppressed = AsyncLog::get().take_suppressed(m_key);
+        if (suppressed > 0) *this << " (" << (unsigned int)suppressed << " like it suppressed)";
+    }
+    AsyncLog::get().post(m_record);
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(const char* text) {
+    append(text, std::strlen(text));
+    return *this;
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(const std::string& text) {
+    append(text.data(), text.size());
+    return *this;
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(char c) {
+    append(&c, 1);
+    return *this;
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(int value) { return *this << (long long)value; }
+
+AsyncLogLine& AsyncLogLine::operator<<(unsigned int value) { return *this << (unsigned long long)value; }
+
+AsyncLogLine& AsyncLogLine::operator<<(long value) { return *this << (long long)value; }
+
+AsyncLogLine& AsyncLogLine::operator<<(unsigned long value) { return *this << (unsigned long long)value; }
+
+AsyncLogLine& AsyncLogLine::operator<<(long long value) {
+    char buffer[24];
+    int  size = std::snprintf(buffer, sizeof(buffer), "%lld", value);
+    append(buffer, (size_t)size);
+    return *this;
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(unsigned long long value) {
+    char buffer[24];
+    int  size = std::snprintf(buffer, sizeof(buffer), "%llu", value);
+    append(buffer, (size_t)size);
+    return *this;
+}
+
+AsyncLogLine& AsyncLogLine::operator<<(double value) {
+    char buffer[32];
+    int  size = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    append(buffer, (size_t)size);
+    return *this;
+}
+
+void AsyncLogLine::append(const char* text, size_t size) {
+    size_t room = LogRecord::TEXT_SIZE - m_record.text_size;
+    if (size > room) size = room;
+    std::memcpy(m_record.text + m_record.text_size, text, size);
+    m_record.text_size = (unsigned short)(m_record.text_size + size);
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -1,18 +1,19 @@
 // #include <Mahi/Fes/Core/ReadMessage.hpp>
 #include <Mahi/Fes/Utility/Communication.hpp>
 #include <Mahi/Util.hpp>
+#include <memory>
 
 using namespace mahi::util;
 
 namespace mahi {
 namespace fes {
-std::vector<ReadMessage> get_all_messages(std::vector<HANDLE*> hComms, size_t num_ports) {
+std::vector<ReadMessage> get_all_messages(const std::vector<Transport*>& transports, size_t num_ports) {
     std::vector<ReadMessage> incoming_messages;
     for (size_t i = 0; i < num_ports; i++)
     {
         // while there are still messages, continue to read them
         while (true) {
-            std::vector<unsigned char> inc_message = read_message(*hComms[i], false);
+            std::vector<unsigned char> inc_message = read_message(transports[i], false);
             // if there was no recent message, exit.
             if (inc_message.empty()){
                 break;
@@ -25,7 +26,19 @@ std::vector<ReadMessage> get_all_messages(std::vector<HANDLE*> hComms, size_t nu
     return incoming_messages;
 }
 
-void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages) {
+std::vector<ReadMessage> get_all_messages(const std::vector<Transport*>& transports, std::vector<FrameParser>& parsers,
+                                          size_t num_ports) {
+    std::vector<ReadMessage> incoming_messages;
+    ReadFrame                frame;
+    for (size_t i = 0; i < num_ports; i++) {
+        while (parsers[i].poll(transports[i], frame)) {
+            incoming_messages.push_back(ReadMessage(frame));
+        }
+    }
+    return incoming_messages;
+}
+
+void process_inc_messages(Transport* transport, std::queue<ReadMessage> &inc_messages) {
     for (size_t i = 0; i < inc_messages.size(); i++) {
         ReadMessage current_message = inc_messages.front();
         inc_messages.pop();
@@ -33,49 +46,50 @@ void process_inc_messages(HANDLE hComm, std::queue<ReadMessage> &inc_messages) {
     }
 }
 
-std::vector<unsigned char> read_message(HANDLE hComm, bool should_wait, Time timeout) {
-    DWORD         header_size = 8;
-    unsigned char msg_header[8];
-    DWORD         dwBytesRead = 0;
+std::vector<unsigned char> read_message(Transport* transport, bool should_wait, Time timeout) {
+    FrameParser& parser    = transport->get_parser();
+    size_t       discarded = parser.get_discarded_count();
+    ReadFrame    frame;
 
-    bool  message_received = false;
-    Clock timeout_clock;
-
-    std::vector<unsigned char> msg;
+    bool message_received = parser.poll(transport, frame, should_wait ? timeout : Time::Zero);
+    // a message that has already started should be finished even if we are not waiting for one
+    if (!message_received && !should_wait && (parser.in_frame() || parser.bytes_needed() < READ_HEADER_SIZE)) {
+        message_received = parser.poll(transport, frame, timeout);
+    }
+    if (parser.get_discarded_count() > discarded) {
+        LOG(Warning) << "Skipped " << parser.get_discarded_count() - discarded << " bytes that were not part of a valid message.";
+    }
+    if (!message_received) {
+        if (should_wait) {
+            LOG(Error) << "Ran into timeout when waiting to receive a message. Returning empty message instead.";
+        }
+        return std::vector<unsigned char>();
+    }
+    return std::vector<unsigned char>(frame.get_bytes(), frame.get_bytes() + frame.get_size());
+}
 
-    while (!message_received && ((timeout_clock.get_elapsed_time() < timeout) && should_wait)) {
-        if (!ReadFile(hComm, msg_header, header_size, &dwBytesRead, NULL)) {
-            LOG(Error) << "Could not read message header. Returning empty vector.";
-        } else if (dwBytesRead != 0) {
-            DWORD body_size = (unsigned int)msg_header[7] + 2;
+bool read_frame(Transport* transport, ReadFrame& frame, Time timeout) {
+    return transport->get_parser().poll(transport, frame, timeout);
+}
 
-            std::unique_ptr<unsigned char[]> msg_body(new unsigned char[body_size]);
-            if (!ReadFile(hComm, msg_body.get(), body_size, &dwBytesRead, NULL)) {
-                LOG(Error) << "Could not read message body. Returning empty vector.";
-            } else {
-                if (msg_header[4] == (unsigned char)0x80 && msg_header[5] == (unsigned char)0x04) {
-                    for (unsigned int i = 0; i < (header_size + body_size); i++) {
-                        if (i < header_size) {
-                            msg.push_back(msg_header[i]);
-                        } else {
-                            msg.push_back(msg_body[i - header_size]);
-                        }
-                    }
-                    message_received = true;
-                } else {
-                    LOG(Error) << "Invalid Message Header Received: ";
-                    std::vector<unsigned char> msg_header_vec(std::begin(msg_header), std::end(msg_header));
-                    print_message(msg_header_vec);
-                    return msg_header_vec;
-                }
-            }
+bool wait_for_reply(Transport* transport, unsigned char msg_type, ReadFrame& frame, Time timeout) {
+    FrameParser& parser = transport->get_parser();
+    Clock        clock;
+    while (true) {
+        Time remaining = timeout - clock.get_elapsed_time();
+        if (!parser.poll(transport, frame, remaining > Time::Zero ? remaining : Time::Zero)) {
+            LOG(Error) << "Ran into timeout when waiting for reply " << print_as_hex(msg_type) << ".";
+            return false;
         }
+        if (frame.get_type() == msg_type) return true;
+        if (frame.get_type() == ERROR_REPORT_MSG) {
+            LOG(Error) << "Received an error report (below) when waiting for reply " << print_as_hex(msg_type) << ".";
+            print_message(std::vector<unsigned char>(frame.get_bytes(), frame.get_bytes() + frame.get_size()));
+            return false;
+        }
+        LOG(Warning) << "Skipped reply " << print_as_hex(frame.get_type()) << " when waiting for reply "
+                     << print_as_hex(msg_type) << ".";
     }
-    if (!message_received && should_wait) {
-        LOG(Error) << "Ran into timeout when waiting to receive a message. Returning empty message instead.";
-    }
-    // print_message(msg);
-    return msg;
 }
 
 }  // namespace fes
@@ -0,0 +1,489 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Core/Frame.hpp>
+#include <Mahi/Fes/Utility/Emulator.hpp>
+#include <Mahi/Fes/Utility/Utility.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+// error codes sent back in ERROR_REPORT_MSG replies
+const unsigned char EMU_ERR_CHECKSUM    = 0x01;  // message checksum did not match
+const unsigned char EMU_ERR_UNKNOWN_MSG = 0x02;  // message type is not supported
+const unsigned char EMU_ERR_BAD_LENGTH  = 0x03;  // message length does not match its type
+const unsigned char EMU_ERR_BAD_ID      = 0x04;  // schedule or event id does not exist
+
+/// returns the required data length for a message type, or -1 if the type is not supported
+int expected_length(unsigned char msg_type) {
+    switch (msg_type) {
+        case CHANNEL_SETUP_MSG: return CH_SET_LEN;
+        case CREATE_SCHEDULE_MSG: return CREATE_SCHED_LEN;
+        case CREATE_EVENT_MSG: return CR_EVT_LEN;
+        case CHANGE_EVENT_PARAMS_MSG: return CHANGE_EVENT_PARAMS_LEN;
+        case CHANGE_SCHEDULE_MSG: return CHANGE_SCHED_LEN;
+        case CHANGE_EVENT_SCHED_MSG: return CHANGE_EVENT_SCHED_LEN;
+        case SYNC_MSG: return SYNC_MSG_LEN;
+        case HALT_MSG: return HALT_LEN;
+        case DELETE_SCHEDULE_MSG: return DEL_SCHED_LEN;
+        case DELETE_EVENT_MSG: return DELETE_EVENT_LEN;
+        default: return -1;
+    }
+}
+}  // namespace
+
+Emulator::Emulator() : m_running(false) {}
+
+Emulator::~Emulator() { close(); }
+
+bool Emulator::open() {
+    m_master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_master_fd < 0 || grantpt(m_master_fd) != 0 || unlockpt(m_master_fd) != 0) {
+        LOG(Error) << "Failed to create pseudo-terminal for the emulator";
+        close();
+        return false;
+    }
+    m_port_name = ptsname(m_master_fd);
+
+    // raw mode so that nothing the host writes is echoed back or translated
+    struct termios settings;
+    if (tcgetattr(m_master_fd, &settings) == 0) {
+        cfmakeraw(&settings);
+        tcsetattr(m_master_fd, TCSANOW, &settings);
+    }
+
+    LOG(Info) << "Opened UECU emulator on " << m_port_name;
+    return true;
+}
+
+void Emulator::close() {
+    stop();
+    if (m_master_fd >= 0) {
+        ::close(m_master_fd);
+        m_master_fd = -1;
+    }
+}
+
+std::string Emulator::get_port_name() { return m_port_name; }
+
+void Emulator::start(double time_scale_) {
+    stop();
+    m_time_scale = time_scale_;
+    m_running    = true;
+    m_thread     = std::thread(&Emulator::run, this);
+}
+
+void Emulator::stop() {
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void Emulator::run() {
+    Clock clock;
+    Time  last = clock.get_elapsed_time();
+    while (m_running) {
+        struct pollfd pfd;
+        pfd.fd      = m_master_fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        // wake at least every millisecond so simulated time keeps moving while idle
+        poll(&pfd, 1, 1);
+        service();
+        Time now = clock.get_elapsed_time();
+        advance((now - last) * m_time_scale);
+        last = now;
+    }
+}
+
+size_t Emulator::service() {
+    if (m_master_fd < 0) return 0;
+    size_t        handled_before = get_message_count() + get_error_count();
+    unsigned char buffer[256];
+    while (true) {
+        ssize_t result = ::read(m_master_fd, buffer, sizeof(buffer));
+        if (result > 0) {
+            feed(buffer, (size_t)result);
+        } else if (result < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // EAGAIN (nothing waiting) or EIO (slave side not open yet)
+            break;
+        }
+    }
+    return get_message_count() + get_error_count() - handled_before;
+}
+
+void Emulator::feed(const unsigned char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_rx_buffer.insert(m_rx_buffer.end(), data, data + size);
+
+    size_t pos = 0;
+    while (true) {
+        // skip anything that cannot be the start of a message
+        while (pos + 1 < m_rx_buffer.size() &&
+               !(m_rx_buffer[pos] == DEST_ADR && m_rx_buffer[pos + 1] == SRC_ADR)) {
+            pos++;
+        }
+        if (m_rx_buffer.size() - pos < 4) break;
+        size_t total = 4 + (size_t)m_rx_buffer[pos + 3] + 1;
+        if (m_rx_buffer.size() - pos < total) break;
+
+        std::vector<unsigned char> msg(m_rx_buffer.begin() + pos, m_rx_buffer.begin() + pos + total);
+        if (calc_checksum(&msg[0], total - 1) != msg[total - 1]) {
+            m_error_count++;
+            send_error(EMU_ERR_CHECKSUM, msg[2]);
+            // the header may have been noise, so resync one byte later
+            pos++;
+            continue;
+        }
+        handle_message(&msg[0], total);
+        pos += total;
+    }
+    m_rx_buffer.erase(m_rx_buffer.begin(), m_rx_buffer.begin() + pos);
+}
+
+void Emulator::handle_message(const unsigned char* msg, size_t size) {
+    unsigned char        msg_type = msg[2];
+    unsigned char        msg_len  = msg[3];
+    const unsigned char* data     = msg + 4;
+
+    int length = expected_length(msg_type);
+    if (length < 0) {
+        m_error_count++;
+        send_error(EMU_ERR_UNKNOWN_MSG, msg_type);
+        return;
+    } else if (length != msg_len) {
+        m_error_count++;
+        send_error(EMU_ERR_BAD_LENGTH, msg_type);
+        return;
+    }
+    m_msg_count++;
+
+    switch (msg_type) {
+        case CHANNEL_SETUP_MSG: {
+            ChannelState& channel = m_channels[data[0] & 0x03];
+            channel.setup         = true;
+            channel.amp_limit     = data[1];
+            channel.pw_limit      = data[2];
+            break;
+        }
+        case CREATE_SCHEDULE_MSG: {
+            unsigned char schedule_id = m_next_schedule_id++;
+            ScheduleState schedule;
+            schedule.sync_char       = data[0];
+            schedule.duration        = milliseconds(data[1] * 256 + data[2]);
+            m_schedules[schedule_id] = schedule;
+            send_reply(CREATE_SCHEDULE_REPLY_MSG, {schedule_id});
+            break;
+        }
+        case CREATE_EVENT_MSG: {
+            auto schedule = m_schedules.find(data[0]);
+            if (schedule == m_schedules.end()) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+                break;
+            }
+            unsigned char event_id = m_next_event_id++;
+            EventState    event;
+            event.schedule_id   = data[0];
+            event.delay         = milliseconds(data[1] * 256 + data[2]);
+            event.priority      = data[3];
+            event.event_type    = data[4];
+            event.board_channel = data[5] & 0x03;
+            event.pulse_width   = data[6];
+            event.amplitude     = data[7];
+            arm_event(event, schedule->second);
+            m_events[event_id] = event;
+            send_reply(CREATE_EVENT_REPLY_MSG, {event_id, data[0], data[4], data[5]});
+            break;
+        }
+        case CHANGE_EVENT_PARAMS_MSG: {
+            auto event = m_events.find(data[0]);
+            if (event == m_events.end()) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+                break;
+            }
+            event->second.pulse_width = data[1];
+            event->second.amplitude   = data[2];
+            event->second.pending     = true;
+            event->second.changed_at  = m_sim_time;
+            break;
+        }
+        case CHANGE_SCHEDULE_MSG: {
+            auto schedule = m_schedules.find(data[0]);
+            if (schedule == m_schedules.end()) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+                break;
+            }
+            ScheduleState& state = schedule->second;
+            state.sync_char     = data[1];
+            state.next_duration = milliseconds(data[2] * 256 + data[3]);
+            if (state.running && state.duration > Time::Zero && m_sim_time > state.start) {
+                // the period in progress finishes at the old length, and advance switches at its end
+                int64_t elapsed = (m_sim_time - state.start).as_microseconds();
+                int64_t period  = state.duration.as_microseconds();
+                if (elapsed % period != 0) {
+                    state.switching = true;
+                    state.switch_at = state.start + microseconds((elapsed / period + 1) * period);
+                    break;
+                }
+            }
+            // no period is in progress, so the new one starts now
+            switch_period(schedule->first, state, state.running && m_sim_time > state.start ? m_sim_time : state.start);
+            break;
+        }
+        case CHANGE_EVENT_SCHED_MSG: {
+            auto event    = m_events.find(data[0]);
+            auto schedule = m_schedules.find(data[1]);
+            if (event == m_events.end() || schedule == m_schedules.end()) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+                break;
+            }
+            event->second.schedule_id = data[1];
+            event->second.delay       = milliseconds(data[2] * 256 + data[3]);
+            event->second.priority    = data[4];
+            arm_event(event->second, schedule->second);
+            break;
+        }
+        case SYNC_MSG: {
+            for (auto schedule = m_schedules.begin(); schedule != m_schedules.end(); schedule++) {
+                if (schedule->second.sync_char != data[0]) continue;
+                schedule->second.running = true;
+                if (schedule->second.switching) schedule->second.duration = schedule->second.next_duration;
+                schedule->second.switching = false;
+                schedule->second.start     = m_sim_time;
+                for (auto event = m_events.begin(); event != m_events.end(); event++) {
+                    if (event->second.schedule_id == schedule->first) arm_event(event->second, schedule->second);
+                }
+            }
+            break;
+        }
+        case HALT_MSG: {
+            for (auto schedule = m_schedules.begin(); schedule != m_schedules.end(); schedule++) {
+                schedule->second.running = false;
+                // a halted schedule has no period in progress, so a pending change applies at once
+                if (schedule->second.switching) schedule->second.duration = schedule->second.next_duration;
+                schedule->second.switching = false;
+            }
+            break;
+        }
+        case DELETE_SCHEDULE_MSG: {
+            if (m_schedules.erase(data[0]) == 0) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+                break;
+            }
+            for (auto event = m_events.begin(); event != m_events.end();) {
+                if (event->second.schedule_id == data[0])
+                    event = m_events.erase(event);
+                else
+                    event++;
+            }
+            break;
+        }
+        case DELETE_EVENT_MSG: {
+            if (m_events.erase(data[0]) == 0) {
+                m_error_count++;
+                send_error(EMU_ERR_BAD_ID, msg_type);
+            }
+            break;
+        }
+    }
+}
+
+void Emulator::arm_event(EventState& event, const ScheduleState& schedule) {
+    if (!schedule.running) return;
+    Time first = schedule.start + event.delay;
+    if (m_sim_time <= first) {
+        event.next_pulse = first;
+    } else if (schedule.duration == Time::Zero) {
+        // single-shot schedules that have already passed this event never fire it
+        event.next_pulse = Time::Inf;
+    } else {
+        // first period boundary (plus delay) that has not happened yet
+        int64_t since   = (m_sim_time - first).as_microseconds();
+        int64_t period  = schedule.duration.as_microseconds();
+        int64_t periods = (since + period - 1) / period;
+        event.next_pulse = first + microseconds(periods * period);
+    }
+}
+
+void Emulator::switch_period(unsigned char schedule_id, ScheduleState& schedule, Time start) {
+    schedule.duration  = schedule.next_duration;
+    schedule.switching = false;
+    schedule.start     = start;
+    for (auto event = m_events.begin(); event != m_events.end(); event++) {
+        if (event->second.schedule_id == schedule_id) arm_event(event->second, schedule);
+    }
+}
+
+void Emulator::advance(Time dt) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    Time end = m_sim_time + dt;
+    while (true) {
+        // deliver the earliest pending pulse across all running schedules
+        EventState*    next    = nullptr;
+        unsigned char  next_id = 0;
+        ScheduleState* next_schedule = nullptr;
+        for (auto event = m_events.begin(); event != m_events.end(); event++) {
+            auto schedule = m_schedules.find(event->second.schedule_id);
+            if (schedule == m_schedules.end() || !schedule->second.running) continue;
+            if (event->second.next_pulse > end) continue;
+            if (next == nullptr || event->second.next_pulse < next->next_pulse) {
+                next          = &event->second;
+                next_id       = event->first;
+                next_schedule = &schedule->second;
+            }
+        }
+        // a period change due no later than that pulse takes effect first
+        ScheduleState* switching    = nullptr;
+        unsigned char  switching_id = 0;
+        for (auto schedule = m_schedules.begin(); schedule != m_schedules.end(); schedule++) {
+            ScheduleState& state = schedule->second;
+            if (!state.running || !state.switching || state.switch_at > end) continue;
+            if (next != nullptr && state.switch_at > next->next_pulse) continue;
+            if (switching == nullptr || state.switch_at < switching->switch_at) {
+                switching    = &state;
+                switching_id = schedule->first;
+            }
+        }
+        if (switching != nullptr) {
+            m_sim_time = switching->switch_at;
+            switch_period(switching_id, *switching, switching->switch_at);
+            continue;
+        }
+        if (next == nullptr) break;
+
+        m_sim_time = next->next_pulse;
+
+        ChannelState& channel = m_channels[next->board_channel];
+        Pulse         pulse;
+        pulse.time          = m_sim_time;
+        pulse.event_id      = next_id;
+        pulse.board_channel = next->board_channel;
+        pulse.pulse_width   = channel.setup && next->pulse_width > channel.pw_limit ? channel.pw_limit : next->pulse_width;
+        pulse.amplitude     = channel.setup && next->amplitude > channel.amp_limit ? channel.amp_limit : next->amplitude;
+        m_pulse_counts[next->board_channel]++;
+
+        if (next->pending) {
+            Time latency = m_sim_time - next->changed_at;
+            if (m_latency.count == 0 || latency < m_latency.min) m_latency.min = latency;
+            if (m_latency.count == 0 || latency > m_latency.max) m_latency.max = latency;
+            m_latency.count++;
+            m_latency_sum += latency;
+            m_latency.mean = m_latency_sum / (int64_t)m_latency.count;
+            next->pending  = false;
+        }
+
+        if (m_pulse_callback) m_pulse_callback(pulse);
+
+        if (next_schedule->duration == Time::Zero)
+            next->next_pulse = Time::Inf;
+        else
+            next->next_pulse += next_schedule->duration;
+    }
+    m_sim_time = end;
+}
+
+void Emulator::send_reply(unsigned char msg_type, const std::vector<unsigned char>& data) {
+    unsigned char              msg_len = (unsigned char)data.size();
+    std::vector<unsigned char> reply   = {AMULET_CMD_1, AMULET_CMD_2, AMULET_ADR, (unsigned char)(4 + msg_len),
+                                          SRC_ADR,      DEST_ADR,     msg_type,   msg_len};
+    reply.insert(reply.end(), data.begin(), data.end());
+    reply.push_back(0x00);  // CRC placeholder (byte 1)
+    reply.push_back(0x00);  // CRC placeholder (byte 2)
+
+    unsigned short crc      = calc_crc16(&reply[0], reply.size() - READ_CRC_SIZE);
+    reply[reply.size() - 2] = lo_byte(crc);
+    reply[reply.size() - 1] = hi_byte(crc);
+
+    if (m_master_fd < 0) return;
+    size_t written = 0;
+    while (written < reply.size()) {
+        ssize_t result = ::write(m_master_fd, &reply[written], reply.size() - written);
+        if (result > 0) {
+            written += (size_t)result;
+        } else if (result < 0 && errno != EAGAIN && errno != EINTR) {
+            LOG(Error) << "Emulator failed to send reply " << print_as_hex(msg_type);
+            return;
+        } else {
+            struct pollfd pfd;
+            pfd.fd      = m_master_fd;
+            pfd.events  = POLLOUT;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, 50) <= 0) return;
+        }
+    }
+}
+
+void Emulator::send_error(unsigned char error_code, unsigned char failed_msg_type) {
+    send_reply(ERROR_REPORT_MSG, {error_code, failed_msg_type});
+}
+
+Time Emulator::get_sim_time() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_sim_time;
+}
+
+void Emulator::set_pulse_callback(std::function<void(const Pulse&)> callback_) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_pulse_callback = callback_;
+}
+
+size_t Emulator::get_pulse_count(unsigned char board_channel_) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_pulse_counts[board_channel_ & 0x03];
+}
+
+size_t Emulator::get_message_count() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_msg_count;
+}
+
+size_t Emulator::get_error_count() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_error_count;
+}
+
+bool Emulator::is_running() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (auto schedule = m_schedules.begin(); schedule != m_schedules.end(); schedule++) {
+        if (schedule->second.running) return true;
+    }
+    return false;
+}
+
+Emulator::LatencyStats Emulator::get_latency_stats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_latency;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,129 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Utility/MappedFile.hpp>
+#include <Mahi/Util.hpp>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+MappedFile::MappedFile() : m_mode(Read), m_size(0), m_fd(-1) {}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& filename_, Mode mode_) {
+    close();
+    int flags = mode_ == Write ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY;
+    m_fd      = ::open(filename_.c_str(), flags | O_CLOEXEC, 0644);
+    if (m_fd < 0) {
+        LOG(Error) << "Could not open " << filename_ << ": " << std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(m_fd, &info) != 0) {
+        LOG(Error) << "Could not read the size of " << filename_ << ": " << std::strerror(errno);
+        close();
+        return false;
+    }
+    m_filename = filename_;
+    m_mode     = mode_;
+    m_size     = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd   = -1;
+    m_size = 0;
+}
+
+bool MappedFile::is_open() const { return m_fd >= 0; }
+
+size_t MappedFile::size() const { return m_size; }
+
+bool MappedFile::reserve(size_t size_) {
+    if (m_fd < 0 || m_mode != Write) return false;
+    if (size_ <= m_size) return true;
+#ifdef __linux__
+    int result = posix_fallocate(m_fd, 0, (off_t)size_);
+#else
+    int result = ftruncate(m_fd, (off_t)size_) == 0 ? 0 : errno;
+#endif
+    if (result != 0) {
+        LOG(Error) << "Could not grow " << m_filename << " to " << size_ << " bytes: " << std::strerror(result);
+        return false;
+    }
+    m_size = size_;
+    return true;
+}
+
+bool MappedFile::truncate(size_t size_) {
+    if (m_fd < 0 || m_mode != Write) return false;
+    if (ftruncate(m_fd, (off_t)size_) != 0) {
+        LOG(Error) << "Could not truncate " << m_filename << " to " << size_ << " bytes: " << std::strerror(errno);
+        return false;
+    }
+    m_size = size_;
+    return true;
+}
+
+unsigned char* MappedFile::map(size_t offset_, size_t size_) {
+    if (m_fd < 0 || offset_ % get_alignment() != 0) {
+        LOG(Error) << "Cannot map " << size_ << " bytes at " << offset_ << " of " << m_filename;
+        return nullptr;
+    }
+    if (m_mode == Write && !reserve(offset_ + size_)) return nullptr;
+    if (m_mode == Read && offset_ + size_ > m_size) {
+        LOG(Error) << "Cannot map past the end of " << m_filename;
+        return nullptr;
+    }
+    int prot  = m_mode == Write ? PROT_READ | PROT_WRITE : PROT_READ;
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // a region being written is faulted in here, rather than a page at a time by whoever writes to it
+    if (m_mode == Write) flags |= MAP_POPULATE;
+#endif
+    void* region = mmap(nullptr, size_, prot, flags, m_fd, (off_t)offset_);
+    if (region == MAP_FAILED) {
+        LOG(Error) << "Could not map " << m_filename << ": " << std::strerror(errno);
+        return nullptr;
+    }
+    // regions are read front to back, so the kernel can read ahead and drop pages once they are passed
+    if (m_mode == Read) madvise(region, size_, MADV_SEQUENTIAL);
+    return (unsigned char*)region;
+}
+
+void MappedFile::unmap(unsigned char* region_, size_t size_) {
+    if (region_) munmap(region_, size_);
+}
+
+void MappedFile::flush(unsigned char* region_, size_t size_, bool wait_) {
+    if (region_) msync(region_, size_, wait_ ? MS_SYNC : MS_ASYNC);
+}
+
+size_t MappedFile::get_alignment() { return (size_t)sysconf(_SC_PAGESIZE); }
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Windows.h>
+
+#include <Mahi/Fes/Utility/MappedFile.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+MappedFile::MappedFile() : m_mode(Read), m_size(0), m_handle(INVALID_HANDLE_VALUE) {}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& filename_, Mode mode_) {
+    close();
+    DWORD access      = mode_ == Write ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    DWORD disposition = mode_ == Write ? CREATE_ALWAYS : OPEN_EXISTING;
+    m_handle          = CreateFileA(filename_.c_str(), access, FILE_SHARE_READ, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_handle == INVALID_HANDLE_VALUE) {
+        LOG(Error) << "Could not open " << filename_ << " (error " << GetLastError() << ")";
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_handle, &size)) {
+        LOG(Error) << "Could not read the size of " << filename_ << " (error " << GetLastError() << ")";
+        close();
+        return false;
+    }
+    m_filename = filename_;
+    m_mode     = mode_;
+    m_size     = (size_t)size.QuadPart;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_handle != INVALID_HANDLE_VALUE) CloseHandle(m_handle);
+    m_handle = INVALID_HANDLE_VALUE;
+    m_size   = 0;
+}
+
+bool MappedFile::is_open() const { return m_handle != INVALID_HANDLE_VALUE; }
+
+size_t MappedFile::size() const { return m_size; }
+
+bool MappedFile::reserve(size_t size_) {
+    if (m_handle == INVALID_HANDLE_VALUE || m_mode != Write) return false;
+    if (size_ <= m_size) return true;
+    return truncate(size_);
+}
+
+bool MappedFile::truncate(size_t size_) {
+    if (m_handle == INVALID_HANDLE_VALUE || m_mode != Write) return false;
+    LARGE_INTEGER position;
+    position.QuadPart = (LONGLONG)size_;
+    if (!SetFilePointerEx(m_handle, position, NULL, FILE_BEGIN) || !SetEndOfFile(m_handle)) {
+        LOG(Error) << "Could not resize " << m_filename << " to " << size_ << " bytes (error " << GetLastError() << ")";
+        return false;
+    }
+    m_size = size_;
+    return true;
+}
+
+unsigned char* MappedFile::map(size_t offset_, size_t size_) {
+    if (m_handle == INVALID_HANDLE_VALUE || offset_ % get_alignment() != 0) {
+        LOG(Error) << "Cannot map " << size_ << " bytes at " << offset_ << " of " << m_filename;
+        return nullptr;
+    }
+    if (m_mode == Write && !reserve(offset_ + size_)) return nullptr;
+    if (m_mode == Read && offset_ + size_ > m_size) {
+        LOG(Error) << "Cannot map past the end of " << m_filename;
+        return nullptr;
+    }
+    // the view keeps the mapping object alive, so its handle can be closed straight away
+    unsigned long long end     = (unsigned long long)(offset_ + size_);
+    HANDLE             mapping = CreateFileMappingA(m_handle, NULL, m_mode == Write ? PAGE_READWRITE : PAGE_READONLY,
+                                                    (DWORD)(end >> 32), (DWORD)end, NULL);
+    if (mapping == NULL) {
+        LOG(Error) << "Could not map " << m_filename << " (error " << GetLastError() << ")";
+        return nullptr;
+    }
+    unsigned long long offset = (unsigned long long)offset_;
+    void* region = MapViewOfFile(mapping, m_mode == Write ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(offset >> 32),
+                                 (DWORD)offset, size_);
+    CloseHandle(mapping);
+    if (region == NULL) {
+        LOG(Error) << "Could not map " << m_filename << " (error " << GetLastError() << ")";
+        return nullptr;
+    }
+    return (unsigned char*)region;
+}
+
+void MappedFile::unmap(unsigned char* region_, size_t size_) {
+    if (region_) UnmapViewOfFile(region_);
+}
+
+void MappedFile::flush(unsigned char* region_, size_t size_, bool wait_) {
+    if (!region_) return;
+    FlushViewOfFile(region_, size_);
+    if (wait_) FlushFileBuffers(m_handle);
+}
+
+size_t MappedFile::get_alignment() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (size_t)info.dwAllocationGranularity;
+}
+
+}  // namespace fes
+}  // namespace mahi
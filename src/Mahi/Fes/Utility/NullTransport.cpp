@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/NullTransport.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+NullTransport::NullTransport(unsigned int baud_rate_) :
+    Transport("NULL"),
+    m_baud_rate(baud_rate_),
+    m_bytes_written(0) {}
+
+bool NullTransport::open() { return true; }
+
+void NullTransport::close() {}
+
+bool NullTransport::is_open() { return true; }
+
+bool NullTransport::write(const unsigned char* data, size_t size) {
+    if (!data) return false;
+    m_bytes_written += size;
+    return true;
+}
+
+int NullTransport::read(unsigned char*, size_t, Time) { return 0; }
+
+void NullTransport::purge() {}
+
+unsigned int NullTransport::get_baud_rate() { return m_baud_rate; }
+
+size_t NullTransport::get_bytes_written() const { return m_bytes_written; }
+
+void NullTransport::reset_bytes_written() { m_bytes_written = 0; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,121 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/PortPoller.hpp>
+#include <Mahi/Util.hpp>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <poll.h>
+#endif
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+PortPoller::PortPoller() : m_num_polled(0), m_epoll_fd(-1) {
+#if defined(__linux__)
+    m_epoll_fd = epoll_create1(0);
+    if (m_epoll_fd < 0) LOG(Error) << "Could not create the epoll set. Ports will be checked every millisecond.";
+#endif
+}
+
+PortPoller::~PortPoller() {
+#if defined(__linux__)
+    if (m_epoll_fd >= 0) ::close(m_epoll_fd);
+#endif
+}
+
+bool PortPoller::add(Transport* transport_) {
+    int fd = transport_->get_poll_fd();
+#if defined(__linux__)
+    if (fd >= 0) {
+        epoll_event event = {};
+        event.events      = EPOLLIN;
+        event.data.u64    = m_transports.size();
+        if (m_epoll_fd < 0 || epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            LOG(Warning) << "Could not wait on " << transport_->get_port_name()
+                         << ". It will be checked every millisecond instead.";
+            fd = -1;
+        }
+    }
+#elif defined(_WIN32)
+    fd = -1;
+#endif
+    m_transports.push_back(transport_);
+    m_fds.push_back(fd);
+    if (fd >= 0) m_num_polled++;
+    return true;
+}
+
+void PortPoller::clear() {
+#if defined(__linux__)
+    for (size_t i = 0; i < m_fds.size(); i++) {
+        if (m_fds[i] >= 0) epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, m_fds[i], nullptr);
+    }
+#endif
+    m_transports.clear();
+    m_fds.clear();
+    m_num_polled = 0;
+}
+
+size_t PortPoller::size() const { return m_transports.size(); }
+
+size_t PortPoller::wait(Time timeout, std::vector<size_t>& ready) {
+    ready.clear();
+    // transports that cannot be waited on are checked every millisecond, so never block for longer
+    bool all_polled = m_num_polled == m_transports.size();
+    if (!all_polled && timeout > milliseconds(1)) timeout = milliseconds(1);
+    int timeout_ms = timeout > Time::Zero ? (int)((timeout.as_microseconds() + 999) / 1000) : 0;
+
+    if (m_num_polled == 0) {
+        if (timeout > Time::Zero) sleep(timeout);
+    } else {
+#if defined(__linux__)
+        epoll_event events[16];
+        int         count = epoll_wait(m_epoll_fd, events, 16, timeout_ms);
+        for (int i = 0; i < count; i++) {
+            ready.push_back((size_t)events[i].data.u64);
+        }
+#elif !defined(_WIN32)
+        std::vector<pollfd> fds;
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < m_fds.size(); i++) {
+            if (m_fds[i] < 0) continue;
+            pollfd fd = {m_fds[i], POLLIN, 0};
+            fds.push_back(fd);
+            indices.push_back(i);
+        }
+        if (::poll(&fds[0], fds.size(), timeout_ms) > 0) {
+            for (size_t i = 0; i < fds.size(); i++) {
+                if (fds[i].revents & POLLIN) ready.push_back(indices[i]);
+            }
+        }
+#endif
+    }
+
+    // the rest are reported every time, and reading them with a zero timeout finds out if they had anything
+    for (size_t i = 0; i < m_fds.size(); i++) {
+        if (m_fds[i] < 0) ready.push_back(i);
+    }
+    return ready.size();
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,288 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/Profile.hpp>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+const char PROFILE_MAGIC[8] = {'F', 'E', 'S', 'P', 'R', 'O', 'F', 'L'};
+}  // namespace
+
+Profile::Profile() :
+    m_region(nullptr),
+    m_region_size(0),
+    m_samples(nullptr),
+    m_channel_count(0),
+    m_sample_count(0),
+    m_sample_period_us(0),
+    m_rate(0),
+    m_interpolation(Interpolation::Linear),
+    m_end(ProfileEnd::Hold) {}
+
+Profile::~Profile() { clear(); }
+
+void Profile::clear() {
+    if (m_region) m_file.unmap(m_region, m_region_size);
+    m_file.close();
+    m_region      = nullptr;
+    m_region_size = 0;
+    std::vector<float>().swap(m_owned);
+    attach(nullptr, 0, 0, 0);
+}
+
+void Profile::attach(const float* samples, size_t channel_count, size_t sample_count, int64_t sample_period_us) {
+    m_samples          = samples;
+    m_channel_count    = channel_count;
+    m_sample_count     = sample_count;
+    m_sample_period_us = sample_period_us;
+    m_rate             = sample_period_us > 0 ? 1.0 / sample_period_us : 0;
+}
+
+bool Profile::load_text(const std::string& filename_, Time sample_period_, bool time_column_) {
+    std::ifstream file(filename_);
+    if (!file.is_open()) {
+        LOG(Error) << "Could not open profile " << filename_;
+        return false;
+    }
+
+    // rows are read as they come, then transposed into one array per channel
+    std::vector<double> rows;
+    std::vector<double> times;
+    size_t              columns  = 0;
+    size_t              line_num = 0;
+    std::string         line;
+    while (std::getline(file, line)) {
+        line_num++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        for (size_t i = start; i < line.size(); i++) {
+            if (line[i] == ',') line[i] = ' ';
+        }
+        std::istringstream row(line);
+        size_t             count = 0;
+        double             value;
+        while (row >> value) {
+            if (time_column_ && count == 0) {
+                times.push_back(value);
+            } else {
+                rows.push_back(value);
+            }
+            count++;
+        }
+        if (!row.eof() || count == 0 || (columns != 0 && count != columns)) {
+            LOG(Error) << "Could not read line " << line_num << " of profile " << filename_ << ": " << line;
+            return false;
+        }
+        columns = count;
+    }
+
+    size_t channel_count = time_column_ ? columns - 1 : columns;
+    size_t sample_count  = channel_count > 0 ? rows.size() / channel_count : 0;
+    if (sample_count == 0) {
+        LOG(Error) << "Profile " << filename_ << " has no samples";
+        return false;
+    }
+
+    // with a time column, the rows have to fall on an even grid for lookups to be O(1)
+    int64_t sample_period_us = sample_period_.as_microseconds();
+    if (time_column_) {
+        double period = sample_count > 1 ? (times.back() - times.front()) / (sample_count - 1) : 0;
+        for (size_t i = 0; i < sample_count && period > 0; i++) {
+            if (std::fabs(times[i] - times.front() - i * period) > 0.01 * period) {
+                LOG(Error) << "Profile " << filename_ << " is not evenly sampled (line " << i + 1 << " of the samples)";
+                return false;
+            }
+        }
+        sample_period_us = (int64_t)std::llround(period * 1e6);
+    }
+    if (sample_period_us <= 0 && sample_count > 1) {
+        LOG(Error) << "Profile " << filename_ << " needs a sample period greater than zero";
+        return false;
+    }
+
+    clear();
+    m_owned.resize(channel_count * sample_count);
+    for (size_t s = 0; s < sample_count; s++) {
+        for (size_t c = 0; c < channel_count; c++) {
+            m_owned[c * sample_count + s] = (float)rows[s * channel_count + c];
+        }
+    }
+    attach(&m_owned[0], channel_count, sample_count, sample_period_us);
+    return true;
+}
+
+bool Profile::load_binary(const std::string& filename_) {
+    clear();
+    if (!m_file.open(filename_, MappedFile::Read)) return false;
+    if (m_file.size() < sizeof(ProfileHeader)) {
+        LOG(Error) << filename_ << " is too short to be a profile";
+        clear();
+        return false;
+    }
+    m_region_size = m_file.size();
+    m_region      = m_file.map(0, m_region_size);
+    if (!m_region) {
+        clear();
+        return false;
+    }
+
+    ProfileHeader header;
+    std::memcpy(&header, m_region, sizeof(header));
+    if (std::memcmp(header.magic, PROFILE_MAGIC, sizeof(PROFILE_MAGIC)) != 0 || header.version != VERSION) {
+        LOG(Error) << filename_ << " is not a version " << VERSION << " profile";
+        clear();
+        return false;
+    }
+    if (header.channel_count == 0 || header.sample_count == 0 || header.sample_period <= 0) {
+        LOG(Error) << "Profile " << filename_ << " has no samples or a sample period that is not greater than zero";
+        clear();
+        return false;
+    }
+    // compared by division, since a corrupt header could make the product of the counts overflow
+    uint64_t floats = (m_region_size - sizeof(ProfileHeader)) / sizeof(float);
+    if (header.channel_count > floats / header.sample_count) {
+        LOG(Error) << "Profile " << filename_ << " is truncated (" << header.channel_count << " channels of "
+                   << header.sample_count << " samples do not fit in " << m_region_size << " bytes)";
+        clear();
+        return false;
+    }
+    attach(reinterpret_cast<const float*>(m_region + sizeof(ProfileHeader)), header.channel_count,
+           (size_t)header.sample_count, header.sample_period);
+    return true;
+}
+
+bool Profile::set_samples(size_t channel_count_, size_t sample_count_, Time sample_period_, const float* samples_) {
+    if (channel_count_ == 0 || sample_count_ == 0 || !samples_ ||
+        (sample_count_ > 1 && sample_period_ <= Time::Zero)) {
+        LOG(Error) << "A profile needs at least one sample and a sample period greater than zero";
+        return false;
+    }
+    clear();
+    m_owned.assign(samples_, samples_ + channel_count_ * sample_count_);
+    attach(&m_owned[0], channel_count_, sample_count_, sample_period_.as_microseconds());
+    return true;
+}
+
+bool Profile::save_binary(const std::string& filename_) const {
+    // load_binary refuses anything else, so it is not written in the first place
+    if (m_sample_count == 0 || m_sample_period_us <= 0) {
+        LOG(Error) << "Only a profile with samples and a sample period greater than zero can be saved";
+        return false;
+    }
+    ProfileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, PROFILE_MAGIC, sizeof(PROFILE_MAGIC));
+    header.version       = VERSION;
+    header.channel_count = (uint32_t)m_channel_count;
+    header.sample_count  = m_sample_count;
+    header.sample_period = m_sample_period_us;
+
+    std::ofstream file(filename_, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (m_samples) {
+        file.write(reinterpret_cast<const char*>(m_samples), m_channel_count * m_sample_count * sizeof(float));
+    }
+    if (!file.good()) {
+        LOG(Error) << "Could not write profile " << filename_;
+        return false;
+    }
+    return true;
+}
+
+void Profile::set_interpolation(Interpolation interpolation_) { m_interpolation = interpolation_; }
+
+void Profile::set_end_policy(ProfileEnd end_) { m_end = end_; }
+
+bool Profile::is_finished(Time time_) const {
+    return m_sample_count == 0 || time_.as_microseconds() > (int64_t)(m_sample_count - 1) * m_sample_period_us;
+}
+
+bool Profile::sample(size_t channel_, Time time_, double& value_) const {
+    if (channel_ >= m_channel_count) {
+        LOG(Error) << "Profile has no channel " << channel_;
+        return false;
+    }
+    if (m_end == ProfileEnd::Stop && is_finished(time_)) return false;
+    value_ = interpolate(m_samples + channel_ * m_sample_count, time_.as_microseconds() * m_rate);
+    return true;
+}
+
+bool Profile::sample_all(Time time_, double* values_) const {
+    if (m_channel_count == 0 || (m_end == ProfileEnd::Stop && is_finished(time_))) return false;
+    double position = time_.as_microseconds() * m_rate;
+    for (size_t c = 0; c < m_channel_count; c++) {
+        values_[c] = interpolate(m_samples + c * m_sample_count, position);
+    }
+    return true;
+}
+
+double Profile::interpolate(const float* samples, double position) const {
+    const int64_t n = (int64_t)m_sample_count;
+    if (n == 1) return samples[0];
+    if (position < 0) position = 0;
+
+    // looping wraps every index around, otherwise they stop at the ends
+    bool loop = m_end == ProfileEnd::Loop;
+    if (loop) {
+        position = std::fmod(position, (double)n);
+    } else if (position > n - 1) {
+        return m_end == ProfileEnd::Zero ? 0 : samples[n - 1];
+    }
+    int64_t i = (int64_t)position;
+    double  f = position - i;
+    auto    at = [&](int64_t k) -> double {
+        if (loop) return samples[(k % n + n) % n];
+        return samples[k < 0 ? 0 : (k >= n ? n - 1 : k)];
+    };
+
+    switch (m_interpolation) {
+        case Interpolation::Nearest: return at(f < 0.5 ? i : i + 1);
+        case Interpolation::Linear: {
+            double a = at(i);
+            return a + (at(i + 1) - a) * f;
+        }
+        case Interpolation::Cubic: {
+            double p0 = at(i - 1), p1 = at(i), p2 = at(i + 1), p3 = at(i + 2);
+            return p1 + 0.5 * f * (p2 - p0 + f * (2 * p0 - 5 * p1 + 4 * p2 - p3 + f * (3 * (p1 - p2) + p3 - p0)));
+        }
+    }
+    return at(i);
+}
+
+size_t Profile::get_channel_count() const { return m_channel_count; }
+
+size_t Profile::get_sample_count() const { return m_sample_count; }
+
+Time Profile::get_sample_period() const { return microseconds(m_sample_period_us); }
+
+Time Profile::get_duration() const {
+    return m_sample_count > 0 ? microseconds((int64_t)(m_sample_count - 1) * m_sample_period_us) : Time::Zero;
+}
+
+const float* Profile::get_channel(size_t channel_) const {
+    return channel_ < m_channel_count ? m_samples + channel_ * m_sample_count : nullptr;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/RecordingTransport.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+RecordingTransport::RecordingTransport(std::shared_ptr<Transport> transport_, SessionRecorder* recorder_, unsigned char port_) :
+    Transport(transport_->get_port_name()),
+    m_transport(transport_),
+    m_recorder(recorder_),
+    m_port(port_) {}
+
+bool RecordingTransport::open() { return m_transport->open(); }
+
+void RecordingTransport::close() { m_transport->close(); }
+
+bool RecordingTransport::is_open() { return m_transport->is_open(); }
+
+bool RecordingTransport::write(const unsigned char* data, size_t size) {
+    if (!m_transport->write(data, size)) return false;
+    m_recorder->record(FrameDirection::Tx, m_port, data, size);
+    return true;
+}
+
+int RecordingTransport::read(unsigned char* data, size_t size, Time timeout) {
+    int result = m_transport->read(data, size, timeout);
+    if (result <= 0) return result;
+    // the bytes are kept as they came in too, so that bytes which were not part of a valid reply
+    // (noise, or a reply with a bad crc) can still be looked at afterwards
+    m_recorder->record(FrameDirection::RxRaw, m_port, data, (size_t)result);
+    size_t used = 0;
+    while (used < (size_t)result || m_parser.bytes_needed() == 0) {
+        used += m_parser.feed(data + used, (size_t)result - used);
+        if (m_parser.frame_ready()) {
+            const ReadFrame& frame = m_parser.get_frame();
+            m_recorder->record(FrameDirection::Rx, m_port, frame.get_bytes(), frame.get_size());
+        }
+    }
+    return result;
+}
+
+void RecordingTransport::purge() {
+    m_transport->purge();
+    m_parser.reset();
+}
+
+bool RecordingTransport::drain() { return m_transport->drain(); }
+
+unsigned int RecordingTransport::get_baud_rate() { return m_transport->get_baud_rate(); }
+
+int RecordingTransport::get_poll_fd() { return m_transport->get_poll_fd(); }
+
+}  // namespace fes
+}  // namespace mahi
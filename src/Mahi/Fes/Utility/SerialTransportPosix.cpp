@@ -0,0 +1,189 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Utility/SerialTransport.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+/// converts a numeric baud rate into the termios speed constant (0 if unsupported)
+speed_t to_speed(unsigned int baud_rate) {
+    switch (baud_rate) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        default: return 0;
+    }
+}
+
+/// waits up to timeout for the fd to become ready for the given events. Returns >0 if ready,
+/// 0 on timeout, and -1 on error
+int wait_for(int fd, short events, Time timeout) {
+    struct pollfd pfd;
+    pfd.fd      = fd;
+    pfd.events  = events;
+    pfd.revents = 0;
+    // round up so that sub-millisecond timeouts still give the driver a chance
+    int timeout_ms = timeout <= Time::Zero ? 0 : (int)((timeout.as_microseconds() + 999) / 1000);
+    int result;
+    do {
+        result = poll(&pfd, 1, timeout_ms);
+    } while (result < 0 && errno == EINTR);
+    if (result > 0 && (pfd.revents & (POLLERR | POLLNVAL))) return -1;
+    return result;
+}
+}  // namespace
+
+SerialTransport::SerialTransport(const std::string& port_name_, unsigned int baud_rate_) :
+    Transport(port_name_),
+    m_baud_rate(baud_rate_),
+    m_fd(-1) {}
+
+SerialTransport::~SerialTransport() { close(); }
+
+bool SerialTransport::open() {
+    // non-blocking so that neither reads nor writes can ever stall the control loop; waiting
+    // is done explicitly with poll()
+    m_fd = ::open(m_port_name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if (m_fd < 0) {
+        LOG(Error) << "Failed to open port " << m_port_name;
+        return false;
+    } else {
+        LOG(Info) << "Successfully opened port " << m_port_name;
+    }
+
+    if (!configure_port()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SerialTransport::configure_port() {
+    struct termios port_settings;
+
+    if (tcgetattr(m_fd, &port_settings) != 0) {
+        LOG(Error) << "Error getting serial port state";
+        return false;
+    }
+
+    speed_t speed = to_speed(m_baud_rate);
+    if (speed == 0) {
+        LOG(Error) << "Unsupported baud rate " << m_baud_rate;
+        return false;
+    }
+    cfsetispeed(&port_settings, speed);
+    cfsetospeed(&port_settings, speed);
+
+    // raw 8N1, receiver enabled, no modem control
+    cfmakeraw(&port_settings);
+    port_settings.c_cflag &= ~(PARENB | CSTOPB | CSIZE | CRTSCTS);
+    port_settings.c_cflag |= (CS8 | CLOCAL | CREAD);
+    // disable software flow control
+    port_settings.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+    // Reads are driven by poll() on a non-blocking fd, so the driver should hand back whatever
+    // bytes it has immediately rather than holding them for VMIN bytes or VTIME deciseconds.
+    port_settings.c_cc[VMIN]  = 0;
+    port_settings.c_cc[VTIME] = 0;
+
+    if (tcsetattr(m_fd, TCSANOW, &port_settings) != 0) {
+        LOG(Error) << "Error setting serial port state";
+        return false;
+    }
+
+    purge();
+
+    return true;
+}
+
+void SerialTransport::close() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool SerialTransport::is_open() { return m_fd >= 0; }
+
+bool SerialTransport::write(const unsigned char* data, size_t size) {
+    size_t bytes_written = 0;
+    Clock  timeout_clock;
+    while (bytes_written < size) {
+        ssize_t result = ::write(m_fd, data + bytes_written, size - bytes_written);
+        if (result > 0) {
+            bytes_written += (size_t)result;
+        } else if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+        } else {
+            // the driver's transmit buffer is full; wait for room, but never past the timeout
+            Time remaining = m_write_timeout - timeout_clock.get_elapsed_time();
+            if (remaining <= Time::Zero || wait_for(m_fd, POLLOUT, remaining) <= 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int SerialTransport::read(unsigned char* data, size_t size, Time timeout) {
+    if (size == 0) return 0;
+    while (true) {
+        ssize_t result = ::read(m_fd, data, size);
+        if (result > 0) return (int)result;
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+        // with VMIN = VTIME = 0 an empty tty returns 0 instead of EAGAIN, so treat both the same
+        if (timeout <= Time::Zero) return 0;
+        // nothing available yet; wait for the first byte (or the timeout)
+        int ready = wait_for(m_fd, POLLIN, timeout);
+        if (ready <= 0) return ready;
+        // only wait once, after which whatever is available is returned
+        timeout = Time::Zero;
+    }
+}
+
+void SerialTransport::purge() { tcflush(m_fd, TCIOFLUSH); }
+
+bool SerialTransport::drain() {
+    int result;
+    do {
+        result = tcdrain(m_fd);
+    } while (result < 0 && errno == EINTR);
+    return result == 0;
+}
+
+unsigned int SerialTransport::get_baud_rate() { return m_baud_rate; }
+
+int SerialTransport::get_poll_fd() { return m_fd; }
+
+void SerialTransport::set_write_timeout(Time write_timeout_) { m_write_timeout = write_timeout_; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,179 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Windows.h>
+
+#include <Mahi/Fes/Utility/SerialTransport.hpp>
+#include <Mahi/Util.hpp>
+#include <codecvt>
+#include <locale>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+SerialTransport::SerialTransport(const std::string& port_name_, unsigned int baud_rate_) :
+    Transport(port_name_),
+    m_baud_rate(baud_rate_),
+    m_handle(INVALID_HANDLE_VALUE) {}
+
+SerialTransport::~SerialTransport() { close(); }
+
+bool SerialTransport::open() {
+    // the comport must be formatted as an LPCWSTR, so we need to get it into that form from a
+    // std::string
+    std::wstring com_prefix = L"\\\\.\\";
+    std::wstring com_suffix =
+        std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(m_port_name);
+    std::wstring comID = com_prefix + com_suffix;
+
+    m_handle = CreateFileW(comID.c_str(),                 // port name
+                           GENERIC_READ | GENERIC_WRITE,  // Read/Write
+                           0,                             // No Sharing
+                           NULL,                          // No Security
+                           OPEN_EXISTING,                 // Open existing port only
+                           0,                             // Non Overlapped I/O
+                           NULL);                         // Null for Comm Devices
+
+    // Check if creating the comport was successful or not and log it
+    if (m_handle == INVALID_HANDLE_VALUE) {
+        LOG(Error) << "Failed to open port " << m_port_name;
+        return false;
+    } else {
+        LOG(Info) << "Successfully opened port " << m_port_name;
+    }
+
+    if (!configure_port()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SerialTransport::configure_port() {
+    // http://bd.eduweb.hhs.nl/micprg/pdf/serial-win.pdf
+
+    DCB dcbSerialParams       = {0};
+    dcbSerialParams.DCBlength = sizeof(DCB);
+
+    if (!GetCommState(m_handle, &dcbSerialParams)) {
+        LOG(Error) << "Error getting serial port state";
+        return false;
+    }
+
+    // set the baud rate that we will communicate at (9600 by default)
+    dcbSerialParams.BaudRate = m_baud_rate;
+
+    // 8 bits in the bytes transmitted and received.
+    dcbSerialParams.ByteSize = 8;
+
+    // Specify that we are using one stop bit
+    dcbSerialParams.StopBits = ONESTOPBIT;
+
+    // Specify that we are using no parity
+    dcbSerialParams.Parity = NOPARITY;
+
+    // Disable all parameters dealing with flow control
+    dcbSerialParams.fOutX       = FALSE;
+    dcbSerialParams.fInX        = FALSE;
+    dcbSerialParams.fRtsControl = RTS_CONTROL_DISABLE;
+    dcbSerialParams.fDtrControl = DTR_CONTROL_DISABLE;
+
+    // Set communication parameters for the serial port
+    if (!SetCommState(m_handle, &dcbSerialParams)) {
+        LOG(Error) << "Error setting serial port state";
+        return false;
+    }
+
+    // start with a 10 ms read timeout, which read() adjusts on demand
+    m_read_timeout_ms = -1;
+    if (read(nullptr, 0, milliseconds(10)) < 0) {
+        LOG(Error) << "Error setting serial port timeouts";
+        return false;
+    }
+
+    purge();
+
+    return true;
+}
+
+void SerialTransport::close() {
+    if (m_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool SerialTransport::is_open() { return m_handle != INVALID_HANDLE_VALUE; }
+
+bool SerialTransport::write(const unsigned char* data, size_t size) {
+    // Captures how many bytes were written
+    DWORD dwBytesWritten = 0;
+    if (!WriteFile(m_handle, data, (DWORD)size, &dwBytesWritten, NULL)) {
+        return false;
+    }
+    return dwBytesWritten == (DWORD)size;
+}
+
+int SerialTransport::read(unsigned char* data, size_t size, Time timeout) {
+    // MAXDWORD interval/multiplier with a constant timeout makes ReadFile return as soon as any
+    // bytes are available, or after the constant timeout if none arrive. A zero timeout uses
+    // MAXDWORD interval alone, which returns immediately with whatever is buffered. Only touch the
+    // port settings when the requested timeout actually changes.
+    long timeout_ms = timeout > Time::Zero ? (long)timeout.as_milliseconds() : 0;
+    if (timeout_ms != m_read_timeout_ms) {
+        COMMTIMEOUTS timeouts                = {0};
+        timeouts.ReadIntervalTimeout         = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier  = timeout_ms > 0 ? MAXDWORD : 0;
+        timeouts.ReadTotalTimeoutConstant    = timeout_ms > 0 ? (DWORD)timeout_ms : 0;
+        timeouts.WriteTotalTimeoutConstant   = (DWORD)m_write_timeout.as_milliseconds();
+        timeouts.WriteTotalTimeoutMultiplier = 10;
+        if (!SetCommTimeouts(m_handle, &timeouts)) {
+            return -1;
+        }
+        m_read_timeout_ms = timeout_ms;
+    }
+    if (size == 0) return 0;
+
+    DWORD dwBytesRead = 0;
+    if (!ReadFile(m_handle, data, (DWORD)size, &dwBytesRead, NULL)) {
+        return -1;
+    }
+    return (int)dwBytesRead;
+}
+
+void SerialTransport::purge() {
+    PurgeComm(m_handle, PURGE_TXABORT);
+    PurgeComm(m_handle, PURGE_RXABORT);
+    PurgeComm(m_handle, PURGE_RXCLEAR);
+    PurgeComm(m_handle, PURGE_TXCLEAR);
+}
+
+bool SerialTransport::drain() { return FlushFileBuffers(m_handle) != 0; }
+
+unsigned int SerialTransport::get_baud_rate() { return m_baud_rate; }
+
+int SerialTransport::get_poll_fd() { return -1; }
+
+void SerialTransport::set_write_timeout(Time write_timeout_) {
+    m_write_timeout = write_timeout_;
+    // force the timeouts to be re-applied on the next read
+    m_read_timeout_ms = -1;
+}
+
+}  // namespace fes
+}  // namespace mahi
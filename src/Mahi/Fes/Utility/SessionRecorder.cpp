@@ -0,0 +1,282 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/SessionRecorder.hpp>
+#include <chrono>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+
+const char   CHUNK_MAGIC[8]  = {'F', 'E', 'S', 'C', 'H', 'U', 'N', 'K'};
+const size_t CHUNK_ALIGNMENT = 65536;  // the largest mapping alignment of any OS, so files read anywhere
+
+int64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t record_size(size_t frame_size) { return (sizeof(SessionRecordHeader) + frame_size + 7) & ~(size_t)7; }
+
+}  // namespace
+
+static_assert(sizeof(SessionChunkHeader) == 64, "SessionChunkHeader must be 64 bytes on disk");
+static_assert(sizeof(SessionRecordHeader) == 16, "SessionRecordHeader must be 16 bytes on disk");
+
+SessionRecorder::SessionRecorder() {}
+
+SessionRecorder::~SessionRecorder() { close(); }
+
+bool SessionRecorder::open(const std::string& filename_, size_t chunk_size_) {
+    close();
+    size_t alignment = MappedFile::get_alignment() > CHUNK_ALIGNMENT ? MappedFile::get_alignment() : CHUNK_ALIGNMENT;
+    m_chunk_size     = (chunk_size_ + alignment - 1) / alignment * alignment;
+    if (m_chunk_size == 0 || m_chunk_size > UINT32_MAX) {
+        LOG(Error) << "Session chunk size of " << chunk_size_ << " bytes is not supported";
+        return false;
+    }
+    if (!m_file.open(filename_, MappedFile::Write)) return false;
+    m_origin_ns      = steady_ns();
+    m_origin_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // the first chunk and the one after it are ready before anything is recorded
+    m_chunk_index = 0;
+    m_used        = 0;
+    m_chunk       = prepare_chunk(0);
+    m_spare       = m_chunk ? prepare_chunk(1) : nullptr;
+    if (!m_spare) {
+        close();
+        return false;
+    }
+    m_records = 0;
+    m_dropped = 0;
+    m_chunks  = 1;
+    m_stop    = false;
+    m_thread  = std::thread(&SessionRecorder::maintain_loop, this);
+    return true;
+}
+
+void SessionRecorder::close() {
+    m_stop = true;
+    if (m_thread.joinable()) m_thread.join();
+    if (!m_file.is_open()) return;
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (m_retired) {
+        m_file.flush(m_retired, m_chunk_size, false);
+        m_file.unmap(m_retired, m_chunk_size);
+    }
+    if (m_chunk) {
+        m_file.flush(m_chunk, m_chunk_size, true);
+        m_file.unmap(m_chunk, m_chunk_size);
+        // the spare chunk was never written to, so it is trimmed off the end
+        m_file.unmap(m_spare, m_chunk_size);
+        m_file.truncate((size_t)(m_chunk_index + 1) * m_chunk_size);
+    }
+    m_chunk   = nullptr;
+    m_spare   = nullptr;
+    m_retired = nullptr;
+    m_file.close();
+}
+
+bool SessionRecorder::is_open() const { return m_file.is_open(); }
+
+bool SessionRecorder::record(FrameDirection direction_, unsigned char port_, const unsigned char* bytes_, size_t size_) {
+    int64_t time     = steady_ns();
+    size_t  needed   = record_size(size_);
+    size_t  capacity = m_chunk_size - sizeof(SessionChunkHeader);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    if (!m_chunk || needed > capacity || size_ > UINT16_MAX) {
+        m_dropped++;
+        return false;
+    }
+    if (m_used + needed > capacity) {
+        // move on to the chunk mapped ahead. If the background thread has not caught up, the frame is
+        // dropped rather than waiting on the disk
+        if (!m_spare || m_retired) {
+            m_dropped++;
+            return false;
+        }
+        m_retired = m_chunk;
+        m_chunk   = m_spare;
+        m_spare   = nullptr;
+        m_used    = 0;
+        m_chunk_index++;
+        m_chunks++;
+    }
+
+    SessionRecordHeader header;
+    header.time_ns   = time - m_origin_ns;
+    header.size      = (uint16_t)size_;
+    header.direction = (uint8_t)direction_;
+    header.port      = port_;
+    header.reserved  = 0;
+    unsigned char* record = m_chunk + sizeof(SessionChunkHeader) + m_used;
+    std::memcpy(record, &header, sizeof(header));
+    std::memcpy(record + sizeof(header), bytes_, size_);
+    m_used += needed;
+
+    // the record is complete before the header says so
+    SessionChunkHeader* chunk = (SessionChunkHeader*)m_chunk;
+    std::atomic_thread_fence(std::memory_order_release);
+    chunk->record_count++;
+    chunk->committed = (uint32_t)m_used;
+    m_records++;
+    return true;
+}
+
+void SessionRecorder::set_flush_interval(Time interval_) { m_flush_interval_ns = interval_.as_microseconds() * 1000; }
+
+size_t SessionRecorder::get_record_count() const { return m_records; }
+
+size_t SessionRecorder::get_dropped_count() const { return m_dropped; }
+
+size_t SessionRecorder::get_chunk_count() const { return m_chunks; }
+
+unsigned char* SessionRecorder::prepare_chunk(uint64_t index) {
+    unsigned char* chunk = m_file.map((size_t)index * m_chunk_size, m_chunk_size);
+    if (!chunk) return nullptr;
+    SessionChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    header.version        = VERSION;
+    header.chunk_size     = (uint32_t)m_chunk_size;
+    header.index          = index;
+    header.origin_ns      = m_origin_ns;
+    header.origin_unix_ns = m_origin_unix_ns;
+    std::memcpy(chunk, &header, sizeof(header));
+    return chunk;
+}
+
+void SessionRecorder::maintain_loop() {
+    int64_t last_flush = steady_ns();
+    while (!m_stop) {
+        unsigned char* retired;
+        unsigned char* current;
+        uint64_t       next_index;
+        bool           need_spare;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            retired    = m_retired;
+            current    = m_chunk;
+            next_index = m_chunk_index + 1;
+            need_spare = m_spare == nullptr;
+        }
+        // the disk work happens outside the lock, so the writer never waits on it
+        if (retired) {
+            m_file.flush(retired, m_chunk_size, false);
+            m_file.unmap(retired, m_chunk_size);
+        }
+        unsigned char* spare = need_spare ? prepare_chunk(next_index) : nullptr;
+        if (retired || spare) {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            if (retired) m_retired = nullptr;
+            if (spare) m_spare = spare;
+        }
+        if (steady_ns() - last_flush >= m_flush_interval_ns) {
+            m_file.flush(current, m_chunk_size, false);
+            last_flush = steady_ns();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+SessionReader::SessionReader() {}
+
+SessionReader::~SessionReader() { close(); }
+
+bool SessionReader::open(const std::string& filename_) {
+    close();
+    if (!m_file.open(filename_, MappedFile::Read)) return false;
+    SessionChunkHeader header;
+    unsigned char*     first = m_file.size() >= MappedFile::get_alignment() ? m_file.map(0, MappedFile::get_alignment()) : nullptr;
+    if (first) {
+        std::memcpy(&header, first, sizeof(header));
+        m_file.unmap(first, MappedFile::get_alignment());
+    }
+    if (!first || std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0 || header.version == 0 ||
+        header.version > SessionRecorder::VERSION ||
+        header.chunk_size % MappedFile::get_alignment() != 0 || header.chunk_size <= sizeof(SessionChunkHeader)) {
+        LOG(Error) << filename_ << " is not a session recording";
+        close();
+        return false;
+    }
+    m_chunk_size     = header.chunk_size;
+    m_origin_unix_ns = header.origin_unix_ns;
+    return rewind();
+}
+
+void SessionReader::close() {
+    m_file.unmap(m_chunk, m_chunk_size);
+    m_chunk = nullptr;
+    m_file.close();
+}
+
+bool SessionReader::next(SessionRecord& record_) {
+    while (m_chunk) {
+        if (m_pos + sizeof(SessionRecordHeader) <= m_committed) {
+            SessionRecordHeader header;
+            const unsigned char* record = m_chunk + sizeof(SessionChunkHeader) + m_pos;
+            std::memcpy(&header, record, sizeof(header));
+            if (m_pos + record_size(header.size) > m_committed) break;
+            record_.time_ns   = header.time_ns;
+            record_.direction = (FrameDirection)header.direction;
+            record_.port      = header.port;
+            record_.bytes     = record + sizeof(header);
+            record_.size      = header.size;
+            m_pos += record_size(header.size);
+            return true;
+        }
+        if (!load_chunk(m_chunk_index + 1)) break;
+    }
+    return false;
+}
+
+bool SessionReader::rewind() {
+    if (!m_file.is_open()) return false;
+    // a recording with no chunk at all is still a (empty) session
+    if (!load_chunk(0)) m_committed = 0;
+    return true;
+}
+
+int64_t SessionReader::get_origin_unix_ns() const { return m_origin_unix_ns; }
+
+bool SessionReader::load_chunk(uint64_t index) {
+    m_file.unmap(m_chunk, m_chunk_size);
+    m_chunk     = nullptr;
+    m_pos       = 0;
+    m_committed = 0;
+    if ((index + 1) * m_chunk_size > m_file.size()) return false;
+    m_chunk = m_file.map((size_t)index * m_chunk_size, m_chunk_size);
+    if (!m_chunk) return false;
+    SessionChunkHeader header;
+    std::memcpy(&header, m_chunk, sizeof(header));
+    // the spare chunk mapped ahead of a crashed recorder, or the zeros reserved past it, end the session
+    if (std::memcmp(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0 || header.index != index) {
+        m_file.unmap(m_chunk, m_chunk_size);
+        m_chunk = nullptr;
+        return false;
+    }
+    m_chunk_index = index;
+    m_committed   = header.committed < m_chunk_size - sizeof(SessionChunkHeader) ? header.committed : m_chunk_size - sizeof(SessionChunkHeader);
+    return true;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,102 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <Mahi/Fes/Utility/Thread.hpp>
+#include <Mahi/Util.hpp>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+namespace mahi {
+namespace fes {
+
+bool set_current_thread_affinity(int cpu) {
+    if (cpu < 0) {
+        LOG(Error) << "Cannot pin thread to negative cpu " << cpu;
+        return false;
+    }
+#if defined(_WIN32)
+    if (cpu >= (int)(sizeof(DWORD_PTR) * 8) || SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) == 0) {
+        LOG(Error) << "Failed to pin thread to cpu " << cpu;
+        return false;
+    }
+    return true;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+        LOG(Error) << "Failed to pin thread to cpu " << cpu;
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (result != 0) {
+        LOG(Error) << "Failed to pin thread to cpu " << cpu << " (" << std::strerror(result) << ")";
+        return false;
+    }
+    return true;
+#else
+    LOG(Warning) << "Thread affinity is not supported on this platform. Thread was not pinned to cpu " << cpu;
+    return false;
+#endif
+}
+
+bool set_current_thread_priority(ThreadPriority priority) {
+#ifdef _WIN32
+    int win_priority = THREAD_PRIORITY_NORMAL;
+    if (priority == ThreadPriority::High)
+        win_priority = THREAD_PRIORITY_HIGHEST;
+    else if (priority == ThreadPriority::Realtime)
+        win_priority = THREAD_PRIORITY_TIME_CRITICAL;
+    if (!SetThreadPriority(GetCurrentThread(), win_priority)) {
+        LOG(Error) << "Failed to set thread priority";
+        return false;
+    }
+    return true;
+#else
+    int         policy = SCHED_OTHER;
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    if (priority != ThreadPriority::Normal) {
+        // High sits in the middle of the FIFO range so that Realtime threads still preempt it
+        policy               = SCHED_FIFO;
+        int min              = sched_get_priority_min(SCHED_FIFO);
+        int max              = sched_get_priority_max(SCHED_FIFO);
+        param.sched_priority = priority == ThreadPriority::Realtime ? max : (min + max) / 2;
+    }
+    int result = pthread_setschedparam(pthread_self(), policy, &param);
+    if (result != 0) {
+        LOG(Error) << "Failed to set thread priority (" << std::strerror(result) << ")";
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool apply_current_thread_settings(const ThreadSettings& settings) {
+    bool success = true;
+    if (settings.cpu >= 0 && !set_current_thread_affinity(settings.cpu)) success = false;
+    if (!set_current_thread_priority(settings.priority)) success = false;
+    return success;
+}
+
+}  // namespace fes
+}  // namespace mahi
@@ -0,0 +1,208 @@
+// MIT License
+//
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Nathan Dunkelberger (nbd2@rice.edu)
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <Mahi/Fes/Utility/AsyncLog.hpp>
+#include <Mahi/Fes/Utility/UdpFeedback.hpp>
+#include <Mahi/Util.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace mahi {
+namespace fes {
+
+namespace {
+// logs a failed receive, unless it only means nothing was waiting
+void report_error(int error) {
+    if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR) return;
+    LOG_ASYNC(Error) << "Could not receive feedback: " << std::strerror(error);
+}
+
+// reads size bytes at data as an unsigned integer in the given byte order
+uint64_t read_uint(const unsigned char* data, size_t size, bool big_endian) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < size; i++) {
+        bits = (bits << 8) | data[big_endian ? i : size - 1 - i];
+    }
+    return bits;
+}
+}  // namespace
+
+SampleDecoder::SampleDecoder(SampleEncoding encoding_, size_t offset_) : m_encoding(encoding_), m_offset(offset_) {}
+
+size_t SampleDecoder::get_size() const {
+    bool wide = m_encoding == SampleEncoding::Float64BigEndian || m_encoding == SampleEncoding::Float64LittleEndian;
+    return m_offset + (wide ? 8 : 4);
+}
+
+bool SampleDecoder::decode(const unsigned char* data_, size_t size_, double& value_) const {
+    if (size_ < get_size()) return false;
+    const unsigned char* data = data_ + m_offset;
+    switch (m_encoding) {
+        case SampleEncoding::Float64BigEndian:
+        case SampleEncoding::Float64LittleEndian: {
+            uint64_t bits = read_uint(data, 8, m_encoding == SampleEncoding::Float64BigEndian);
+            double   value;
+            std::memcpy(&value, &bits, sizeof(value));
+            value_ = value;
+            break;
+        }
+        case SampleEncoding::Float32BigEndian:
+        case SampleEncoding::Float32LittleEndian: {
+            uint32_t bits = (uint32_t)read_uint(data, 4, m_encoding == SampleEncoding::Float32BigEndian);
+            float    value;
+            std::memcpy(&value, &bits, sizeof(value));
+            value_ = value;
+            break;
+        }
+    }
+    return std::isfinite(value_);
+}
+
+UdpFeedback::UdpFeedback(const SampleDecoder& decoder_) :
+    m_decoder(decoder_),
+    m_socket(-1),
+    m_port(0),
+    m_has_sample(false),
+    m_received(0),
+    m_malformed(0),
+    m_superseded(0) {}
+
+UdpFeedback::~UdpFeedback() { close(); }
+
+bool UdpFeedback::open(unsigned short port_, const std::string& address_) {
+    close();
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port   = htons(port_);
+    if (inet_pton(AF_INET, address_.c_str(), &local.sin_addr) != 1) {
+        LOG(Error) << "Could not parse feedback address " << address_;
+        return false;
+    }
+    m_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_socket < 0) {
+        LOG(Error) << "Could not create feedback socket: " << std::strerror(errno);
+        return false;
+    }
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        LOG(Error) << "Could not bind feedback socket to " << address_ << ":" << port_ << ": " << std::strerror(errno);
+        close();
+        return false;
+    }
+    socklen_t length = sizeof(local);
+    getsockname(m_socket, reinterpret_cast<sockaddr*>(&local), &length);
+    m_port       = ntohs(local.sin_port);
+    m_has_sample = false;
+    m_latest     = FeedbackSample();
+    m_received   = 0;
+    m_malformed  = 0;
+    m_superseded = 0;
+    return true;
+}
+
+void UdpFeedback::close() {
+    if (m_socket >= 0) ::close(m_socket);
+    m_socket = -1;
+    m_port   = 0;
+}
+
+bool UdpFeedback::is_open() const { return m_socket >= 0; }
+
+unsigned short UdpFeedback::get_port() const { return m_port; }
+
+void UdpFeedback::set_decoder(const SampleDecoder& decoder_) { m_decoder = decoder_; }
+
+bool UdpFeedback::accept(const unsigned char* data, size_t size, int64_t time_ns) {
+    m_received++;
+    double value;
+    if (!m_decoder.decode(data, size, value)) {
+        m_malformed++;
+        return false;
+    }
+    m_latest.value    = value;
+    m_latest.time_ns  = time_ns;
+    m_latest.sequence = m_received - m_malformed;
+    m_has_sample      = true;
+    return true;
+}
+
+size_t UdpFeedback::poll() {
+    if (m_socket < 0) return 0;
+    size_t total = 0;
+    size_t valid = 0;
+    while (true) {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+#ifdef __linux__
+        // one system call takes a whole batch
+        mmsghdr messages[BATCH_SIZE];
+        iovec   vectors[BATCH_SIZE];
+        std::memset(messages, 0, sizeof(messages));
+        for (size_t i = 0; i < BATCH_SIZE; i++) {
+            vectors[i].iov_base             = &m_buffers[i][0];
+            vectors[i].iov_len              = DATAGRAM_SIZE;
+            messages[i].msg_hdr.msg_iov    = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        int count = recvmmsg(m_socket, messages, BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (count < 0) report_error(errno);
+        if (count <= 0) break;
+        for (int i = 0; i < count; i++) {
+            if (accept(&m_buffers[i][0], messages[i].msg_len, now)) valid++;
+        }
+#else
+        int count = 0;
+        while (count < (int)BATCH_SIZE) {
+            ssize_t size = ::recv(m_socket, &m_buffers[0][0], DATAGRAM_SIZE, MSG_DONTWAIT);
+            if (size < 0) {
+                report_error(errno);
+                break;
+            }
+            if (accept(&m_buffers[0][0], (size_t)size, now)) valid++;
+            count++;
+        }
+        if (count == 0) break;
+#endif
+        total += count;
+        if (count < (int)BATCH_SIZE) break;
+    }
+    if (valid > 1) m_superseded += valid - 1;
+    return total;
+}
+
+bool UdpFeedback::get_latest(FeedbackSample& sample_) const {
+    if (!m_has_sample) return false;
+    sample_ = m_latest;
+    return true;
+}
+
+uint64_t UdpFeedback::get_received_count() const { return m_received; }
+
+uint64_t UdpFeedback::get_malformed_count() const { return m_malformed; }
+
+uint64_t UdpFeedback::get_superseded_count() const { return m_superseded; }
+
+}  // namespace fes
+}  // namespace mahi
@@ -14,20 +14,19 @@
 //
 // Author(s): Nathan Dunkelberger (nbd2@rice.edu)
 
+#include <Mahi/Fes/Utility/Utility.hpp>
 #include <Mahi/Util.hpp>
 #include <vector>
 
-#include "Windows.h"
-
 using namespace mahi::util;
 
 namespace mahi {
 namespace fes {
 
 std::string print_as_hex(unsigned char num){
-    char char_buff[20];
-    sprintf(char_buff, "0x%02X", (unsigned int)num);
-    return std::string(char_buff);
+    static const char digits[] = "0123456789ABCDEF";
+    const char        hex[]    = {'0', 'x', digits[num >> 4], digits[num & 0x0F]};
+    return std::string(hex, sizeof(hex));
 }
 
 std::vector<unsigned char> int_to_twobytes(int input_int) {
@@ -47,15 +46,21 @@ std::vector<unsigned char> int_to_twobytes(int input_int) {
     return char_vec_out;
 }
 
-void print_message(std::vector<unsigned char> message) {
+void print_message(const unsigned char* bytes, size_t size) {
+    // printed straight away so it stays in order with the LOG lines around it. Real-time paths post
+    // their frames to the AsyncLog instead
     std::cout << "Message: ";
-    for (size_t i = 0; i < message.size(); i++) {
-        std::cout << print_as_hex(message[i]);
-        if (i != message.size()) {
+    for (size_t i = 0; i < size; i++) {
+        std::cout << print_as_hex(bytes[i]);
+        if (i + 1 != size) {
             std::cout << ", ";
         }
     }
     std::cout << std::endl;
 }
+
+void print_message(std::vector<unsigned char> message) {
+    print_message(message.empty() ? nullptr : &message[0], message.size());
+}
 }  // namespace fes
 }  // namespace mahi
\ No newline at end of file
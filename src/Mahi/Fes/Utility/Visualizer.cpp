@@ -27,10 +27,10 @@ namespace fes {
 Visualizer::Visualizer(Stimulator* stimulator_) :
     Application(500,500,"Visualizer"),
     m_stimulator(stimulator_),
-    m_amp(m_stimulator->amplitudes),
-    m_pw(m_stimulator->pulsewidths),
-    m_max_amp(m_stimulator->max_amplitudes),
-    m_max_pw(m_stimulator->max_pulsewidths),
+    m_amp(m_stimulator->num_events, 0),
+    m_pw(m_stimulator->num_events, 0),
+    m_max_amp(m_stimulator->num_events, 0),
+    m_max_pw(m_stimulator->num_events, 0),
     m_num_channels(m_stimulator->num_events),
     m_channels(m_stimulator->get_channels()) {
     // initialize theme
@@ -49,11 +49,15 @@ Visualizer::~Visualizer() {}
 
 void Visualizer::update() {
     {
+        // the snapshot never blocks the thread sending updates, so the gui cannot stall stimulation
         std::lock_guard<std::mutex> lock(m_mtx);
-        m_amp     = m_stimulator->amplitudes;
-        m_pw      = m_stimulator->pulsewidths;
-        m_max_amp = m_stimulator->max_amplitudes;
-        m_max_pw  = m_stimulator->max_pulsewidths;
+        m_stimulator->get_snapshot(m_snapshot);
+        for (size_t i = 0; i < m_num_channels; i++) {
+            m_amp[i]     = (int)m_snapshot[i].amplitude;
+            m_pw[i]      = (int)m_snapshot[i].pulsewidth;
+            m_max_amp[i] = (int)m_snapshot[i].max_amplitude;
+            m_max_pw[i]  = (int)m_snapshot[i].max_pulse_width;
+        }
     }
 
     ImGui::Begin("FES Stim", &m_open);
@@ -170,14 +174,11 @@ void Visualizer::update() {
         std::lock_guard<std::mutex> lock(m_mtx);
         for (size_t i = 0; i < m_num_channels; i++) {
             if (m_enabled[i]) {
-                m_stimulator->set_amp(m_channels[i], m_amp[i]);
-                m_stimulator->write_pw(m_channels[i], m_pw[i]);
+                // limits first, so the new values are checked against them
                 m_stimulator->update_max_amp(m_channels[i], m_max_amp[i]);
                 m_stimulator->update_max_pw(m_channels[i], m_max_pw[i]);
-                m_stimulator->amplitudes[i]      = m_amp[i];
-                m_stimulator->pulsewidths[i]     = m_pw[i];
-                m_stimulator->max_amplitudes[i]  = m_max_amp[i];
-                m_stimulator->max_pulsewidths[i] = m_max_pw[i];
+                m_stimulator->set_amp(m_channels[i], m_amp[i]);
+                m_stimulator->write_pw(m_channels[i], m_pw[i]);
             }
         }
     }